@@ -122,6 +122,7 @@ public:
     bool showTilesetEditorRawAttributes;
     bool showPaletteEditorUnusedColors;
     bool monitorFiles;
+    int eventSpriteCacheSize; // In MB
     bool tilesetCheckerboardFill;
     bool newMapHeaderSectionExpanded;
     QString theme;
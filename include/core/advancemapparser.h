@@ -11,7 +11,7 @@ class Metatile;
 
 namespace AdvanceMapParser {
     Layout *parseLayout(const QString &filepath, bool *error, const Project *project);
-    QList<Metatile*> parseMetatiles(const QString &filepath, bool *error, bool primaryTileset);
+    QList<Metatile> parseMetatiles(const QString &filepath, bool *error, bool primaryTileset);
     QList<QRgb> parsePalette(const QString &filepath, bool *error);
 };
 
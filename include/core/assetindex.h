@@ -0,0 +1,61 @@
+#ifndef ASSETINDEX_H
+#define ASSETINDEX_H
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <future>
+#include <memory>
+
+// An index of every file under a directory (normally the project's graphics/ folder), built with a single directory walk in the background.
+// Checking whether an asset exists then doesn't need to touch the filesystem. This matters for projects with thousands of species,
+// where finding the icons can mean checking many candidate paths for each species.
+// Lookups can be made from any thread. They may update the index (see 'find'), so they're serialized with each other.
+class AssetIndex
+{
+public:
+    AssetIndex() = default;
+    ~AssetIndex();
+
+    AssetIndex(const AssetIndex &) = delete;
+    AssetIndex & operator = (const AssetIndex &) = delete;
+
+    // Starts indexing 'dir'. Lookups made before the directory walk finishes will wait for it.
+    void build(const QString &dir);
+    void clear();
+
+    // Returns 'filepath' if it's an indexed file, or an empty string if there isn't one. The name must match exactly (including case),
+    // the same as the game's build would require on a case-sensitive filesystem.
+    // Paths outside the indexed directory are checked on the filesystem instead.
+    // If there's no match, the file's directory is read again (at most once every few seconds) in case the file was added since it was indexed.
+    QString find(const QString &filepath) const;
+
+    // Like 'find', but if there's no exact match it falls back to ignoring case and the differences between directory separators,
+    // underscores, and camel case. Ex: 'pokemon/foo_bar/icon.png', 'pokemon/foo/bar/icon.png', and 'pokemon/FooBar/icon.png' all match each other.
+    // This can pick the wrong file, so a warning is logged whenever the fallback is used.
+    QString findFuzzy(const QString &filepath) const;
+
+    static QString toSnakeCase(const QString &name);
+
+private:
+    struct Data {
+        QSet<QString> names;
+        QHash<QString, QString> pathsBySnakeCaseName;
+        qint64 scanTime = 0;
+        QHash<QString, qint64> dirCheckTimes; // When each directory (relative to the indexed directory) was last read again
+    };
+    QString m_dir;
+    std::shared_future<std::shared_ptr<Data>> m_data;
+    mutable QMutex m_mutex; // Guards the members above, and the contents of the index once it's been built.
+
+    static std::shared_ptr<Data> scan(const QString &dir);
+    static void addFile(Data *data, const QString &dir, const QString &filepath);
+    Data *data() const;
+    QString findLocked(const QString &filepath) const;
+    QString relativePath(const QString &filepath) const;
+    QString findIndexed(const Data *index, const QString &name) const;
+    bool rescanDirectory(Data *index, const QString &name) const;
+};
+
+#endif // ASSETINDEX_H
@@ -22,6 +22,10 @@ private:
     uint32_t m_mask = 0;
     uint32_t m_maxValue = 0;
     QList<uint32_t> m_setBits;
+
+    // For masks with only contiguous bits we can skip iterating over m_setBits.
+    bool m_isContiguous = true;
+    int m_shift = 0;
 };
 
 #endif // BITPACKER_H
@@ -0,0 +1,79 @@
+#ifndef CONSTANTSMODEL_H
+#define CONSTANTSMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QPointer>
+#include <QHash>
+#include <QVector>
+
+// A read-only list of project constants (e.g. flag names) that can be shared by any number of combo boxes,
+// rather than each combo box keeping its own copy of what can be thousands of strings.
+//
+// The model also keeps indices of its strings, so that looking up a constant (e.g. by QComboBox::findText)
+// and searching for constants while the user types don't need to compare against every string.
+class ConstantsModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit ConstantsModel(QObject *parent = nullptr) : QAbstractListModel(parent) {}
+
+    void setStrings(const QStringList &strings);
+    // Like 'setStrings', but each string also has a value (e.g. the value of a #define), available with Qt::UserRole.
+    void setItems(const QStringList &strings, const QList<QVariant> &values);
+    const QStringList &strings() const { return m_strings; }
+
+    // Returns the row of the given string, or -1 if it isn't in the model.
+    int indexOf(const QString &string) const;
+
+    enum class MatchType {
+        Prefix,   // Strings that start with the query
+        Contains, // Strings that contain the query (excluding prefix matches)
+        Fuzzy,    // Strings that contain the query's characters in order (excluding the above matches)
+    };
+    // Returns up to 'limit' strings that match 'query', ignoring case.
+    QStringList find(const QString &query, MatchType type, int limit) const;
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    virtual QModelIndexList match(const QModelIndex &start, int role, const QVariant &value, int hits = 1,
+                                  Qt::MatchFlags flags = Qt::MatchFlags(Qt::MatchStartsWith | Qt::MatchWrap)) const override;
+
+private:
+    QStringList m_strings;
+    QList<QVariant> m_values;
+
+    // Indices are built when they're first needed, and discarded whenever the strings change.
+    mutable QHash<QString, int> m_rowsByString;
+    mutable QVector<QString> m_foldedStrings;
+    mutable QVector<int> m_sortedRows; // Rows sorted by their folded string, for prefix searches.
+
+    bool insertNewStrings(const QStringList &strings);
+    bool removeOldStrings(const QStringList &strings);
+    void invalidateIndices();
+    void buildSearchIndex() const;
+};
+
+// Presents the results of searching one or more ConstantsModels, for use as the model of a QCompleter.
+// Prefix matches are listed first, followed by strings that contain the search text, then fuzzy matches.
+class ConstantsSearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit ConstantsSearchModel(QObject *parent = nullptr) : QAbstractListModel(parent) {}
+
+    void setSources(const QList<ConstantsModel*> &sources);
+    void setQuery(const QString &query);
+
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    QList<QPointer<ConstantsModel>> m_sources;
+    QString m_query;
+    QStringList m_results;
+
+    void updateResults();
+};
+
+#endif // CONSTANTSMODEL_H
@@ -11,6 +11,7 @@
 
 #include "orderedjson.h"
 #include "parseutil.h"
+#include "eventspriteatlas.h"
 
 
 class Project;
@@ -149,6 +150,9 @@ public:
     void setPixmap(QPixmap newPixmap) { this->pixmap = newPixmap; }
     QPixmap getPixmap() const { return this->pixmap; }
 
+    // The key for this event's sprite in the project's event sprite atlas, or 0 if it doesn't use one.
+    EventSpriteAtlas::Key getSpriteKey() const { return this->spriteKey; }
+
     void setPixmapItem(EventPixmapItem *item);
     EventPixmapItem *getPixmapItem() const { return this->pixmapItem; }
 
@@ -190,6 +194,7 @@ protected:
     QJsonObject customAttributes;
 
     QPixmap pixmap;
+    EventSpriteAtlas::Key spriteKey = 0;
     EventPixmapItem *pixmapItem = nullptr;
 
     QPointer<EventFrame> eventFrame;
@@ -0,0 +1,105 @@
+#ifndef EVENTSPRITEATLAS_H
+#define EVENTSPRITEATLAS_H
+
+#include <QPixmap>
+#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+#include <memory>
+#include <vector>
+
+// Holds the frames of event sprites, packed together into a few large pixmaps ("pages") rather than one small pixmap per frame.
+// Frames are looked up by an integer key made from the sprite's graphics ID, frame index, and whether it's flipped,
+// and pages that haven't been used recently are discarded once the atlas grows beyond its memory budget.
+//
+// The atlas also decodes the spritesheets that frames are cut from, which can be started in the background
+// after the project is loaded so that opening a map with many events doesn't need to read each spritesheet from disk.
+// Decoded spritesheets waiting to be used count against the same memory budget, and preloading stops once it's reached.
+class EventSpriteAtlas
+{
+public:
+    using Key = quint64;
+
+    // Returns 0 (an invalid key) if 'gfxId' is negative.
+    static Key makeKey(int gfxId, int frame, bool hFlip);
+
+    // A frame's location in the atlas. 'page' is only valid until the next frame is inserted (or the atlas is cleared).
+    struct Sprite {
+        const QPixmap *page = nullptr;
+        QRect rect;
+        bool isNull() const { return !page; }
+    };
+
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        int numPages = 0;
+        int numSprites = 0;
+        qint64 bytes = 0;
+        qint64 preloadedBytes = 0;
+    };
+
+    explicit EventSpriteAtlas(qint64 maxBytes = 32 * 1024 * 1024);
+    ~EventSpriteAtlas();
+
+    EventSpriteAtlas(const EventSpriteAtlas &) = delete;
+    EventSpriteAtlas & operator = (const EventSpriteAtlas &) = delete;
+
+    // Looks up a frame. Lookups made while painting should pass 'countLookup' as false, so that the stats
+    // reflect how often sprites are reused rather than how often they're repainted.
+    bool find(Key key, Sprite *sprite, bool countLookup = true);
+    Sprite insert(Key key, const QImage &image);
+    QPixmap pixmap(Key key);
+    void clear();
+
+    void setMaxBytes(qint64 maxBytes);
+    qint64 maxBytes() const { return m_maxBytes; }
+    Stats stats() const;
+
+    // Starts decoding the given spritesheets in the background.
+    void preload(const QStringList &filepaths);
+    // Returns the spritesheet if it finished preloading, otherwise returns a null image. Either way, the spritesheet won't be preloaded after this.
+    QImage takeSpritesheet(const QString &filepath);
+
+private:
+    static constexpr int PageSize = 512;
+
+    struct Page {
+        QPixmap pixmap;
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfHeight = 0;
+        quint64 lastUsed = 0;
+        QList<Key> keys;
+    };
+    struct Entry {
+        Page *page = nullptr;
+        QRect rect;
+    };
+
+    std::vector<std::unique_ptr<Page>> m_pages;
+    QHash<Key, Entry> m_entries;
+    QHash<Key, QPixmap> m_pixmaps;
+    qint64 m_maxBytes;
+    qint64 m_bytes = 0;
+    quint64 m_useCount = 0;
+    Stats m_stats;
+
+    QThreadPool m_loadPool;
+    mutable QMutex m_loadMutex;
+    QHash<QString, QImage> m_loadedSpritesheets;
+    QSet<QString> m_claimedSpritesheets;
+    qint64 m_loadedBytes = 0;
+    qint64 m_maxLoadedBytes;
+
+    class LoadTask;
+
+    Page *allocate(const QSize &size, QPoint *pos);
+    void evict(const Page *keep);
+    static qint64 pageBytes(const Page &page);
+};
+
+#endif // EVENTSPRITEATLAS_H
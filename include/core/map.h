@@ -13,7 +13,7 @@
 #include <QPixmap>
 #include <QObject>
 #include <QGraphicsPixmapItem>
-#include <QFileSystemWatcher>
+#include <QPointer>
 #include <math.h>
 
 #define DEFAULT_BORDER_WIDTH 2
@@ -26,6 +26,7 @@
 class LayoutPixmapItem;
 class CollisionPixmapItem;
 class BorderMetatilesPixmapItem;
+class ScriptLabelIndex;
 
 class Map : public QObject
 {
@@ -104,7 +105,8 @@ public:
     void addConnection(MapConnection *);
     void loadConnection(MapConnection *);
     QRect getConnectionRect(const QString &direction, Layout *fromLayout = nullptr) const;
-    QPixmap renderConnection(const QString &direction, Layout *fromLayout = nullptr);
+    QPixmap renderConnection(const QString &direction, Layout *fromLayout = nullptr, bool ignoreCache = false);
+    static void invalidateConnectionRenders() { s_connectionRenderGeneration++; }
 
     QUndoStack* editHistory() const { return m_editHistory; }
     void commit(QUndoCommand*);
@@ -119,6 +121,9 @@ public:
     static void setFileWatchingEnabled(bool enabled) { m_fileWatchingEnabled = enabled; }
     static bool isFileWatchingEnabled() { return m_fileWatchingEnabled; }
 
+    // Script labels are read from (and kept up-to-date by) the project's index when one is set, so maps share one copy and one file watcher.
+    void setScriptLabelIndex(ScriptLabelIndex *index) { m_scriptLabelIndex = index; }
+
 private:
     QString m_name;
     QString m_constantName;
@@ -138,18 +143,35 @@ private:
     bool m_scriptsLoaded = false;
     bool m_loggedScriptsFileError = false;
     static bool m_fileWatchingEnabled;
+    QPointer<ScriptLabelIndex> m_scriptLabelIndex;
 
     QMap<Event::Group, QList<Event *>> m_events;
     QSet<Event *> m_ownedEvents; // for memory management
 
     void trackConnection(MapConnection*);
+    void onScriptsFileChanged(const QString &filepath);
 
     // MapConnections in 'ownedConnections' but not 'connections' persist in the edit history.
     QList<MapConnection*> m_connections;
     QSet<MapConnection*> m_ownedConnections;
 
     QPointer<QUndoStack> m_editHistory;
-    QPointer<QFileSystemWatcher> m_scriptFileWatcher;
+
+    // The most recent render of this map as a connection, for each direction. Rendering with different tilesets replaces it.
+    struct ConnectionRender {
+        QRect bounds;
+        const Layout *layout = nullptr;
+        const Tileset *primaryTileset = nullptr;
+        const Tileset *secondaryTileset = nullptr;
+        QList<int> layerOrder;
+        QList<float> layerOpacity;
+        quint64 generation = 0;
+        QVector<uint16_t> metatileIds;
+        QImage image;
+        QPixmap pixmap;
+    };
+    QHash<QString, ConnectionRender> m_connectionRenders;
+    static quint64 s_connectionRenderGeneration;
 
 signals:
     void modified();
@@ -41,7 +41,7 @@ public:
     MapConnection* findMirror();
     MapConnection* createMirror();
 
-    QPixmap render() const;
+    QPixmap render(bool ignoreCache = false) const;
     QImage renderImage() const;
     QPoint relativePixelPos(bool clipped = false) const;
 
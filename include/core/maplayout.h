@@ -4,15 +4,19 @@
 
 #include "blockdata.h"
 #include "tileset.h"
+#include <QBitArray>
 #include <QImage>
 #include <QPixmap>
 #include <QString>
 #include <QUndoStack>
+#include <memory>
 
 class Map;
 class LayoutPixmapItem;
 class CollisionPixmapItem;
 class BorderMetatilesPixmapItem;
+class SavePlan;
+class CollisionAtlas;
 
 class Layout : public QObject {
     Q_OBJECT
@@ -50,11 +54,12 @@ public:
     Blockdata blockdata;
 
     QImage image;
-    QPixmap pixmap;
+    QBitArray pendingImageBlocks; // Blocks that changed but haven't been drawn to 'image' yet
+    int numPendingImageBlocks = 0;
     QImage border_image;
     QPixmap border_pixmap;
     QImage collision_image;
-    QPixmap collision_pixmap;
+    std::shared_ptr<const CollisionAtlas> collision_atlas; // The atlas that 'collision_image' was last rendered with
 
     Blockdata border;
     Blockdata cached_blockdata;
@@ -144,9 +149,7 @@ public:
 
     bool hasUnsavedChanges() const;
 
-    bool save(const QString &root);
-    bool saveBorder(const QString &root);
-    bool saveBlockdata(const QString &root);
+    bool save(const QString &root, SavePlan *plan = nullptr);
 
     bool loadBorder(const QString &root);
     bool loadBlockdata(const QString &root);
@@ -162,11 +165,15 @@ public:
     void magicFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation);
 
     QPixmap render(bool ignoreCache = false, Layout *fromLayout = nullptr, const QRect &bounds = QRect(0, 0, -1, -1));
-    QPixmap renderCollision(bool ignoreCache);
+    QRect renderImage(bool ignoreCache = false, Layout *fromLayout = nullptr, const QRect &bounds = QRect(0, 0, -1, -1));
+    QRect invalidateImage(bool ignoreCache = false);
+    void renderPendingImageBlocks(const QRect &bounds, Layout *fromLayout = nullptr);
+    QImage renderThumbnail(const QSize &maxSize) const;
+    QRect renderCollisionImage(bool ignoreCache = false, qreal opacity = 1.0);
+    QRect renderArea(QImage *areaImage, const QRect &bounds, QVector<uint16_t> *cachedMetatileIds,
+                     const Tileset *primaryTileset, const Tileset *secondaryTileset) const;
     QPixmap renderBorder(bool ignoreCache = false);
 
-    QPixmap getLayoutItemPixmap();
-
     void setLayoutItem(LayoutPixmapItem *item) { layoutItem = item; }
     void setCollisionItem(CollisionPixmapItem *item) { collisionItem = item; }
     void setBorderItem(BorderMetatilesPixmapItem *item) { borderItem = item; }
@@ -176,7 +183,6 @@ public:
 private:
     void setNewDimensionsBlockdata(int newWidth, int newHeight);
     void setNewBorderDimensionsBlockdata(int newWidth, int newHeight);
-    bool writeBlockdata(const QString &path, const Blockdata &blockdata) const;
     static Blockdata readBlockdata(const QString &path, QString *error);
 
     static int getBorderDrawDistance(int dimension, qreal minimum);
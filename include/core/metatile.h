@@ -8,9 +8,58 @@
 #include <QImage>
 #include <QPoint>
 #include <QString>
+#include <algorithm>
 
 class Project;
 
+// Fixed-capacity tile storage for a single metatile.
+// Metatiles are stored contiguously by their tileset, so rather than each metatile owning a heap-allocated
+// list of tiles we keep the (at most 3 layers of 2x2) packed tiles inline. Mirrors the parts of the QList API
+// that are used for metatile tiles.
+class MetatileTiles
+{
+public:
+    static constexpr int capacity() { return 12; }
+
+    int length() const { return m_length; }
+    int size() const { return m_length; }
+    bool isEmpty() const { return m_length == 0; }
+
+    void append(const Tile &tile) {
+        if (m_length < capacity()) {
+            m_tiles[m_length++] = tile;
+        } else {
+            reportOverflow();
+        }
+    }
+    void clear() { m_length = 0; }
+
+    const Tile &at(int i) const { return m_tiles[i]; }
+    Tile &operator[](int i) { return m_tiles[i]; }
+    const Tile &operator[](int i) const { return m_tiles[i]; }
+    Tile value(int i) const { return (i >= 0 && i < m_length) ? m_tiles[i] : Tile(); }
+
+    Tile *begin() { return m_tiles; }
+    Tile *end() { return m_tiles + m_length; }
+    const Tile *begin() const { return m_tiles; }
+    const Tile *end() const { return m_tiles + m_length; }
+
+    inline bool operator==(const MetatileTiles &other) const {
+        return m_length == other.m_length && std::equal(begin(), end(), other.begin());
+    }
+
+    inline bool operator!=(const MetatileTiles &other) const {
+        return !(operator==(other));
+    }
+
+private:
+    // Appending beyond the capacity drops the tile. That's a bug in the caller, so it's reported rather than ignored.
+    static void reportOverflow();
+
+    Tile m_tiles[capacity()];
+    uint8_t m_length = 0;
+};
+
 
 class Metatile
 {
@@ -36,10 +85,10 @@ public:
     };
 
 public:
-    QList<Tile> tiles;
+    MetatileTiles tiles;
 
-    uint32_t getAttributes() const;
-    uint32_t getAttribute(Metatile::Attr attr) const { return this->attributes.value(attr, 0); }
+    uint32_t getAttributes() const { return m_attributes; }
+    uint32_t getAttribute(Metatile::Attr attr) const;
     void setAttributes(uint32_t data);
     void setAttributes(uint32_t data, BaseGameVersion version);
     void setAttribute(Metatile::Attr attr, uint32_t value);
@@ -71,16 +120,17 @@ public:
     static constexpr int pixelHeight() { return Metatile::tileHeight() * Tile::pixelHeight(); }
     static constexpr QSize pixelSize() { return QSize(pixelWidth(), pixelHeight()); }
 
-    inline bool operator==(const Metatile &other) {
-        return this->tiles == other.tiles && this->attributes == other.attributes;
+    inline bool operator==(const Metatile &other) const {
+        return this->tiles == other.tiles && m_attributes == other.m_attributes;
     }
 
-    inline bool operator!=(const Metatile &other) {
+    inline bool operator!=(const Metatile &other) const {
         return !(operator==(other));
     }
 
 private:
-    QMap<Metatile::Attr, uint32_t> attributes;
+    // All attributes, packed according to the project's attribute masks.
+    uint32_t m_attributes = 0;
 };
 
 #endif // METATILE_H
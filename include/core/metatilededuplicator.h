@@ -0,0 +1,28 @@
+#ifndef METATILEDEDUPLICATOR_H
+#define METATILEDEDUPLICATOR_H
+
+#include <QMap>
+#include <QSet>
+
+class Tileset;
+
+// Finds metatiles in a primary and secondary tileset that are identical (the same tiles and attributes) to another metatile,
+// so that layouts can use a single copy of each and the duplicates' IDs can be used for something else.
+class MetatileDeduplicator
+{
+public:
+    struct Options {
+        // Whether secondary metatiles may be replaced by an identical primary metatile. This is only safe if
+        // the secondary tileset is never paired with a different primary tileset.
+        bool mergeSecondaryIntoPrimary = true;
+        // Metatiles that are referred to by their ID outside of layouts (e.g. by a metatile label). These are never replaced.
+        QSet<uint16_t> pinnedMetatileIds;
+    };
+
+    // Returns the ID of each duplicate metatile, mapped to the ID of the metatile that should replace it.
+    // Each set of duplicates is replaced by its first metatile, preferring primary metatiles.
+    // Empty metatiles (which are usually just unused) are ignored.
+    static QMap<uint16_t, uint16_t> findDuplicates(const Tileset *primaryTileset, const Tileset *secondaryTileset, const Options &options);
+};
+
+#endif // METATILEDEDUPLICATOR_H
@@ -10,6 +10,7 @@
 #include <QList>
 #include <QMap>
 #include <QRegularExpression>
+#include <atomic>
 
 
 
@@ -48,8 +49,18 @@ public:
     void setUpdatesSplashScreen(bool updates) { this->updatesSplashScreen = updates; }
 
     static QString readTextFile(const QString &path, QString *error = nullptr);
+    static QString decodeText(const char *data, qint64 size);
     QString loadTextFile(const QString &path, QString *error = nullptr);
 
+    // Totals for every text file read by 'readTextFile', to measure how much of the project load time is spent reading files.
+    struct ReadStats {
+        int numFiles = 0;
+        qint64 numBytes = 0;
+        qint64 nsecs = 0;
+    };
+    static ReadStats readStats();
+    static void resetReadStats();
+
     bool cacheFile(const QString &path, QString *error = nullptr);
     void clearFileCache() { this->fileCache.clear(); }
     static int textFileLineCount(const QString &path);
@@ -102,6 +113,10 @@ private:
     QHash<QString, QString> fileCache;
     QHash<QString, QStringList> errorMap;
 
+    static std::atomic<int> s_numFilesRead;
+    static std::atomic<qint64> s_numBytesRead;
+    static std::atomic<qint64> s_readNsecs;
+
     // The maps of define names to values/expressions that are available while parsing C defines.
     // As the parser reads and evaluates more defines it will update these maps accordingly.
     QHash<QString, int> knownDefineValues;
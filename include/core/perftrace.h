@@ -0,0 +1,95 @@
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QString>
+#include <QList>
+#include <atomic>
+#include <utility>
+
+// Records how long porymap spends in its slower operations (loading, rendering, exporting, running scripts),
+// so that the time can be inspected in the Performance Trace panel or exported for chrome://tracing / Perfetto.
+// Tracing is off by default. While it's off, a traced scope costs one atomic load and nothing is recorded
+// (the arguments to PERF_TRACE aren't evaluated either).
+//
+// Usage:
+//     PERF_TRACE("Tileset::load");                 // Times the rest of the enclosing scope
+//     PERF_TRACE("ParseUtil::readTextFile", path); // Same, with a detail shown in the exported trace
+//     PERF_COUNT("Files read", 1);                 // Adds to a running total
+class PerfTrace
+{
+public:
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static void clear();
+
+    // Nanoseconds on a monotonic clock.
+    static qint64 now();
+
+    // 'name' must outlive the trace (i.e. be a string literal).
+    static void addEvent(const char *name, const QString &detail, qint64 start, qint64 end);
+    static void addCount(const char *name, qint64 delta);
+
+    struct Summary {
+        QString name;
+        bool isCounter = false;
+        int count = 0;         // Number of times the scope ran, or the counter was changed
+        qint64 totalNsecs = 0; // Time spent in the scope (including time spent on other threads)
+        qint64 maxNsecs = 0;
+        qint64 value = 0;      // The counter's total
+    };
+    static QList<Summary> summary();
+
+    // The number of events that weren't kept for the exported trace because the trace was full.
+    // These are still included in the summary.
+    static int numDroppedEvents();
+
+    // Writes the recorded events in the Trace Event Format, which can be opened by chrome://tracing or https://ui.perfetto.dev
+    static bool exportChromeTrace(const QString &filepath, QString *error = nullptr);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+class PerfTraceScope
+{
+public:
+    explicit PerfTraceScope(const char *name)
+        : m_name(PerfTrace::isEnabled() ? name : nullptr),
+          m_start(m_name ? PerfTrace::now() : 0) {}
+    PerfTraceScope(const char *name, const QString &detail) : PerfTraceScope(name) {
+        if (m_name) m_detail = detail;
+    }
+
+    struct Args {
+        Args(const char *name, const QString &detail = QString()) : name(name), detail(detail) {}
+        const char *name;
+        QString detail;
+    };
+    // 'getArgs' returns the trace's Args, and is only called if tracing is enabled.
+    template <typename GetArgs, typename = decltype(std::declval<const GetArgs &>()())>
+    explicit PerfTraceScope(const GetArgs &getArgs) : m_name(nullptr), m_start(0) {
+        if (!PerfTrace::isEnabled()) return;
+        const Args args = getArgs();
+        m_name = args.name;
+        m_detail = args.detail;
+        m_start = PerfTrace::now();
+    }
+    ~PerfTraceScope() {
+        if (m_name) PerfTrace::addEvent(m_name, m_detail, m_start, PerfTrace::now());
+    }
+
+    PerfTraceScope(const PerfTraceScope &) = delete;
+    PerfTraceScope &operator=(const PerfTraceScope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_start;
+    QString m_detail;
+};
+
+#define PERF_TRACE_CONCAT_(a, b) a##b
+#define PERF_TRACE_CONCAT(a, b) PERF_TRACE_CONCAT_(a, b)
+#define PERF_TRACE(...) PerfTraceScope PERF_TRACE_CONCAT(perfTraceScope_, __LINE__)([&] { return PerfTraceScope::Args(__VA_ARGS__); })
+#define PERF_COUNT(name, delta) do { if (PerfTrace::isEnabled()) PerfTrace::addCount(name, delta); } while (0)
+
+#endif // PERFTRACE_H
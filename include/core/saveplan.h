@@ -0,0 +1,50 @@
+#ifndef SAVEPLAN_H
+#define SAVEPLAN_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QStringList>
+#include <functional>
+
+// Collects the files that need to be written for a save, then writes them all at once.
+// Files whose contents already match what's on disk aren't touched, so saving doesn't
+// needlessly update their timestamps (which would trigger rebuilds of the project).
+// The remaining files are written concurrently, and each is replaced atomically with QSaveFile,
+// so an interrupted save can't leave a half-written file behind.
+class SavePlan
+{
+public:
+    SavePlan() = default;
+
+    enum class Result {
+        Written,
+        Unchanged,
+        Failed,
+    };
+
+    // Queues 'data' to be written to 'path'. 'onSaved' is called after 'write' once all of the given files are up-to-date on disk.
+    void addFile(const QString &path, const QByteArray &data, const std::function<void()> &onSaved = nullptr);
+    void addFiles(const QList<QPair<QString, QByteArray>> &files, const std::function<void()> &onSaved = nullptr);
+
+    bool isEmpty() const { return m_files.isEmpty(); }
+
+    // Writes all the queued files, then clears the plan. Returns false if any file failed to write.
+    // If 'writtenPaths' is given, the paths of the files that were actually written (i.e. not unchanged) are added to it.
+    bool write(QStringList *writtenPaths = nullptr);
+
+    static Result writeFile(const QString &path, const QByteArray &data, QString *error = nullptr);
+
+private:
+    struct File {
+        QString path;
+        QByteArray data;
+        int group;
+        Result result = Result::Failed;
+        QString error;
+    };
+    QList<File> m_files;
+    QList<std::function<void()>> m_groupCallbacks;
+};
+
+#endif // SAVEPLAN_H
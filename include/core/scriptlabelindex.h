@@ -0,0 +1,89 @@
+#ifndef SCRIPTLABELINDEX_H
+#define SCRIPTLABELINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QPointer>
+#include <QFileSystemWatcher>
+
+// Keeps track of the global script labels defined in each of the project's script files.
+// Reading every script file in the project can be slow, so the files are scanned in the background
+// (and in parallel), and labels read in previous sessions are loaded from a cache file in the meantime.
+// Files are only re-read if their size or modification time has changed, or if the file watcher reports a change.
+class ScriptLabelIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScriptLabelIndex(QObject *parent = nullptr);
+    ~ScriptLabelIndex();
+
+    ScriptLabelIndex(const ScriptLabelIndex &) = delete;
+    ScriptLabelIndex & operator = (const ScriptLabelIndex &) = delete;
+
+    // Loads the labels saved by a previous session from the given cache file, and saves to that file after future scans.
+    void setCacheFilepath(const QString &filepath);
+    static QString cacheFilepathFor(const QString &projectRoot);
+
+    // Sets which files contribute to 'globalLabels', and starts scanning any of them that may be out-of-date.
+    void setGlobalFiles(const QStringList &filepaths);
+    QStringList globalLabels() const;
+    bool isScanning() const { return m_numPendingTasks > 0; }
+
+    // Returns the labels for a single file, reading it immediately if the index doesn't have an up-to-date copy.
+    QStringList fileLabels(const QString &filepath, QString *error = nullptr);
+
+    void setFileWatchingEnabled(bool enabled);
+
+signals:
+    // Emitted once the global labels may have changed, either because a scan finished or because a global file changed.
+    void globalLabelsChanged();
+    void fileChanged(const QString &filepath);
+
+private:
+    struct Entry {
+        qint64 modified = -1;
+        qint64 size = -1;
+        QStringList labels;
+        bool isGlobal = false;
+        bool isRequested = false;
+    };
+    struct ScanResult {
+        QString filepath;
+        qint64 modified = -1;
+        qint64 size = -1;
+        bool changed = false;
+        QStringList labels;
+    };
+    class ScanTask;
+
+    QHash<QString, Entry> m_entries;
+    QStringList m_globalFiles;
+    mutable QStringList m_globalLabels;
+    mutable bool m_globalLabelsDirty = true;
+    bool m_globalLabelsChanged = false;
+
+    QThreadPool m_threadPool;
+    int m_numPendingTasks = 0;
+    QSet<QString> m_scanning;
+    QSet<QString> m_needsRescan;
+
+    QString m_cacheFilepath;
+    bool m_cacheDirty = false;
+
+    bool m_fileWatchingEnabled = true;
+    bool m_loggedWatchError = false;
+    QSet<QString> m_watchedFiles;
+    QPointer<QFileSystemWatcher> m_fileWatcher;
+
+    void scan(const QStringList &filepaths);
+    void onScanFinished(const QList<ScanResult> &results);
+    void onFileChanged(const QString &filepath);
+    void watchFiles(const QStringList &filepaths);
+    bool loadCache();
+    bool saveCache();
+};
+
+#endif // SCRIPTLABELINDEX_H
@@ -26,6 +26,9 @@ public:
 
     static const uint16_t maxValue;
 
+    // Number of values representable by the tileId field.
+    static constexpr int numTileIds() { return 1 << 10; }
+
     static constexpr int pixelWidth() { return 8; }
     static constexpr int pixelHeight() { return 8; }
     static constexpr QSize pixelSize() { return QSize(Tile::pixelWidth(), Tile::pixelHeight()); }
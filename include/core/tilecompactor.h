@@ -0,0 +1,58 @@
+#ifndef TILECOMPACTOR_H
+#define TILECOMPACTOR_H
+
+#include "tile.h"
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QSet>
+
+class Tileset;
+class Metatile;
+
+// Finds the tiles of a primary and secondary tileset that are identical to another tile, either as-is or when flipped
+// horizontally and/or vertically. Applying the result removes those duplicates from the tiles images, moves the remaining
+// tiles down to fill the gaps, and updates every metatile of the two tilesets to use the remaining copy of each tile
+// (with whatever flips are needed to reproduce the removed tile).
+class TileCompactor
+{
+public:
+    struct Options {
+        // Whether tiles may be removed from (or moved within) each tileset. Tilesets whose tiles are used
+        // by metatiles outside of the pair shouldn't be compacted, because those metatiles won't be updated.
+        bool compactPrimary = true;
+        bool compactSecondary = true;
+        // Whether secondary tiles may be replaced by an identical primary tile. This is only safe if
+        // the secondary tileset is never paired with a different primary tileset.
+        bool mergeSecondaryIntoPrimary = true;
+        // Tiles that are referred to by their ID somewhere other than a metatile (e.g. the project's unused tile settings).
+        // These tiles (and any tiles before them in their tileset) keep their ID.
+        QSet<uint16_t> pinnedTileIds;
+    };
+
+    TileCompactor(const Tileset *primaryTileset, const Tileset *secondaryTileset, const Options &options);
+
+    int numReclaimedTiles(const Tileset *tileset) const;
+    int numReclaimedTiles() const { return m_numReclaimedPrimary + m_numReclaimedSecondary; }
+
+    // Returns the tile that should replace 'tile' once the duplicates are removed.
+    Tile remap(const Tile &tile) const;
+    void remap(Metatile *metatile) const;
+
+    // Removes the duplicate tiles from the given tilesets, which should be the tilesets the compactor was created with.
+    void apply(Tileset *primaryTileset, Tileset *secondaryTileset) const;
+
+private:
+    // The remaining tile (and the flips needed to reproduce the original) for each tile whose ID changes.
+    QHash<uint16_t, Tile> m_remap;
+    QList<uint16_t> m_keptPrimaryTiles;
+    QList<uint16_t> m_keptSecondaryTiles;
+    int m_numReclaimedPrimary = 0;
+    int m_numReclaimedSecondary = 0;
+
+    void find(const Tileset *primaryTileset, const Tileset *secondaryTileset, const Options &options);
+    static QImage buildTilesImage(const Tileset *tileset, const QList<uint16_t> &tileIds);
+};
+
+#endif // TILECOMPACTOR_H
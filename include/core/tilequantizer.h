@@ -0,0 +1,32 @@
+#ifndef TILEQUANTIZER_H
+#define TILEQUANTIZER_H
+
+#include <QImage>
+#include <QList>
+#include <QRgb>
+
+// Converts an unindexed (e.g. RGB) tiles image into the form the GBA needs, where every 8x8 tile
+// uses one of several 16-color palettes. The first color of each palette is transparent, so each tile
+// can use at most 15 colors. Tiles that share colors are grouped into the same palette, and if the
+// image has too many colors to fit into the palettes the colors are reduced to the closest fit.
+class TileQuantizer
+{
+public:
+    struct Result {
+        // The tiles image, with 1 byte per pixel holding the pixel's index in its tile's palette.
+        QImage image;
+        // The palettes, each with 16 colors. Color 0 is the transparent color.
+        QList<QList<QRgb>> palettes;
+        // The index (in 'palettes') of the palette used by each tile.
+        QList<int> tilePalettes;
+        // False if any colors had to be changed to fit the tiles into the palettes.
+        bool isLossless = true;
+    };
+
+    // Pixels that are mostly transparent are given color 0, which is set to 'transparentColor' in every palette.
+    // So are pixels that match 'transparentColor' and, if 'topLeftIsTransparent' is true, pixels that match the color
+    // of the image's top-left pixel (a common way for tiles images without an alpha channel to mark their background).
+    static Result quantize(const QImage &image, int numPalettes, QRgb transparentColor, bool topLeftIsTransparent = false);
+};
+
+#endif // TILEQUANTIZER_H
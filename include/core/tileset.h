@@ -6,6 +6,7 @@
 #include "tile.h"
 #include <QImage>
 #include <QHash>
+#include <vector>
 
 struct MetatileLabelPair {
     QString owned;
@@ -18,7 +19,6 @@ public:
     Tileset() = default;
     Tileset(const Tileset &other);
     Tileset &operator=(const Tileset &other);
-    ~Tileset();
 
 public:
     QString name;
@@ -77,15 +77,15 @@ public:
 
     void setTilesImage(const QImage &image);
 
-    void setMetatiles(const QList<Metatile*> &metatiles);
-    void addMetatile(Metatile* metatile);
+    void setMetatiles(const QList<Metatile> &metatiles);
+    void addMetatile(const Metatile &metatile);
 
-    const QList<Metatile*> &metatiles() const { return m_metatiles; }
-    const Metatile* metatileAt(unsigned int i) const { return m_metatiles.at(i); }
+    const std::vector<Metatile> &metatiles() const { return m_metatiles; }
+    const Metatile* metatileAt(unsigned int i) const { return &m_metatiles.at(i); }
 
     void clearMetatiles();
     void resizeMetatiles(int newNumMetatiles);
-    int numMetatiles() const { return m_metatiles.length(); }
+    int numMetatiles() const { return static_cast<int>(m_metatiles.size()); }
     int maxMetatiles() const;
 
     uint16_t firstMetatileId() const;
@@ -96,23 +96,40 @@ public:
     uint16_t lastTileId() const;
     bool containsTileId(uint16_t tileId) const { return tileId >= firstTileId() && tileId <= lastTileId(); }
 
-    int numTiles() const { return m_tiles.length(); }
+    int numTiles() const { return m_numTiles; }
     int maxTiles() const;
 
-    QImage tileImage(uint16_t tileId) const { return m_tiles.value(Tile::getIndexInTileset(tileId)); }
+    // Returns the color indices of the tile's pixels (1 byte per pixel, row by row), or nullptr if the tileset doesn't have the tile.
+    // Palettes are applied when the tiles are rendered.
+    const uchar *tilePixels(uint16_t tileId) const;
+    QImage tileImage(uint16_t tileId) const;
+    const QImage &tilesImage() const { return m_tilesImage; }
 
-    QSet<int> getUnusedColorIds(int paletteId, const Tileset *pairedTileset, const QSet<int> &searchColors = {}) const;
     QList<uint16_t> findMetatilesUsingColor(int paletteId, int colorId, const Tileset *pairedTileset) const;
+    uint16_t getUsedColorsMask(int paletteId, const Tileset *pairedTileset) const;
+
+    // Returns a mask of the colors that appear in the tile's pixels (bit N is set if color N appears).
+    uint16_t tileColorMask(uint16_t tileId) const;
 
     static constexpr int maxPalettes() { return 16; }
     static constexpr int numColorsPerPalette() { return 16; }
 
 private:
-    QList<Metatile*> m_metatiles;
-
-    QList<QImage> m_tiles;
+    // Metatiles are stored contiguously. Pointers into this storage are handed out by getMetatile,
+    // so it's never reallocated while the metatile count stays within maxMetatiles() (see reserveMetatiles).
+    std::vector<Metatile> m_metatiles;
+    void reserveMetatiles(int count = 0);
+
+    QByteArray m_tilePixels;
+    int m_numTiles = 0;
+    QVector<QRgb> m_tilesColorTable;
     QImage m_tilesImage;
     bool m_hasUnsavedTilesImage = false;
+
+    // The colors used by each tile, built the first time they're needed after the tiles change.
+    mutable std::vector<uint16_t> m_tileColorMasks;
+    mutable bool m_tileColorMasksValid = false;
+    void buildTileColorMasks() const;
 };
 
 #endif // TILESET_H
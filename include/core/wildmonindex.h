@@ -0,0 +1,47 @@
+#ifndef WILDMONINDEX_H
+#define WILDMONINDEX_H
+
+#include "wildmoninfo.h"
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMultiMap>
+#include <QSet>
+
+// An index of where each species appears in the project's wild encounter data,
+// so that searching for a species doesn't need to look through every encounter slot of every map.
+class WildMonIndex
+{
+public:
+    struct Entry {
+        QString mapConstant;
+        QString groupName;
+        QString fieldName;
+        int slot = 0;
+        int minLevel = 0;
+        int maxLevel = 0;
+    };
+
+    void build(const OrderedMap<QString, OrderedMap<QString, WildPokemonHeader>> &wildMonData);
+    // Replaces the entries for one map, e.g. after its encounter tables were edited.
+    void updateMap(const QString &mapConstant, const OrderedMap<QString, WildPokemonHeader> &encounterGroups);
+    void removeMap(const QString &mapConstant);
+    void clear();
+
+    QList<Entry> find(const QString &species) const { return m_entriesBySpecies.value(species); }
+    bool contains(const QString &species) const { return m_entriesBySpecies.contains(species); }
+
+    // Returns the names of the species with wild encounters that start with 'prefix' (ignoring case), in alphabetical order.
+    // At most 'maxResults' names are returned (if it's not negative).
+    QStringList findSpecies(const QString &prefix, int maxResults = -1) const;
+
+private:
+    QHash<QString, QList<Entry>> m_entriesBySpecies;
+    QHash<QString, QSet<QString>> m_speciesByMap;
+    QMultiMap<QString, QString> m_speciesByFoldedName;
+
+    void addEntry(const QString &species, const Entry &entry);
+};
+
+#endif // WILDMONINDEX_H
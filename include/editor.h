@@ -23,8 +23,10 @@
 #include "currentselectedmetatilespixmapitem.h"
 #include "collisionpixmapitem.h"
 #include "layoutpixmapitem.h"
+#include "mapborderitem.h"
 #include "settings.h"
 #include "gridsettings.h"
+#include "mapgrid.h"
 #include "movablerect.h"
 #include "cursortilerect.h"
 #include "mapruler.h"
@@ -139,8 +141,8 @@ public:
     QPointer<CollisionPixmapItem> collision_item = nullptr;
     QGraphicsItemGroup *events_group = nullptr;
 
-    QList<QGraphicsPixmapItem*> borderItems;
-    QGraphicsItemGroup *mapGrid = nullptr;
+    MapBorderItem *mapBorderItem = nullptr;
+    MapGrid *mapGrid = nullptr;
     QPointer<MapRuler> map_ruler = nullptr;
 
     MovableRect *playerViewRect = nullptr;
@@ -174,7 +176,7 @@ public:
 
     void setMapEditingButtonsEnabled(bool enabled);
 
-    int scaleIndex = 2;
+    int scaleIndex = 4;
     qreal collisionOpacity = 0.5;
     static QList<QList<const QImage*>> collisionIcons;
 
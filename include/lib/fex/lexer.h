@@ -3,8 +3,11 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <QString>
+#include <QFile>
+#include <QByteArray>
 
 namespace fex
 {
@@ -60,27 +63,31 @@ namespace fex
             kCloseCurly,
             kPeriod,
             kUnderscore,
+
+            kEndOfFile,
         };
 
-        Token(Type type, std::string filename, int line_number) : type_(type), filename_(filename), line_number_(line_number) {}
-        Token(Type type, std::string filename, int line_number, std::string string_value) : type_(type), string_value_(string_value) , filename_(filename), line_number_(line_number) {}
-        Token(Type type, std::string filename, int line_number, int int_value) : type_(type), int_value_(int_value), filename_(filename), line_number_(line_number) {}
+        // Tokens don't own their string values or filenames, they refer to the Lexer's data.
+        // They're only valid for as long as the Lexer that produced them.
+        Token(Type type, const std::string *filename, int line_number) : type_(type), filename_(filename), line_number_(line_number) {}
+        Token(Type type, const std::string *filename, int line_number, std::string_view string_value) : type_(type), string_value_(string_value), filename_(filename), line_number_(line_number) {}
+        Token(Type type, const std::string *filename, int line_number, int int_value) : type_(type), int_value_(int_value), filename_(filename), line_number_(line_number) {}
 
         Type type() const { return type_; }
-        const std::string &string_value() const { return string_value_; }
+        std::string_view string_value() const { return string_value_; }
         int int_value() const { return int_value_; }
 
-        const std::string &filename() const { return filename_; }
+        const std::string &filename() const;
         int line_number() const { return line_number_; }
 
         std::string ToString() const;
 
     private:
         Type type_;
-        std::string string_value_;
-        int int_value_;
+        std::string_view string_value_;
+        int int_value_ = 0;
 
-        std::string filename_ = "";
+        const std::string *filename_ = nullptr;
         int line_number_ = 0;
     };
 
@@ -88,12 +95,24 @@ namespace fex
     {
     public:
         Lexer() = default;
-        ~Lexer() = default;
+        ~Lexer();
+        Lexer(const Lexer &) = delete;
+        Lexer &operator=(const Lexer &) = delete;
+
+        // Lex the file at 'path'. The file is memory-mapped if possible, otherwise it's read into a buffer owned by the Lexer.
+        bool Open(const QString &path);
+        // Lex 'data', which is owned by the caller and must outlive the Lexer's tokens.
+        void Open(std::string_view data, const std::string &filename);
+
+        // Tokens can be consumed one at a time, so the whole file doesn't need to be tokenized up-front.
+        // Once the end of the data is reached this returns kEndOfFile tokens.
+        Token NextToken();
 
         std::vector<Token> LexFile(const QString &path);
 
     private:
-        std::vector<Token> Lex();
+        void Close();
+        bool AtEnd() const { return index_ >= data_.size(); }
         char Peek();
         char Next();
         bool IsNumber();
@@ -102,17 +121,23 @@ namespace fex
         bool IsAlphaNumber();
         bool IsWhitespace();
 
+        void SkipLineComment();
+        void SkipBlockComment();
+
         Token ConsumeIdentifier();
         Token ConsumeKeyword(Token identifier);
         Token ConsumeNumber();
         Token ConsumeString();
         Token ConsumeMacro();
 
-        std::string ReadIdentifier();
+        QFile file_;
+        uchar *mapped_ = nullptr;
+        QByteArray buffer_;
 
-        std::string data_ = "";
-        uint32_t index_ = 0;
+        std::string_view data_;
+        size_t index_ = 0;
 
+        // Every token refers to this filename, rather than each having its own copy.
         std::string filename_ = "";
         int line_number_ = 1;
     };
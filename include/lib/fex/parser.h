@@ -22,6 +22,12 @@ namespace fex
         std::vector<Array> ParseTopLevelArrays(std::vector<Token> tokens);
         tsl::ordered_map<std::string, ArrayValue> ParseTopLevelObjects(std::vector<Token> tokens);
 
+        // Parse tokens as they're produced by 'lexer', rather than tokenizing the whole file first.
+        // Tokens are discarded once each top-level statement has been parsed.
+        std::vector<DefineStatement> Parse(Lexer *lexer);
+        std::vector<Array> ParseTopLevelArrays(Lexer *lexer);
+        tsl::ordered_map<std::string, ArrayValue> ParseTopLevelObjects(Lexer *lexer);
+
         tsl::ordered_map<std::string, int> ReadDefines(const QString &filename, std::vector<std::string> matching);
 
     private:
@@ -36,11 +42,16 @@ namespace fex
 
         ArrayValue ParseObject();
 
+        void Reset(std::vector<Token> tokens, Lexer *lexer);
+        void DiscardConsumedTokens();
+        bool AtEnd();
         Token Peek();
         Token Next();
 
-        unsigned long index_;
+        unsigned long index_ = 0;
         std::vector<Token> tokens_;
+        Lexer *lexer_ = nullptr;
+        bool lexer_done_ = true;
 
         std::map<std::string, int> top_level_;
     };
@@ -234,6 +234,10 @@ public:
         fileStream << "\n"; // pad file with newline
     }
 
+    QByteArray toByteArray() {
+        return (m_obj->dump(&m_indent) + "\n").toUtf8();
+    }
+
 private:
     Json *m_obj;
     int m_indent;
@@ -11,6 +11,8 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QCloseEvent>
 #include <QAbstractItemModel>
+#include <QScrollArea>
+#include <QTimer>
 #include "project.h"
 #include "orderedjson.h"
 #include "config.h"
@@ -35,6 +37,7 @@
 #include "message.h"
 #include "resizelayoutpopup.h"
 #include "unlockableicon.h"
+#include "perftracepanel.h"
 
 #if __has_include(<QJSValue>)
 #include <QJSValue>
@@ -238,6 +241,7 @@ private slots:
     void tryAddEventTab(QWidget * tab);
     void displayEventTabs();
     void updateSelectedEvents();
+    void loadPendingEventFrames();
     void updateEvents();
 
     void on_toolButton_Paint_clicked();
@@ -284,6 +288,7 @@ private slots:
     void on_actionAbout_Porymap_triggered();
     void on_actionOpen_Log_File_triggered();
     void on_actionOpen_Config_Folder_triggered();
+    void on_actionPerformance_Trace_triggered();
     void on_horizontalSlider_MetatileZoom_valueChanged(int value);
     void on_horizontalSlider_CollisionZoom_valueChanged(int value);
     void on_pushButton_NewWildMonGroup_clicked();
@@ -320,6 +325,9 @@ private:
     QPointer<RegionMapEditor> regionMapEditor = nullptr;
     QPointer<ShortcutsEditor> shortcutsEditor = nullptr;
     QPointer<MapImageExporter> mapImageExporter = nullptr;
+    MapImageExportQueue *mapImageExportQueue = nullptr;
+    QProgressBar *progressBar_ImageExport = nullptr;
+    QToolButton *button_CancelImageExports = nullptr;
     QPointer<PreferenceEditor> preferenceEditor = nullptr;
     QPointer<ProjectSettingsEditor> projectSettingsEditor = nullptr;
     QPointer<GridSettingsDialog> gridSettingsDialog = nullptr;
@@ -342,6 +350,7 @@ private:
     QPointer<WildMonSearch> wildMonSearch = nullptr;
     QPointer<QuestionMessage> fileWatcherWarning = nullptr;
     QPointer<ResizeLayoutPopup> resizeLayoutPopup = nullptr;
+    QPointer<PerfTracePanel> perfTracePanel = nullptr;
 
     QAction *undoAction = nullptr;
     QAction *redoAction = nullptr;
@@ -366,11 +375,24 @@ private:
 
     bool isProgrammaticEventTabChange;
 
+    // Frames for large event selections are created in batches as the user scrolls down to them.
+    QList<Event*> pendingEventFrameEvents;
+    QPointer<QScrollArea> pendingEventFrameScrollArea;
+    // The most recently displayed event frames, most recent first. Older hidden frames are destroyed.
+    QList<QPointer<EventFrame>> recentEventFrames;
+
+    // The layout the Map tab's icon was last rendered for, and the timer that re-renders it after edits.
+    QPointer<Layout> mapTabIconLayout;
+    QTimer mapTabIconTimer;
+
     bool tilesetNeedsRedraw = false;
     bool lockMapListAutoScroll = false;
 
     QSet<QObject*> objectsDisabled;
 
+    EventFrame *prepareEventFrame(Event *event);
+    void trimEventFrames();
+
     bool setLayout(const QString &layoutId);
     bool setMap(const QString &mapName);
     void unsetMap();
@@ -429,9 +451,13 @@ private:
     void setEditActionUi(Editor::EditAction editAction);
 
     void updateWindowTitle();
+    void updateMapTabIcon();
 
     void initWindow();
     void initLogStatusBar();
+    void initImageExportQueue();
+    void updateImageExportStatus(MapImageExportJob *job, int value, int maximum, const QString &label);
+    void onImageExportFinished(MapImageExportJob *job);
     void initCustomUI();
     void initExtraSignals();
     void initEditor();
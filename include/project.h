@@ -5,9 +5,15 @@
 #include "map.h"
 #include "blockdata.h"
 #include "wildmoninfo.h"
+#include "wildmonindex.h"
 #include "parseutil.h"
 #include "orderedjson.h"
 #include "regionmap.h"
+#include "saveplan.h"
+#include "scriptlabelindex.h"
+#include "assetindex.h"
+#include "eventspriteatlas.h"
+#include "constantsmodel.h"
 
 #include <QStringList>
 #include <QList>
@@ -51,7 +57,6 @@ public:
     QStringList secretBaseIds;
     QStringList bgEventFacingDirections;
     QStringList trainerTypes;
-    QStringList globalScriptLabels;
     QMap<uint32_t, QString> encounterTypeToName;
     QMap<uint32_t, QString> terrainTypeToName;
     QMap<QString, QMap<QString, uint16_t>> metatileLabelsMap;
@@ -148,6 +153,7 @@ public:
 
     bool readWildMonData();
     OrderedMap<QString, OrderedMap<QString, WildPokemonHeader>> wildMonData;
+    WildMonIndex wildMonIndex;
 
     QString wildMonTableName;
     QVector<EncounterField> wildMonFields;
@@ -213,7 +219,11 @@ public:
 
     QPixmap getEventPixmap(const QString &gfxName, const QString &movementName);
     QPixmap getEventPixmap(const QString &gfxName, int frame, bool hFlip);
+    QPixmap getEventPixmap(EventSpriteAtlas::Key key);
     QPixmap getEventPixmap(Event::Group group);
+    EventSpriteAtlas::Key getEventSpriteKey(const QString &gfxName, const QString &movementName) const;
+    EventSpriteAtlas::Key getEventSpriteKey(const QString &gfxName, int frame, bool hFlip) const;
+    bool getEventSprite(EventSpriteAtlas::Key key, EventSpriteAtlas::Sprite *sprite, bool countLookup = true);
     void loadEventPixmap(Event *event, bool forceLoad = false);
 
     QString fixPalettePath(const QString &path) const;
@@ -226,7 +236,6 @@ public:
     QStringList getMapScriptsFilepaths() const;
     QStringList getCommonEventScriptsFilepaths() const;
     QStringList findScriptsFiles(const QString &searchDir, const QStringList &fileNames = {"*"}) const;
-    void insertGlobalScriptLabels(QStringList &scriptLabels) const;
 
     QString getDefaultPrimaryTilesetLabel() const;
     QString getDefaultSecondaryTilesetLabel() const;
@@ -275,8 +284,36 @@ public:
     static QString getEmptyMapsecName();
     static QString getMapGroupPrefix();
 
+    // Lists of project constants that are displayed in combo boxes.
+    enum class Constants {
+        Flags,
+        Vars,
+        Items,
+        Sprites,
+        MovementTypes,
+        TrainerTypes,
+        CoordEventWeathers,
+        BgEventFacingDirections,
+        SecretBaseIds,
+        MapNames,
+        Species,
+        MetatileBehaviors,
+        GlobalScriptLabels,
+        Songs,
+        Weathers,
+        MapTypes,
+        BattleScenes,
+        Locations,
+    };
+    // Returns a model of the given constants that can be shared by any number of combo boxes.
+    // There's only one model for each list of constants, which is updated in place when the list changes.
+    ConstantsModel *getConstantsModel(Constants constants);
+
 private:
     QPointer<QFileSystemWatcher> fileWatcher;
+    QMap<Constants, ConstantsModel*> constantsModels;
+    void updateConstantsModel(Constants constants);
+    void updateConstantsModels();
     QMap<QString, qint64> modifiedFileTimestamps;
     QMap<QString, QString> facingDirections;
     QHash<QString, QString> speciesToIconPath;
@@ -327,8 +364,14 @@ private:
         int spriteWidth = -1;
         int spriteHeight = -1;
         bool inanimate = false;
+        int id = -1;
     };
     QMap<QString, EventGraphics*> eventGraphicsMap;
+    QList<EventGraphics*> eventGraphicsById;
+    EventSpriteAtlas eventSpriteAtlas;
+
+    EventGraphics *getEventGraphics(const QString &gfxName) const;
+    QImage getEventFrameImage(EventGraphics *gfx, int frame, bool hFlip);
 
     // The extra data that can be associated with each MAPSEC name.
     struct LocationData
@@ -352,6 +395,13 @@ private:
     void logFileWatchStatus();
     void cacheTileset(const QString &label, Tileset *tileset);
 
+    // While saving everything, files are queued here and written together once all of them have been serialized.
+    SavePlan *savePlan = nullptr;
+    ScriptLabelIndex *scriptLabelIndex = nullptr;
+    AssetIndex assetIndex;
+    bool writeFile(const QString &path, const QByteArray &data, const std::function<void()> &onSaved = nullptr);
+    bool writeSavePlan(SavePlan *plan);
+
     bool saveMapLayouts();
     bool saveMapGroups();
     bool saveWildMonData();
@@ -3,7 +3,9 @@
 #define SCRIPTING_H
 
 #include <QStringList>
+#include <QVariantMap>
 #include "scriptutility.h"
+#include "scriptworker.h"
 
 class Block;
 class Tile;
@@ -44,6 +46,8 @@ public:
     static void init(MainWindow *mainWindow);
     static void stop();
     static void populateGlobalObject(MainWindow *mainWindow);
+    static QVariantMap getConstants(MainWindow *mainWindow);
+    static void setConstants(QJSEngine *engine, const QVariantMap &constants);
     static QJSEngine *getEngine();
     static void invokeAction(int actionIndex);
 
@@ -80,6 +84,7 @@ private:
     QList<QJSValue> modules;
     QMap<QString, const QImage*> imageCache;
     ScriptUtility *scriptUtility;
+    ScriptWorker *worker;
 
     void loadModules(const QStringList &moduleFiles);
     void invokeCallback(CallbackType type, QJSValueList args);
@@ -25,6 +25,8 @@ public:
     QString getActionFunctionName(int actionIndex);
     Q_INVOKABLE bool registerAction(QString functionName, QString actionName, QString shortcut = "");
     Q_INVOKABLE bool registerToggleAction(QString functionName, QString actionName, QString shortcut = "", bool checked = false);
+    Q_INVOKABLE bool registerBackgroundAction(QString functionName, QString actionName, QString shortcut = "");
+    bool isBackgroundAction(int actionIndex) const { return this->backgroundActions.contains(actionIndex); }
     Q_INVOKABLE void setTimeout(QJSValue callback, int milliseconds);
     Q_INVOKABLE void log(QString message);
     Q_INVOKABLE void warn(QString message);
@@ -77,6 +79,7 @@ private:
     QList<QAction *> registeredActions;
     QSet<QTimer *> activeTimers;
     QHash<int, QString> actionMap;
+    QSet<int> backgroundActions;
 };
 
 #endif // QT_QML_LIB
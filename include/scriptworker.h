@@ -0,0 +1,153 @@
+#pragma once
+#ifndef SCRIPTWORKER_H
+#define SCRIPTWORKER_H
+
+#if __has_include(<QJSEngine>)
+#include <QJSEngine>
+#endif
+
+#ifdef QT_QML_LIB
+
+#include "mapimageexportjob.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <atomic>
+
+class MainWindow;
+class Layout;
+class QProgressBar;
+class QToolButton;
+class ScriptWorkerJob;
+
+// The API available to a background script action as the global 'worker' object.
+// Reads come from a snapshot of the layout taken when the action started. Edits are made to the action's
+// own copy of the layout, and are applied to the real layout once the action finishes.
+class ScriptWorkerApi : public QObject
+{
+    Q_OBJECT
+public:
+    ScriptWorkerApi(QJSEngine *engine, const LayoutSnapshot &layout, ScriptWorkerJob *job);
+
+    Q_INVOKABLE int getWidth();
+    Q_INVOKABLE int getHeight();
+    Q_INVOKABLE int getBorderWidth();
+    Q_INVOKABLE int getBorderHeight();
+    Q_INVOKABLE QJSValue getBlock(int x, int y);
+    Q_INVOKABLE void setBlock(int x, int y, int metatileId, int collision, int elevation);
+    Q_INVOKABLE void setBlock(int x, int y, int rawValue);
+    Q_INVOKABLE int getMetatileId(int x, int y);
+    Q_INVOKABLE void setMetatileId(int x, int y, int metatileId);
+    Q_INVOKABLE int getCollision(int x, int y);
+    Q_INVOKABLE void setCollision(int x, int y, int collision);
+    Q_INVOKABLE int getElevation(int x, int y);
+    Q_INVOKABLE void setElevation(int x, int y, int elevation);
+    Q_INVOKABLE int getBorderMetatileId(int x, int y);
+    Q_INVOKABLE void setBorderMetatileId(int x, int y, int metatileId);
+    Q_INVOKABLE QString getPrimaryTileset();
+    Q_INVOKABLE QString getSecondaryTileset();
+    Q_INVOKABLE int getMetatileBehavior(int metatileId);
+    Q_INVOKABLE int getMetatileLayerType(int metatileId);
+    Q_INVOKABLE int getMetatileEncounterType(int metatileId);
+    Q_INVOKABLE int getMetatileTerrainType(int metatileId);
+    Q_INVOKABLE void setProgress(int value, int maximum, QString label = "");
+    Q_INVOKABLE bool isCanceled();
+    Q_INVOKABLE void log(QString message);
+    Q_INVOKABLE void warn(QString message);
+    Q_INVOKABLE void error(QString message);
+
+    const Blockdata &blockdata() const { return m_blockdata; }
+    const Blockdata &border() const { return m_border; }
+
+private:
+    QJSEngine *m_engine;
+    const LayoutSnapshot &m_layout;
+    ScriptWorkerJob *m_job;
+    Blockdata m_blockdata;
+    Blockdata m_border;
+
+    int blockIndex(int x, int y) const;
+    int borderIndex(int x, int y) const;
+    const Metatile *getMetatile(int metatileId) const;
+};
+
+// Runs a script action on a worker thread, with its own script engine.
+class ScriptWorkerJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    struct Input {
+        QString functionName;
+        QStringList filepaths;
+        QVariantMap constants;
+        LayoutSnapshot layout;
+    };
+
+    explicit ScriptWorkerJob(const Input &input, QObject *parent = nullptr);
+
+    void run() override;
+    // The first request lets the script stop itself (see 'worker.isCanceled'). Any further request interrupts the script engine.
+    void cancel();
+
+    QString functionName() const { return m_input.functionName; }
+    const LayoutSnapshot &layout() const { return m_input.layout; }
+    bool wasCanceled() const { return m_canceled; }
+    bool succeeded() const { return m_succeeded; }
+
+    // Only valid after the job has finished. Maps the index of each changed block to its new value.
+    const QHash<int, Block> &blockChanges() const { return m_blockChanges; }
+    const QHash<int, Block> &borderChanges() const { return m_borderChanges; }
+
+signals:
+    void progressChanged(int value, int maximum, const QString &label);
+    void finished();
+
+private:
+    const Input m_input;
+    std::atomic_bool m_canceled{false};
+    bool m_succeeded = false;
+    QHash<int, Block> m_blockChanges;
+    QHash<int, Block> m_borderChanges;
+
+    QMutex m_engineMutex;
+    QJSEngine *m_engine = nullptr;
+    bool m_interrupted = false;
+
+    static QHash<int, Block> getChanges(const Blockdata &oldBlocks, const Blockdata &newBlocks);
+};
+
+// Starts background script actions, shows their progress in the status bar, and applies their edits.
+// Only one background action runs at a time.
+class ScriptWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptWorker(MainWindow *mainWindow);
+    ~ScriptWorker();
+
+    bool start(const QString &functionName, const QStringList &filepaths);
+    bool isRunning() const { return m_job != nullptr; }
+
+private:
+    MainWindow *m_mainWindow;
+    QThreadPool m_pool;
+    ScriptWorkerJob *m_job = nullptr;
+    QPointer<Layout> m_layout;
+    QPointer<QProgressBar> m_progressBar;
+    QPointer<QToolButton> m_cancelButton;
+
+    static LayoutSnapshot captureLayout(const Layout *layout);
+    void updateProgress(int value, int maximum, const QString &label);
+    void onFinished();
+    void applyChanges(const ScriptWorkerJob *job);
+};
+
+#endif // QT_QML_LIB
+
+#endif // SCRIPTWORKER_H
@@ -0,0 +1,36 @@
+#ifndef COLLISIONATLAS_H
+#define COLLISIONATLAS_H
+
+#include "block.h"
+
+#include <QImage>
+#include <memory>
+
+// Every collision icon (see Editor::collisionIcons), precomposited into a single image at a given opacity.
+// Each collision/elevation combination has a cell in the atlas, so drawing a block's collision is a copy of one cell.
+// Atlases don't change once they're created, and are shared by every layout (and by background image exports).
+class CollisionAtlas
+{
+public:
+    // Returns the atlas for the current collision icons at the given opacity (0-1), creating it if necessary.
+    static std::shared_ptr<const CollisionAtlas> get(qreal opacity);
+
+    // Discards the shared atlases. This should be called whenever the collision icons change.
+    static void clearCache();
+
+    qreal opacity() const { return m_opacity / 100.0; }
+
+    // Copies the icon for the block's collision and elevation to 'image', with its top-left corner at (x, y).
+    // This replaces the pixels already there, rather than drawing over them.
+    void drawBlock(QImage *image, int x, int y, const Block &block) const;
+
+private:
+    CollisionAtlas(int opacity);
+
+    QImage m_image;
+    int m_numCollisions = 0;
+    int m_numElevations = 0;
+    int m_opacity = 100;
+};
+
+#endif // COLLISIONATLAS_H
@@ -11,6 +11,10 @@
 
 class CollisionPixmapItem : public LayoutPixmapItem {
     Q_OBJECT
+
+private:
+    using LayoutPixmapItem::paint;
+
 public:
     CollisionPixmapItem(Layout *layout, QSpinBox * selectedCollision, QSpinBox * selectedElevation, MetatileSelector *metatileSelector, Settings *settings, qreal *opacity)
         : LayoutPixmapItem(layout, metatileSelector, settings){
@@ -29,6 +33,11 @@ public:
     virtual void pick(QGraphicsSceneMouseEvent*) override;
     void draw(bool ignoreCache = false) override;
 
+protected:
+    const QImage &image() const override;
+    // The collision image is drawn in full by draw(), which is cheap (see CollisionAtlas).
+    void renderImageArea(const QRect &) override {}
+
 private:
     void updateSelection(QPoint pos);
 };
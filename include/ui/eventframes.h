@@ -33,6 +33,8 @@ public:
 
     virtual void setActive(bool active);
 
+    Event *getEvent() const { return this->event; }
+
 public:
     QLabel *label_id;
 
@@ -59,6 +61,7 @@ protected:
     QPointer<Project> project;
 
     void populateDropdown(NoScrollComboBox * combo, const QStringList &items);
+    void populateDropdown(NoScrollComboBox * combo, ConstantsModel *model);
     void populateScriptDropdown(NoScrollComboBox * combo, Project * project);
     void populateMapNameDropdown(NoScrollComboBox * combo, Project * project);
     void populateIdNameDropdown(NoScrollComboBox * combo, Project * project, const QString &mapName, Event::Group group);
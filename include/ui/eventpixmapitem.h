@@ -28,9 +28,12 @@ public:
     void moveTo(int x, int y);
     void moveTo(const QPoint &pos);
 
+    virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
 private:
     QPixmap m_basePixmap;
     Event *const m_event = nullptr;
+    QPointer<Project> m_project;
     QPoint m_lastPos;
     bool m_active = false;
     bool m_selected = false;
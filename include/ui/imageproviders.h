@@ -5,9 +5,22 @@
 #include "tileset.h"
 #include <QImage>
 #include <QPixmap>
+#include <QColor>
 
 class Layout;
 
+// The project settings that affect how metatiles are drawn. Metatiles drawn off the main thread should use
+// a copy of these made beforehand, rather than reading 'projectConfig' while the settings could be changed.
+struct MetatileImageSettings {
+    QColor transparencyColor;
+    bool tripleLayerMetatilesEnabled = false;
+    uint16_t unusedTileNormal = 0;
+    uint16_t unusedTileCovered = 0;
+    uint16_t unusedTileSplit = 0;
+
+    static MetatileImageSettings fromProjectConfig();
+};
+
 QImage getCollisionMetatileImage(Block);
 QImage getCollisionMetatileImage(int, int);
 
@@ -15,6 +28,7 @@ QImage getMetatileImage(uint16_t, const Layout*, bool useTruePalettes = false);
 QImage getMetatileImage(const Metatile*, const Layout*, bool useTruePalettes = false);
 QImage getMetatileImage(uint16_t, const Tileset*, const Tileset*, const QList<int>& = {0,1,2}, const QList<float>& = {}, bool useTruePalettes = false);
 QImage getMetatileImage(const Metatile*, const Tileset*, const Tileset*, const QList<int>& = {0,1,2}, const QList<float>& = {}, bool useTruePalettes = false);
+QImage getMetatileImage(const Metatile*, const Tileset*, const Tileset*, const QList<int>&, const QList<float>&, bool useTruePalettes, const MetatileImageSettings &settings);
 
 QImage getMetatileSheetImage(const Layout *layout, int numMetatilesWIde, bool useTruePalettes = false);
 QImage getMetatileSheetImage(const Tileset *primaryTileset,
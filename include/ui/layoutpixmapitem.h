@@ -3,6 +3,7 @@
 
 #include "settings.h"
 #include "metatileselector.h"
+#include "pixmapchunkcache.h"
 #include <QGraphicsPixmapItem>
 
 class Layout;
@@ -10,9 +11,6 @@ class Layout;
 class LayoutPixmapItem : public QObject, public QGraphicsPixmapItem {
     Q_OBJECT
 
-private:
-    using QGraphicsPixmapItem::paint;
-
 public:
     LayoutPixmapItem(Layout *layout, MetatileSelector *metatileSelector, Settings *settings) {
         this->layout = layout;
@@ -22,6 +20,8 @@ public:
         this->lockedAxis = LayoutPixmapItem::Axis::None;
         this->prevStraightPathState = false;
         setAcceptHoverEvents(true);
+        // Needed so that only the exposed part of the layout is painted.
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
     }
 
     Layout *layout;
@@ -83,6 +83,12 @@ public:
     void shift(int xDelta, int yDelta, bool fromScriptCall = false);
     virtual void draw(bool ignoreCache = false);
 
+    // The layout image isn't set as this item's pixmap, it's painted directly in chunks.
+    virtual QRectF boundingRect() const override;
+    virtual QPainterPath shape() const override;
+    virtual bool contains(const QPointF &point) const override;
+    virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
     void updateMetatileSelection(QGraphicsSceneMouseEvent *event);
     void paintNormal(int x, int y, bool fromScriptCall = false);
     void lockNondominantAxis(QGraphicsSceneMouseEvent *event);
@@ -91,7 +97,15 @@ public:
 protected:
     unsigned actionId_ = 0;
 
+    virtual const QImage &image() const;
+    // Draws any part of image() within 'rect' that hasn't been drawn yet. Called just before that area is first painted.
+    virtual void renderImageArea(const QRect &rect);
+    void imageChanged(const QRect &changedRect);
+
 private:
+    PixmapChunkCache chunkCache;
+    QSize imageSize;
+
     void paintSmartPath(int x, int y, bool fromScriptCall = false);
     static bool isValidSmartPathSelection(MetatileSelection selection);
     static QList<int> smartPathTable;
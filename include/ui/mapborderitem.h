@@ -0,0 +1,29 @@
+#ifndef MAPBORDERITEM_H
+#define MAPBORDERITEM_H
+
+#include <QGraphicsItem>
+#include <QPixmap>
+
+class Layout;
+
+// Displays a layout's border, repeated around the layout up to the player's view distance.
+// Rather than creating an item for each repetition (which can be thousands for large layouts),
+// the border is tiled across whatever part of the item is exposed.
+class MapBorderItem : public QGraphicsItem
+{
+public:
+    explicit MapBorderItem(Layout *layout);
+
+    void draw(bool ignoreCache = false);
+
+    virtual QRectF boundingRect() const override;
+    virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    Layout *m_layout;
+    QPixmap m_pixmap;
+    QRect m_rect;
+    QRect m_layoutRect;
+};
+
+#endif // MAPBORDERITEM_H
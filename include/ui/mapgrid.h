@@ -0,0 +1,31 @@
+#ifndef MAPGRID_H
+#define MAPGRID_H
+
+#include "gridsettings.h"
+
+#include <QPainter>
+#include <QPen>
+
+// The grid drawn over the map. Rather than creating an item for each line, the grid is painted directly,
+// and only the lines in the area being painted are drawn, so its cost doesn't depend on the size of the map.
+class MapGrid
+{
+public:
+    explicit MapGrid(const GridSettings &settings);
+
+    void setSettings(const GridSettings &settings);
+    GridSettings settings() const { return m_settings; }
+
+    void setVisible(bool visible) { m_visible = visible; }
+    bool isVisible() const { return m_visible; }
+
+    void paint(QPainter *painter, const QRectF &rect, const QSize &mapPixelSize) const;
+
+private:
+    GridSettings m_settings;
+    QPen m_verticalPen;
+    QPen m_horizontalPen;
+    bool m_visible = false;
+};
+
+#endif // MAPGRID_H
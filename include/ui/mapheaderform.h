@@ -67,7 +67,6 @@ private:
 
     void setText(NoScrollComboBox *combo, const QString &text) const;
     void setText(QLineEdit *lineEdit, const QString &text) const;
-    void setLocations(const QStringList &locations);
     void updateLocationName();
 
     void onSongUpdated(const QString &song);
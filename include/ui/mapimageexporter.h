@@ -3,42 +3,21 @@
 
 #include "project.h"
 #include "checkeredbgscene.h"
-
-class QGifImage;
+#include "mapimageexportjob.h"
 
 namespace Ui {
 class MapImageExporter;
 }
 
-enum ImageExporterMode {
-    Normal,
-    Stitch,
-    Timelapse,
-};
-
-struct ImageExporterSettings {
-    QSet<Event::Group> showEvents;
-    QSet<QString> showConnections;
-    bool showGrid = false;
-    bool showBorder = false;
-    bool showCollision = false;
-    bool disablePreviewScaling = false;
-    bool disablePreviewUpdates = false;
-    int timelapseSkipAmount = 1;
-    int timelapseDelayMs = 200;
-    // Not exposed as a setting in the UI atm (our color input widget has no alpha channel).
-    QColor fillColor = Qt::transparent;
-};
-
 class MapImageExporter : public QDialog
 {
     Q_OBJECT
 
 public:
-    explicit MapImageExporter(QWidget *parent, Project *project, Map *map, ImageExporterMode mode = ImageExporterMode::Normal)
-                        : MapImageExporter(parent, project, map, map->layout(), mode) {};
-    explicit MapImageExporter(QWidget *parent, Project *project, Layout *layout, ImageExporterMode mode = ImageExporterMode::Normal)
-                        : MapImageExporter(parent, project, nullptr, layout, mode) {};
+    explicit MapImageExporter(QWidget *parent, Project *project, MapImageExportQueue *exportQueue, Map *map, ImageExporterMode mode = ImageExporterMode::Normal)
+                        : MapImageExporter(parent, project, exportQueue, map, map->layout(), mode) {};
+    explicit MapImageExporter(QWidget *parent, Project *project, MapImageExportQueue *exportQueue, Layout *layout, ImageExporterMode mode = ImageExporterMode::Normal)
+                        : MapImageExporter(parent, project, exportQueue, nullptr, layout, mode) {};
     ~MapImageExporter();
 
     ImageExporterMode mode() const { return m_mode; }
@@ -47,14 +26,17 @@ public:
     void setLayout(Layout *layout);
 
 private:
-    explicit MapImageExporter(QWidget *parent, Project *project, Map *map, Layout *layout, ImageExporterMode mode);
+    explicit MapImageExporter(QWidget *parent, Project *project, MapImageExportQueue *exportQueue, Map *map, Layout *layout, ImageExporterMode mode);
 
     Ui::MapImageExporter *ui;
     Project *m_project = nullptr;
     Map *m_map = nullptr;
     Layout *m_layout = nullptr;
+    MapImageExportQueue *m_exportQueue = nullptr;
+    QPointer<MapImageExportJob> m_previewJob;
+    bool m_previewIsCurrent = false;
     CheckeredBgScene *m_scene = nullptr;
-    QGifImage *m_timelapseGifImage = nullptr;
+    QByteArray m_timelapseGif;
     QBuffer *m_timelapseBuffer = nullptr;
     QMovie *m_timelapseMovie = nullptr;
     QGraphicsPixmapItem *m_preview = nullptr;
@@ -77,18 +59,23 @@ private:
     bool connectionsEnabled();
     void setConnectionDirectionEnabled(const QString &dir, bool enable);
     void saveImage();
-    QGifImage* createTimelapseGifImage(QProgressDialog *progress);
-    QImage getStitchedImage(QProgressDialog *progress);
-    QImage getFormattedMapImage();
-    void paintBorder(QPainter *painter, Layout *layout);
-    void paintCollision(QPainter *painter, Layout *layout);
-    void paintConnections(QPainter *painter, const Map *map);
-    void paintEvents(QPainter *painter, const Map *map);
-    void paintGrid(QPainter *painter, const Layout *layout = nullptr);
+    void setPreviewImage(const QImage &image);
+    void onPreviewJobFinished(MapImageExportJob *job);
+    void onPreviewJobProgressChanged(MapImageExportJob *job, int value, int maximum, const QString &label);
+    bool captureFrames(QList<MapImageFrame> *frames);
+    bool captureTimelapseFrames(QList<MapImageFrame> *frames, QProgressDialog *progress);
+    QList<MapImageFrame> captureStitchedFrames();
+    MapImageFrame captureFrame(Map *map, Layout *layout, const QPoint &offset = QPoint());
+    LayoutSnapshot captureLayout(Layout *layout);
+    std::shared_ptr<const Tileset> captureTileset(const Tileset *tileset);
+    QList<DecorationSnapshot> captureConnections(const Map *map);
+    QList<DecorationSnapshot> captureEvents(const Map *map);
     QMargins getMargins(const Map *map);
-    QImage getExpandedImage(const QImage &image, const QSize &targetSize, const QColor &fillColor);
     bool currentHistoryAppliesToFrame(QUndoStack *historyStack);
 
+    // Tilesets are copied once per capture, then shared by every frame that uses them.
+    QHash<const Tileset*, std::shared_ptr<const Tileset>> m_tilesetSnapshots;
+
 protected:
     virtual void showEvent(QShowEvent *) override;
     virtual void resizeEvent(QResizeEvent *) override;
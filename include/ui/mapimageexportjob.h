@@ -0,0 +1,187 @@
+#ifndef MAPIMAGEEXPORTJOB_H
+#define MAPIMAGEEXPORTJOB_H
+
+#include "blockdata.h"
+#include "tileset.h"
+#include "events.h"
+#include "imageproviders.h"
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QPointer>
+#include <QImage>
+#include <QMargins>
+#include <QColorSpace>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class CollisionAtlas;
+
+enum ImageExporterMode {
+    Normal,
+    Stitch,
+    Timelapse,
+};
+
+struct ImageExporterSettings {
+    QSet<Event::Group> showEvents;
+    QSet<QString> showConnections;
+    bool showGrid = false;
+    bool showBorder = false;
+    bool showCollision = false;
+    bool disablePreviewScaling = false;
+    bool disablePreviewUpdates = false;
+    int timelapseSkipAmount = 1;
+    int timelapseDelayMs = 200;
+    // Not exposed as a setting in the UI atm (our color input widget has no alpha channel).
+    QColor fillColor = Qt::transparent;
+};
+
+// A copy of the data needed to draw a layout. Once created it's never modified,
+// so it can be read by export jobs while the original layout continues to be edited.
+struct LayoutSnapshot {
+    int width = 0;
+    int height = 0;
+    int borderWidth = 0;
+    int borderHeight = 0;
+    QMargins borderMargins;
+    QRect visibleRect;
+    Blockdata blockdata;
+    Blockdata border;
+    std::shared_ptr<const Tileset> primaryTileset;
+    std::shared_ptr<const Tileset> secondaryTileset;
+    QList<int> layerOrder;
+    QList<float> layerOpacity;
+
+    int pixelWidth() const { return this->width * Metatile::pixelWidth(); }
+    int pixelHeight() const { return this->height * Metatile::pixelHeight(); }
+    QSize pixelSize() const { return QSize(pixelWidth(), pixelHeight()); }
+};
+
+// An image drawn on top of (or around) a map, like an event sprite or a connected map.
+struct DecorationSnapshot {
+    QPoint pos;
+    QImage image;
+    qreal opacity = 1.0;
+};
+
+// Everything needed to draw a single map or layout in an exported image.
+struct MapImageFrame {
+    QPoint offset; // Position relative to the other frames in a stitched image
+    QMargins margins;
+    LayoutSnapshot layout;
+    QList<DecorationSnapshot> connections;
+    QList<DecorationSnapshot> events;
+};
+
+// Renders map images from snapshots on a worker thread.
+// In Stitch mode all the frames are combined into a single image, otherwise each frame is its own image
+// (Timelapse mode combines these images into a GIF). If an output path is given the result is written
+// directly to disk, otherwise it's kept for the caller (e.g. to display a preview).
+class MapImageExportJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    MapImageExportJob(ImageExporterMode mode,
+                      const ImageExporterSettings &settings,
+                      const QList<MapImageFrame> &frames,
+                      const QString &outputPath = QString(),
+                      QObject *parent = nullptr);
+
+    void run() override;
+    void cancel() { m_canceled = true; }
+
+    ImageExporterMode mode() const { return m_mode; }
+    QString outputPath() const { return m_outputPath; }
+    bool wasCanceled() const { return m_canceled; }
+    bool succeeded() const { return m_succeeded; }
+    QString errorString() const { return m_errorString; }
+
+    // Only valid after the job has finished.
+    QImage resultImage() const { return m_resultImage; }
+    QByteArray resultGif() const { return m_resultGif; }
+
+
+signals:
+    void progressChanged(int value, int maximum, const QString &label);
+    void finished();
+
+private:
+    const ImageExporterMode m_mode;
+    const ImageExporterSettings m_settings;
+    const QList<MapImageFrame> m_frames;
+    const QString m_outputPath;
+    // The collision icons are owned by the Editor and may be recreated if the project settings change,
+    // so jobs keep their own reference to the atlas they were created with.
+    const std::shared_ptr<const CollisionAtlas> m_collisionAtlas;
+    const QColorSpace m_colorSpace;
+    // Jobs run on worker threads, so the project settings they need are copied when they're created.
+    const MetatileImageSettings m_metatileImageSettings;
+
+    std::atomic_bool m_canceled{false};
+    bool m_succeeded = false;
+    QString m_errorString;
+    QImage m_resultImage;
+    QByteArray m_resultGif;
+
+    // Consecutive timelapse frames usually differ by only a few blocks, so we keep the most
+    // recently rendered layout and only redraw the blocks that changed.
+    struct {
+        QImage image;
+        Blockdata blockdata;
+        const Tileset *primaryTileset = nullptr;
+        const Tileset *secondaryTileset = nullptr;
+    } m_lastLayout;
+    QHash<QPair<const Tileset*, const Tileset*>, QHash<uint16_t, QImage>> m_metatileImageCache;
+
+    bool render();
+    QImage renderFrame(const MapImageFrame &frame);
+    QImage renderStitchedFrames();
+    QImage renderTimelapseFrame(const MapImageFrame &frame, const QSize &canvasSize);
+
+    QImage renderLayout(const LayoutSnapshot &layout);
+    QImage renderBorder(const LayoutSnapshot &layout);
+    QImage renderCollision(const LayoutSnapshot &layout);
+    QImage getMetatileImage(uint16_t metatileId, const LayoutSnapshot &layout);
+
+    void paintBorder(QPainter *painter, const LayoutSnapshot &layout);
+    void paintLayout(QPainter *painter, const LayoutSnapshot &layout);
+    void paintCollision(QPainter *painter, const LayoutSnapshot &layout);
+    void paintDecorations(QPainter *painter, const QList<DecorationSnapshot> &decorations);
+    void paintGrid(QPainter *painter, const LayoutSnapshot &layout);
+
+    bool reportProgress(int value, int maximum, const QString &label);
+};
+
+// Runs map image export jobs on a pool of worker threads.
+// Jobs beyond the pool's thread limit wait in the queue until a thread is available.
+class MapImageExportQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MapImageExportQueue(QObject *parent = nullptr);
+    ~MapImageExportQueue();
+
+    void enqueue(MapImageExportJob *job);
+    void cancel(MapImageExportJob *job);
+    void cancelAll();
+
+    int numJobs() const { return m_jobs.length(); }
+    QList<MapImageExportJob*> jobs() const;
+
+signals:
+    void jobProgressChanged(MapImageExportJob *job, int value, int maximum, const QString &label);
+    void jobFinished(MapImageExportJob *job);
+
+private:
+    QThreadPool m_pool;
+    QList<QPointer<MapImageExportJob>> m_jobs;
+
+    void onJobFinished(MapImageExportJob *job);
+};
+
+#endif // MAPIMAGEEXPORTJOB_H
@@ -54,6 +54,7 @@ public:
     QSize getSelectionDimensions() const override;
     void draw() override;
     void refresh();
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
     bool select(uint16_t metatile);
     void selectFromMap(uint16_t metatileId, uint16_t collision, uint16_t elevation);
@@ -77,6 +78,12 @@ protected:
 private:
     const int numMetatilesWide;
     QPixmap basePixmap;
+    QPixmap mipPixmap;
+    qint64 mipPixmapKey = 0;
+    qint64 mipBasePixmapKey = 0;
+    int mipPixmapLevel = 0;
+    QRect mipDirtyRect;
+    QRect drawnSelectionRect;
     bool externalSelection;
     bool prefabSelection;
     Layout *layout;
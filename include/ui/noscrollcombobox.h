@@ -2,6 +2,10 @@
 #define NOSCROLLCOMBOBOX_H
 
 #include <QComboBox>
+#include <QPointer>
+
+class ConstantsModel;
+class ConstantsSearchModel;
 
 class NoScrollComboBox : public QComboBox
 {
@@ -17,14 +21,22 @@ public:
     void setEditable(bool editable);
     void setLineEdit(QLineEdit *edit);
     void setFocusedScrollingEnabled(bool enabled);
+    void setConstantsModel(ConstantsModel *model, const QList<ConstantsModel*> &searchModels = {});
 
 signals:
     void editingFinished();
 
 private:
     void setItem(int index, const QString &text);
+    void beginModelChange();
+    void endModelChange();
 
     bool focusedScrollingEnabled = true;
+    QPointer<ConstantsSearchModel> searchModel;
+    QList<QMetaObject::Connection> modelConnections;
+    int modelChangeDepth = 0;
+    QString textBeforeModelChange;
+    bool signalsBlockedBeforeModelChange = false;
 };
 
 #endif // NOSCROLLCOMBOBOX_H
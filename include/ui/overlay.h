@@ -1,7 +1,10 @@
 #ifndef OVERLAY_H
 #define OVERLAY_H
 
+#include <QCache>
+#include <QHash>
 #include <QList>
+#include <QVector>
 #include <QString>
 #include <QColor>
 #include <QPainter>
@@ -15,26 +18,30 @@ public:
     OverlayItem() {}
     virtual ~OverlayItem() {};
     virtual void render(QPainter *) {};
+    // The area the item paints, relative to the overlay's position.
+    virtual QRectF boundingRect() const { return QRectF(); }
 };
 
 class OverlayText : public OverlayItem {
 public:
-    OverlayText(const QString inputText, int x, int y, QColor color, int fontSize) :
+    OverlayText(const QString inputText, int x, int y, QColor color, int fontSize, const QFont &font) :
         text(QStaticText(inputText))
     {
         this->x = x;
         this->y = y;
         this->color = color;
-        this->fontSize = fontSize;
+        this->font = font;
+        this->font.setPixelSize(fontSize);
     }
     ~OverlayText() {}
     virtual void render(QPainter *painter);
+    virtual QRectF boundingRect() const;
 private:
     const QStaticText text;
     int x;
     int y;
     QColor color;
-    int fontSize;
+    QFont font;
 };
 
 class OverlayPath : public OverlayItem {
@@ -46,6 +53,7 @@ public:
     }
     ~OverlayPath() {}
     virtual void render(QPainter *painter);
+    virtual QRectF boundingRect() const;
 private:
     QPainterPath path;
     QColor borderColor;
@@ -61,6 +69,7 @@ public:
     }
     ~OverlayPixmap() {}
     virtual void render(QPainter *painter);
+    virtual QRectF boundingRect() const;
 private:
     int x;
     int y;
@@ -79,6 +88,10 @@ public:
         this->hidden = false;
         this->opacity = 1.0;
         this->clippingRect = nullptr;
+        this->itemsChanged = false;
+        this->chunkScaleX = 0;
+        this->chunkScaleY = 0;
+        this->chunkOpacity = 0;
     }
     ~Overlay() {
         this->clearItems();
@@ -103,10 +116,10 @@ public:
     void clearClippingRect();
     void setPosition(int x, int y);
     void move(int deltaX, int deltaY);
-    void renderItems(QPainter *painter);
+    void renderItems(QPainter *painter, const QRectF &exposedRect);
     QList<OverlayItem*> getItems();
     void clearItems();
-    void addText(const QString text, int x, int y, QString colorStr, int fontSize);
+    void addText(const QString text, int x, int y, QString colorStr, int fontSize, const QFont &font);
     bool addRect(int x, int y, int width, int height, QString borderColorStr, QString fillColorStr, int rounding);
     bool addImage(int x, int y, QString filepath, bool useCache = true, int width = -1, int height = -1, int xOffset = 0, int yOffset = 0, qreal hScale = 1, qreal vScale = 1, QList<QRgb> palette = QList<QRgb>(), bool setTransparency = false);
     bool addImage(int x, int y, QImage image);
@@ -114,7 +127,27 @@ public:
 private:
     void clampAngle();
     QColor getColor(QString colorStr);
+    QTransform getTransform() const;
+    void addItem(OverlayItem *item);
+    QVector<int> getItemsInRect(const QRectF &rect) const;
+    void renderCachedChunks(QPainter *painter, const QRectF &rect, qreal scaleX, qreal scaleY);
+    QPixmap renderChunk(const QRectF &chunkRect, qreal scaleX, qreal scaleY, QPainter::RenderHints hints);
     QList<OverlayItem*> items;
+    QVector<QRectF> itemBounds;
+
+    // Spatial index of the items, so that painting only has to consider the items in the exposed area.
+    // Maps each cell of a grid to the indexes of the items that overlap it, in the order they were added.
+    QHash<quint64, QVector<int>> cells;
+    // Items that are too large to index, which are always considered.
+    QVector<int> unindexedItems;
+
+    // Layers whose items aren't changing are painted from a cache of pre-rendered chunks.
+    QCache<quint64, QPixmap> chunkCache;
+    qreal chunkScaleX;
+    qreal chunkScaleY;
+    qreal chunkOpacity;
+    bool itemsChanged;
+
     int x;
     int y;
     int angle;
@@ -133,7 +166,7 @@ public:
     Overlay() {}
     ~Overlay() {}
 
-    void renderItems(QPainter *) {}
+    void renderItems(QPainter *, const QRectF &) {}
 };
 
 #endif // QT_QML_LIB
@@ -0,0 +1,46 @@
+#ifndef PERFTRACEPANEL_H
+#define PERFTRACEPANEL_H
+
+#include <QDockWidget>
+
+class QCheckBox;
+class QLabel;
+class QTableWidget;
+class QTimer;
+
+// A dockable panel for recording a performance trace (see PerfTrace), showing a summary of where
+// the time went, and exporting the full trace to be viewed in chrome://tracing or Perfetto.
+class PerfTracePanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PerfTracePanel(QWidget *parent = nullptr);
+
+public slots:
+    void refresh();
+
+protected:
+    virtual void showEvent(QShowEvent *event) override;
+    virtual void hideEvent(QHideEvent *event) override;
+
+private:
+    enum SummaryColumn {
+        Name,
+        Count,
+        Total,
+        Average,
+        Max,
+    };
+
+    QCheckBox *m_recordCheckBox;
+    QLabel *m_statusLabel;
+    QTableWidget *m_table;
+    QTimer *m_refreshTimer;
+
+    void setRecording(bool recording);
+    void clear();
+    void exportTrace();
+};
+
+#endif // PERFTRACEPANEL_H
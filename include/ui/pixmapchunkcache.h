@@ -0,0 +1,57 @@
+#ifndef PIXMAPCHUNKCACHE_H
+#define PIXMAPCHUNKCACHE_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QHash>
+#include <functional>
+
+class QPainter;
+
+// Paints a large image by splitting it into fixed-size chunks, which are only converted to pixmaps once they're exposed.
+// For large layouts, converting the full image to a pixmap each time it changes is slow, and most of it is usually out of view.
+// Chunks that haven't been painted recently are discarded once the cache grows beyond its memory budget.
+//
+// When painted while zoomed out, chunks are created from a downsampled copy of the image (a mipmap level)
+// rather than having the full-size image scaled down on every paint, which is slow and aliases badly.
+class PixmapChunkCache
+{
+public:
+    explicit PixmapChunkCache(int chunkSize = 256, qint64 maxBytes = 64 * 1024 * 1024);
+
+    static constexpr int MaxMipLevel = 3;
+    static int mipLevel(const QPainter *painter);
+    static QImage downsample(const QImage &image, int level);
+
+    // 'prepareSource' (if given) is called with the area of 'source' a chunk covers before the chunk is created,
+    // so that the source image can be drawn lazily, one chunk at a time.
+    void paint(QPainter *painter, const QImage &source, const QRectF &exposedRect,
+               const std::function<void(const QRect &)> &prepareSource = nullptr);
+    void invalidate(const QRect &rect);
+    void clear();
+
+    int chunkSize() const { return m_chunkSize; }
+    qint64 cachedBytes() const { return m_cachedBytes; }
+
+private:
+    struct Chunk {
+        QPixmap pixmap;
+        quint64 lastPainted = 0;
+    };
+
+    const int m_chunkSize;
+    const qint64 m_maxBytes;
+    QSize m_sourceSize;
+    QHash<quint64, Chunk> m_chunks;
+    qint64 m_cachedBytes = 0;
+    quint64 m_paintCount = 0;
+
+    static quint64 chunkKey(int level, int column, int row) {
+        return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(row) << 24) | static_cast<quint64>(column);
+    }
+    static qint64 pixmapBytes(const QPixmap &pixmap) { return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8; }
+    void removeChunk(quint64 key);
+    void evict();
+};
+
+#endif // PIXMAPCHUNKCACHE_H
@@ -34,6 +34,11 @@ public:
         this->swapMetatileId = metatileIdB;
         this->isSwap = true;
     }
+    MetatileHistoryItem(const QMap<uint16_t, uint16_t> &mergedMetatileIds, const QMap<uint16_t, Metatile> &mergedMetatiles) {
+        this->mergedMetatileIds = mergedMetatileIds;
+        this->mergedMetatiles = mergedMetatiles;
+        this->isMerge = true;
+    }
     ~MetatileHistoryItem() {
         delete this->prevMetatile;
         delete this->newMetatile;
@@ -47,6 +52,11 @@ public:
 
     uint16_t swapMetatileId = 0;
     bool isSwap = false;
+
+    // Duplicate metatile IDs mapped to the metatile that replaced them, and the duplicates' original contents.
+    QMap<uint16_t, uint16_t> mergedMetatileIds;
+    QMap<uint16_t, Metatile> mergedMetatiles;
+    bool isMerge = false;
 };
 
 class TilesetEditor : public QMainWindow
@@ -83,6 +93,8 @@ private slots:
     void on_actionChange_Metatiles_Count_triggered();
 
     void on_actionChange_Palettes_triggered();
+    void on_actionCompact_Tiles_triggered();
+    void on_actionMerge_Duplicate_Metatiles_triggered();
 
     void on_actionShow_Unused_toggled(bool checked);
     void on_actionShow_Counts_toggled(bool checked);
@@ -122,6 +134,7 @@ private:
     void redrawTileSelector();
     void redrawMetatileSelector();
     void importTilesetTiles(Tileset*);
+    void importQuantizedTilesetTiles(Tileset *tileset, const QImage &image);
     void importAdvanceMapMetatiles(Tileset*);
     void exportTilesImage(Tileset*);
     void exportPorytilesLayerImages(Tileset*);
@@ -130,6 +143,7 @@ private:
     void commitMetatileLabel();
     void countMetatileUsage();
     void countTileUsage();
+    bool tilesUsedOutsideEditor(const Tileset *tileset);
     void copyMetatile(bool cut);
     void pasteMetatile(const Metatile &toPaste, QString label);
     bool replaceMetatile(uint16_t metatileId, const Metatile &src, QString label);
@@ -152,8 +166,8 @@ private:
     void setMetatileLayerOrientation(Qt::Orientation orientation);
     void commitMetatileSwap(uint16_t metatileIdA, uint16_t metatileIdB);
     bool swapMetatiles(uint16_t metatileIdA, uint16_t metatileIdB);
-    void applyMetatileSwapToLayouts(uint16_t metatileIdA, uint16_t metatileIdB);
-    void applyMetatileSwapsToLayouts();
+    void setMetatilesMerged(const MetatileHistoryItem *item, bool merged);
+    void applyMetatileIdRemapsToLayouts();
     void rebuildMetatilePropertiesFrame();
     void addWidgetToMetatileProperties(QWidget *w, int *row, int rowSpan);
     void updateLayerTileStatus();
@@ -179,7 +193,7 @@ private:
     bool lockSelection = false;
     QSet<uint16_t> metatileReloadQueue;
     MetatileImageExporter::Settings *metatileImageExportSettings = nullptr;
-    QList<QPair<uint16_t,uint16_t>> metatileIdSwaps;
+    QList<QMap<uint16_t,uint16_t>> metatileIdRemaps;
     int numLayerViewRows;
 
     bool save();
@@ -2,6 +2,7 @@
 #define WILDMONSEARCH_H
 
 #include <QDialog>
+#include <QTimer>
 
 #include "numericsorttableitem.h"
 
@@ -29,6 +30,7 @@ private:
         QString mapName;
         QString groupName;
         QString fieldName;
+        QString species;
         QString levelRange;
         QString chance;
     };
@@ -36,12 +38,12 @@ private:
     Ui::WildMonSearch *ui;
     Project *const project;
     QMap<QString,QMap<int,QString>> percentageStrings;
-    QMap<QString,QList<RowData>> resultsCache;
+    QTimer searchTimer;
 
     void addTableEntry(const RowData &rowData);
     QList<RowData> search(const QString &species) const;
     void updatePercentageStrings();
-    void updateResults(const QString &species);
+    void updateResults(const QString &text);
     void cellDoubleClicked(int row, int column);
 
 };
@@ -59,6 +59,16 @@ SOURCES += src/core/advancemapparser.cpp \
     src/core/network.cpp \
     src/core/paletteutil.cpp \
     src/core/parseutil.cpp \
+    src/core/saveplan.cpp \
+    src/core/scriptlabelindex.cpp \
+    src/core/assetindex.cpp \
+    src/core/eventspriteatlas.cpp \
+    src/core/constantsmodel.cpp \
+    src/core/wildmonindex.cpp \
+    src/core/tilecompactor.cpp \
+    src/core/metatilededuplicator.cpp \
+    src/core/tilequantizer.cpp \
+    src/core/perftrace.cpp \
     src/core/tile.cpp \
     src/core/tileset.cpp \
     src/core/utility.cpp \
@@ -75,6 +85,7 @@ SOURCES += src/core/advancemapparser.cpp \
     src/scriptapi/apioverlay.cpp \
     src/scriptapi/apiutility.cpp \
     src/scriptapi/scripting.cpp \
+    src/scriptapi/scriptworker.cpp \
     src/ui/aboutporymap.cpp \
     src/ui/checkeredbgscene.cpp \
     src/ui/colorinputwidget.cpp \
@@ -86,10 +97,12 @@ SOURCES += src/core/advancemapparser.cpp \
     src/ui/divingmappixmapitem.cpp \
     src/ui/eventpixmapitem.cpp \
     src/ui/bordermetatilespixmapitem.cpp \
+    src/ui/collisionatlas.cpp \
     src/ui/collisionpixmapitem.cpp \
     src/ui/connectionpixmapitem.cpp \
     src/ui/currentselectedmetatilespixmapitem.cpp \
     src/ui/gridsettings.cpp \
+    src/ui/mapgrid.cpp \
     src/ui/newmapconnectiondialog.cpp \
     src/ui/overlay.cpp \
     src/ui/prefab.cpp \
@@ -128,6 +141,7 @@ SOURCES += src/core/advancemapparser.cpp \
     src/ui/encountertabledelegates.cpp \
     src/ui/palettecolorsearch.cpp \
     src/ui/paletteeditor.cpp \
+    src/ui/pixmapchunkcache.cpp \
     src/ui/selectablepixmapitem.cpp \
     src/ui/tileseteditor.cpp \
     src/ui/tileseteditormetatileselector.cpp \
@@ -136,6 +150,8 @@ SOURCES += src/core/advancemapparser.cpp \
     src/ui/regionmapeditor.cpp \
     src/ui/newmapdialog.cpp \
     src/ui/mapimageexporter.cpp \
+    src/ui/mapimageexportjob.cpp \
+    src/ui/mapborderitem.cpp \
     src/ui/metatileimageexporter.cpp \
     src/ui/newtilesetdialog.cpp \
     src/ui/flowlayout.cpp \
@@ -159,7 +175,8 @@ SOURCES += src/core/advancemapparser.cpp \
     src/ui/uintspinbox.cpp \
     src/ui/updatepromoter.cpp \
     src/ui/wildmonchart.cpp \
-    src/ui/wildmonsearch.cpp
+    src/ui/wildmonsearch.cpp \
+    src/ui/perftracepanel.cpp
 
 HEADERS  += include/core/advancemapparser.h \
     include/core/block.h \
@@ -177,6 +194,16 @@ HEADERS  += include/core/advancemapparser.h \
     include/core/network.h \
     include/core/paletteutil.h \
     include/core/parseutil.h \
+    include/core/saveplan.h \
+    include/core/scriptlabelindex.h \
+    include/core/assetindex.h \
+    include/core/eventspriteatlas.h \
+    include/core/constantsmodel.h \
+    include/core/wildmonindex.h \
+    include/core/tilecompactor.h \
+    include/core/metatilededuplicator.h \
+    include/core/tilequantizer.h \
+    include/core/perftrace.h \
     include/core/tile.h \
     include/core/tileset.h \
     include/core/utility.h \
@@ -203,10 +230,12 @@ HEADERS  += include/core/advancemapparser.h \
     include/ui/divingmappixmapitem.h \
     include/ui/eventpixmapitem.h \
     include/ui/bordermetatilespixmapitem.h \
+    include/ui/collisionatlas.h \
     include/ui/collisionpixmapitem.h \
     include/ui/connectionpixmapitem.h \
     include/ui/currentselectedmetatilespixmapitem.h \
     include/ui/gridsettings.h \
+    include/ui/mapgrid.h \
     include/ui/mapheaderform.h \
     include/ui/newmapconnectiondialog.h \
     include/ui/prefabframe.h \
@@ -248,6 +277,7 @@ HEADERS  += include/core/advancemapparser.h \
     include/ui/adjustingstackedwidget.h \
     include/ui/palettecolorsearch.h \
     include/ui/paletteeditor.h \
+    include/ui/pixmapchunkcache.h \
     include/ui/selectablepixmapitem.h \
     include/ui/tileseteditor.h \
     include/ui/tileseteditormetatileselector.h \
@@ -256,6 +286,8 @@ HEADERS  += include/core/advancemapparser.h \
     include/ui/regionmapeditor.h \
     include/ui/newmapdialog.h \
     include/ui/mapimageexporter.h \
+    include/ui/mapimageexportjob.h \
+    include/ui/mapborderitem.h \
     include/ui/metatileimageexporter.h \
     include/ui/newtilesetdialog.h \
     include/ui/overlay.h \
@@ -276,13 +308,15 @@ HEADERS  += include/core/advancemapparser.h \
     include/project.h \
     include/scripting.h \
     include/scriptutility.h \
+    include/scriptworker.h \
     include/settings.h \
     include/log.h \
     include/ui/uintspinbox.h \
     include/ui/updatepromoter.h \
     include/ui/wildmonchart.h \
     include/ui/wildmonsearch.h \
-    include/ui/resizelayoutpopup.h
+    include/ui/resizelayoutpopup.h \
+    include/ui/perftracepanel.h
 
 FORMS    += forms/mainwindow.ui \
     forms/colorinputwidget.ui \
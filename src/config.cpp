@@ -351,6 +351,7 @@ void PorymapConfig::reset() {
     this->showTilesetEditorRawAttributes = false;
     this->showPaletteEditorUnusedColors = false;
     this->monitorFiles = true;
+    this->eventSpriteCacheSize = 32;
     this->tilesetCheckerboardFill = true;
     this->newMapHeaderSectionExpanded = false;
     this->theme = "default";
@@ -495,6 +496,8 @@ void PorymapConfig::parseConfigKeyValue(QString key, QString value) {
         this->showPaletteEditorUnusedColors = getConfigBool(key, value);
     } else if (key == "monitor_files") {
         this->monitorFiles = getConfigBool(key, value);
+    } else if (key == "event_sprite_cache_size") {
+        this->eventSpriteCacheSize = getConfigInteger(key, value, 1, 1024, 32);
     } else if (key == "tileset_checkerboard_fill") {
         this->tilesetCheckerboardFill = getConfigBool(key, value);
     } else if (key == "new_map_header_section_expanded") {
@@ -642,6 +645,7 @@ QMap<QString, QString> PorymapConfig::getKeyValueMap() {
     map.insert("show_tileset_editor_raw_attributes", this->showTilesetEditorRawAttributes ? "1" : "0");
     map.insert("show_palette_editor_unused_colors", this->showPaletteEditorUnusedColors ? "1" : "0");
     map.insert("monitor_files", this->monitorFiles ? "1" : "0");
+    map.insert("event_sprite_cache_size", QString::number(this->eventSpriteCacheSize));
     map.insert("tileset_checkerboard_fill", this->tilesetCheckerboardFill ? "1" : "0");
     map.insert("new_map_header_section_expanded", this->newMapHeaderSectionExpanded ? "1" : "0");
     map.insert("theme", this->theme);
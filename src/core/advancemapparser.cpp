@@ -98,7 +98,7 @@ Layout *AdvanceMapParser::parseLayout(const QString &filepath, bool *error, cons
     return mapLayout;
 }
 
-QList<Metatile*> AdvanceMapParser::parseMetatiles(const QString &filepath, bool *error, bool primaryTileset)
+QList<Metatile> AdvanceMapParser::parseMetatiles(const QString &filepath, bool *error, bool primaryTileset)
 {
     QFile file(filepath);
     if (!file.open(QIODevice::ReadOnly)) {
@@ -160,16 +160,15 @@ QList<Metatile*> AdvanceMapParser::parseMetatiles(const QString &filepath, bool
         return { };
     }
 
-    QList<Metatile*> metatiles;
+    QList<Metatile> metatiles;
     for (int i = 0; i < numMetatiles; i++) {
-        Metatile *metatile = new Metatile();
-        QList<Tile> tiles;
+        Metatile metatile;
         for (int j = 0; j < 8; j++) {
             int metatileOffset = 4 + i * metatileSize + j * 2;
             Tile tile(static_cast<uint16_t>(
                         static_cast<unsigned char>(in.at(metatileOffset)) |
                        (static_cast<unsigned char>(in.at(metatileOffset + 1)) << 8)));
-            tiles.append(tile);
+            metatile.tiles.append(tile);
         }
 
         // AdvanceMap .bvd files only contain 8 tiles of data per metatile.
@@ -177,15 +176,14 @@ QList<Metatile*> AdvanceMapParser::parseMetatiles(const QString &filepath, bool
         if (projectConfig.tripleLayerMetatilesEnabled) {
             Tile tile = Tile();
             for (int j = 0; j < 4; j++)
-                tiles.append(tile);
+                metatile.tiles.append(tile);
         }
 
         int attrOffset = 4 + (numMetatiles * metatileSize) + (i * attrSize);
         uint32_t attributes = 0;
         for (int j = 0; j < attrSize; j++)
             attributes |= static_cast<unsigned char>(in.at(attrOffset + j)) << (8 * j);
-        metatile->setAttributes(attributes, version);
-        metatile->tiles = tiles;
+        metatile.setAttributes(attributes, version);
         metatiles.append(metatile);
     }
 
@@ -0,0 +1,140 @@
+#include "assetindex.h"
+#include "log.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+
+AssetIndex::~AssetIndex() {
+    // Don't leave the directory walk running after the index is gone.
+    if (m_data.valid())
+        m_data.wait();
+}
+
+void AssetIndex::build(const QString &dir) {
+    clear();
+    QMutexLocker locker(&m_mutex);
+    m_dir = QDir::cleanPath(dir);
+    m_data = std::async(std::launch::async, &AssetIndex::scan, m_dir).share();
+}
+
+void AssetIndex::clear() {
+    QMutexLocker locker(&m_mutex);
+    if (m_data.valid())
+        m_data.wait();
+    m_data = std::shared_future<std::shared_ptr<Data>>();
+    m_dir.clear();
+}
+
+std::shared_ptr<AssetIndex::Data> AssetIndex::scan(const QString &dir) {
+    auto data = std::make_shared<Data>();
+    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+    while (it.hasNext()) {
+        addFile(data.get(), dir, it.next());
+    }
+    data->scanTime = QDateTime::currentMSecsSinceEpoch();
+    return data;
+}
+
+void AssetIndex::addFile(Data *data, const QString &dir, const QString &filepath) {
+    const QString name = filepath.mid(dir.length() + 1);
+    data->names.insert(name);
+
+    // Several files can share a snake case name. Keep the alphabetically first, so lookups don't depend on the order they're found in.
+    const QString snakeCaseName = toSnakeCase(name);
+    auto existing = data->pathsBySnakeCaseName.find(snakeCaseName);
+    if (existing == data->pathsBySnakeCaseName.end()) {
+        data->pathsBySnakeCaseName.insert(snakeCaseName, filepath);
+    } else if (filepath < existing.value()) {
+        existing.value() = filepath;
+    }
+}
+
+AssetIndex::Data *AssetIndex::data() const {
+    return m_data.valid() ? m_data.get().get() : nullptr;
+}
+
+// Returns the path of 'filepath' relative to the indexed directory, or an empty string if it's outside the indexed directory.
+QString AssetIndex::relativePath(const QString &filepath) const {
+    if (m_dir.isEmpty())
+        return QString();
+    const QString path = QDir::cleanPath(filepath);
+    if (!path.startsWith(m_dir + "/"))
+        return QString();
+    return path.mid(m_dir.length() + 1);
+}
+
+QString AssetIndex::find(const QString &filepath) const {
+    QMutexLocker locker(&m_mutex);
+    return findLocked(filepath);
+}
+
+QString AssetIndex::findLocked(const QString &filepath) const {
+    Data *index = data();
+    const QString name = relativePath(filepath);
+    if (!index || name.isEmpty())
+        return QFileInfo::exists(filepath) ? filepath : QString();
+
+    const QString path = findIndexed(index, name);
+    if (!path.isEmpty() || !rescanDirectory(index, name))
+        return path;
+    return findIndexed(index, name);
+}
+
+QString AssetIndex::findIndexed(const Data *index, const QString &name) const {
+    return index->names.contains(name) ? m_dir + "/" + name : QString();
+}
+
+// Files added after the index was built (e.g. a new sprite added while the project is open) aren't in the index.
+// When a lookup fails, read the file's directory again so that they can be found. This is limited to once every few seconds
+// per directory, so that bursts of failed lookups (e.g. searching for icons while the project loads) don't each touch the filesystem.
+// Returns true if the directory was read again.
+bool AssetIndex::rescanDirectory(Data *index, const QString &name) const {
+    static const qint64 recheckIntervalMs = 5000;
+
+    const int separatorIndex = name.lastIndexOf('/');
+    const QString dirName = (separatorIndex >= 0) ? name.left(separatorIndex) : QString();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - index->dirCheckTimes.value(dirName, index->scanTime) < recheckIntervalMs)
+        return false;
+    index->dirCheckTimes.insert(dirName, now);
+
+    const QDir dir(dirName.isEmpty() ? m_dir : QString("%1/%2").arg(m_dir).arg(dirName));
+    if (!dir.exists())
+        return false;
+    for (const auto &entry : dir.entryInfoList(QDir::Files)) {
+        addFile(index, m_dir, QDir::cleanPath(entry.filePath()));
+    }
+    return true;
+}
+
+QString AssetIndex::findFuzzy(const QString &filepath) const {
+    QMutexLocker locker(&m_mutex);
+    const QString path = findLocked(filepath);
+    if (!path.isEmpty())
+        return path;
+
+    const Data *index = data();
+    const QString name = relativePath(filepath);
+    if (!index || name.isEmpty())
+        return QString();
+    const QString fuzzyPath = index->pathsBySnakeCaseName.value(toSnakeCase(name));
+    if (!fuzzyPath.isEmpty())
+        logWarn(QString("No file matches '%1' exactly, using similarly-named '%2' instead.").arg(filepath).arg(fuzzyPath));
+    return fuzzyPath;
+}
+
+// Ex: 'pokemon/FooBar/icon.png' -> 'pokemon_foo_bar_icon'
+QString AssetIndex::toSnakeCase(const QString &name) {
+    static const QRegularExpression re_caseChange("([a-z])([A-Z0-9])");
+    QString snakeCaseName = name;
+    const int extensionIndex = snakeCaseName.lastIndexOf('.');
+    if (extensionIndex > snakeCaseName.lastIndexOf('/'))
+        snakeCaseName.truncate(extensionIndex);
+    snakeCaseName.replace(re_caseChange, "\\1_\\2");
+    snakeCaseName.replace('/', '_');
+    return snakeCaseName.toLower();
+}
@@ -0,0 +1,263 @@
+#include "constantsmodel.h"
+
+#include <QSet>
+#include <algorithm>
+
+// The most strings shown while searching. Short queries can match most of a long list, and nobody scrolls through thousands of results.
+static const int maxSearchResults = 500;
+
+// Updates the model in place. Combo boxes using the model reset their current text when the model is reset,
+// so where possible the changes are reported as row insertions or removals instead.
+void ConstantsModel::setStrings(const QStringList &strings) {
+    if (strings == m_strings && m_values.isEmpty())
+        return;
+
+    if (m_values.isEmpty()) {
+        if ((strings.length() > m_strings.length() && insertNewStrings(strings))
+         || (strings.length() < m_strings.length() && removeOldStrings(strings))) {
+            // Share the caller's list again, so that the next (likely identical) update is quick to compare.
+            m_strings = strings;
+            return;
+        }
+    }
+
+    beginResetModel();
+    m_strings = strings;
+    m_values.clear();
+    invalidateIndices();
+    endResetModel();
+}
+
+void ConstantsModel::setItems(const QStringList &strings, const QList<QVariant> &values) {
+    if (strings == m_strings && values == m_values)
+        return;
+
+    beginResetModel();
+    m_strings = strings;
+    m_values = values;
+    invalidateIndices();
+    endResetModel();
+}
+
+// Groups sorted row numbers into runs of consecutive rows, as (first, last) pairs.
+static QList<QPair<int,int>> getRowRuns(const QList<int> &rows) {
+    QList<QPair<int,int>> runs;
+    for (int row : rows) {
+        if (!runs.isEmpty() && runs.last().second == row - 1) {
+            runs.last().second = row;
+        } else {
+            runs.append(qMakePair(row, row));
+        }
+    }
+    return runs;
+}
+
+// If 'strings' is the current list with some strings added, insert them and return true. Otherwise change nothing and return false.
+bool ConstantsModel::insertNewStrings(const QStringList &strings) {
+    QList<int> insertedRows;
+    int oldRow = 0;
+    for (int row = 0; row < strings.length(); row++) {
+        if (oldRow < m_strings.length() && strings.at(row) == m_strings.at(oldRow)) {
+            oldRow++;
+        } else {
+            insertedRows.append(row);
+        }
+    }
+    if (oldRow != m_strings.length())
+        return false;
+
+    // Each run of new rows is inserted with one signal. Runs are inserted in order, so the rows before each run
+    // already match 'strings', and the list can be rebuilt from the start of 'strings' and the rest of the current list.
+    for (const auto &run : getRowRuns(insertedRows)) {
+        beginInsertRows(QModelIndex(), run.first, run.second);
+        m_strings = strings.mid(0, run.second + 1) + m_strings.mid(run.first);
+        // The indices are only rebuilt when they're next used, so this is cheap.
+        invalidateIndices();
+        endInsertRows();
+    }
+    return true;
+}
+
+// If 'strings' is the current list with some strings removed, remove them and return true. Otherwise change nothing and return false.
+bool ConstantsModel::removeOldStrings(const QStringList &strings) {
+    QList<int> removedRows;
+    int newRow = 0;
+    for (int row = 0; row < m_strings.length(); row++) {
+        if (newRow < strings.length() && m_strings.at(row) == strings.at(newRow)) {
+            newRow++;
+        } else {
+            removedRows.append(row);
+        }
+    }
+    if (newRow != strings.length())
+        return false;
+
+    // Each run of old rows is removed with one signal. Runs are removed from the end, so that the remaining row numbers stay valid.
+    const QList<QPair<int,int>> runs = getRowRuns(removedRows);
+    for (int i = runs.length() - 1; i >= 0; i--) {
+        const auto &run = runs.at(i);
+        beginRemoveRows(QModelIndex(), run.first, run.second);
+        m_strings.erase(m_strings.begin() + run.first, m_strings.begin() + run.second + 1);
+        invalidateIndices();
+        endRemoveRows();
+    }
+    return true;
+}
+
+void ConstantsModel::invalidateIndices() {
+    m_rowsByString.clear();
+    m_foldedStrings.clear();
+    m_sortedRows.clear();
+}
+
+int ConstantsModel::indexOf(const QString &string) const {
+    if (m_rowsByString.isEmpty() && !m_strings.isEmpty()) {
+        m_rowsByString.reserve(m_strings.length());
+        // Iterate backwards so that duplicates map to their first row, like QStringList::indexOf.
+        for (int row = m_strings.length() - 1; row >= 0; row--) {
+            m_rowsByString.insert(m_strings.at(row), row);
+        }
+    }
+    return m_rowsByString.value(string, -1);
+}
+
+void ConstantsModel::buildSearchIndex() const {
+    if (!m_foldedStrings.isEmpty() || m_strings.isEmpty())
+        return;
+
+    m_foldedStrings.reserve(m_strings.length());
+    m_sortedRows.reserve(m_strings.length());
+    for (int row = 0; row < m_strings.length(); row++) {
+        m_foldedStrings.append(m_strings.at(row).toCaseFolded());
+        m_sortedRows.append(row);
+    }
+    std::sort(m_sortedRows.begin(), m_sortedRows.end(), [this](int a, int b) {
+        return m_foldedStrings.at(a) < m_foldedStrings.at(b);
+    });
+}
+
+// Returns true if the characters of 'query' appear in 'string' in the same order.
+static bool isSubsequence(const QString &query, const QString &string) {
+    int i = 0;
+    for (int j = 0; i < query.length() && j < string.length(); j++) {
+        if (query.at(i) == string.at(j))
+            i++;
+    }
+    return i == query.length();
+}
+
+QStringList ConstantsModel::find(const QString &query, MatchType type, int limit) const {
+    QStringList results;
+    if (query.isEmpty() || limit <= 0)
+        return results;
+    buildSearchIndex();
+    const QString foldedQuery = query.toCaseFolded();
+
+    if (type == MatchType::Prefix) {
+        // All the strings with the prefix are next to each other in the sorted index.
+        auto it = std::lower_bound(m_sortedRows.constBegin(), m_sortedRows.constEnd(), foldedQuery, [this](int row, const QString &prefix) {
+            return m_foldedStrings.at(row) < prefix;
+        });
+        for (; it != m_sortedRows.constEnd() && results.length() < limit; it++) {
+            if (!m_foldedStrings.at(*it).startsWith(foldedQuery))
+                break;
+            results.append(m_strings.at(*it));
+        }
+        return results;
+    }
+
+    for (int row = 0; row < m_foldedStrings.length() && results.length() < limit; row++) {
+        const QString &string = m_foldedStrings.at(row);
+        if (string.startsWith(foldedQuery))
+            continue;
+        const bool contains = string.contains(foldedQuery);
+        if ((type == MatchType::Contains && contains) || (type == MatchType::Fuzzy && !contains && isSubsequence(foldedQuery, string)))
+            results.append(m_strings.at(row));
+    }
+    return results;
+}
+
+int ConstantsModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_strings.length();
+}
+
+QVariant ConstantsModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_strings.length())
+        return QVariant();
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+        return m_strings.at(index.row());
+    if (role == Qt::UserRole)
+        return m_values.value(index.row());
+    return QVariant();
+}
+
+// QComboBox::findText searches for an exact match from the first row, which we can answer with the index
+// rather than comparing against every string.
+QModelIndexList ConstantsModel::match(const QModelIndex &start, int role, const QVariant &value, int hits, Qt::MatchFlags flags) const {
+    if ((role == Qt::DisplayRole || role == Qt::EditRole)
+        && flags == Qt::MatchFlags(Qt::MatchExactly | Qt::MatchCaseSensitive)
+        && start.row() == 0 && hits == 1) {
+        QModelIndexList result;
+        const int row = indexOf(value.toString());
+        if (row >= 0) result.append(index(row));
+        return result;
+    }
+    return QAbstractListModel::match(start, role, value, hits, flags);
+}
+
+
+
+void ConstantsSearchModel::setSources(const QList<ConstantsModel*> &sources) {
+    for (const auto &source : m_sources) {
+        if (source) source->disconnect(this);
+    }
+    m_sources.clear();
+    for (const auto &source : sources) {
+        m_sources.append(source);
+        connect(source, &QAbstractItemModel::modelReset, this, &ConstantsSearchModel::updateResults);
+        connect(source, &QAbstractItemModel::rowsInserted, this, &ConstantsSearchModel::updateResults);
+        connect(source, &QAbstractItemModel::rowsRemoved, this, &ConstantsSearchModel::updateResults);
+    }
+    updateResults();
+}
+
+void ConstantsSearchModel::setQuery(const QString &query) {
+    if (m_query == query)
+        return;
+    m_query = query;
+    updateResults();
+}
+
+void ConstantsSearchModel::updateResults() {
+    QStringList results;
+    QSet<QString> seen;
+    for (auto type : {ConstantsModel::MatchType::Prefix, ConstantsModel::MatchType::Contains, ConstantsModel::MatchType::Fuzzy}) {
+        for (const auto &source : m_sources) {
+            if (!source) continue;
+            for (const auto &string : source->find(m_query, type, maxSearchResults - results.length())) {
+                if (!seen.contains(string)) {
+                    seen.insert(string);
+                    results.append(string);
+                }
+            }
+        }
+    }
+    if (results == m_results)
+        return;
+
+    beginResetModel();
+    m_results = results;
+    endResetModel();
+}
+
+int ConstantsSearchModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_results.length();
+}
+
+QVariant ConstantsSearchModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_results.length())
+        return QVariant();
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+        return m_results.at(index.row());
+    return QVariant();
+}
@@ -134,6 +134,7 @@ QString Event::typeToString(Event::Type type) {
 
 QPixmap Event::loadPixmap(Project *project) {
     this->pixmap = project ? project->getEventPixmap(this->getEventGroup()) : QPixmap();
+    this->spriteKey = 0;
     this->usesDefaultPixmap = true;
     return this->pixmap;
 }
@@ -245,7 +246,8 @@ QSet<QString> ObjectEvent::getExpectedFields() {
 }
 
 QPixmap ObjectEvent::loadPixmap(Project *project) {
-    this->pixmap = project ? project->getEventPixmap(this->gfx, this->movement) : QPixmap();
+    this->spriteKey = project ? project->getEventSpriteKey(this->gfx, this->movement) : 0;
+    this->pixmap = project ? project->getEventPixmap(this->spriteKey) : QPixmap();
     if (!this->pixmap.isNull()) {
         this->usesDefaultPixmap = false;
         return this->pixmap;
@@ -0,0 +1,229 @@
+#include "eventspriteatlas.h"
+
+#include <QPainter>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+class EventSpriteAtlas::LoadTask : public QRunnable {
+public:
+    LoadTask(EventSpriteAtlas *atlas, const QString &filepath) : m_atlas(atlas), m_filepath(filepath) {}
+
+    void run() override {
+        {
+            QMutexLocker locker(&m_atlas->m_loadMutex);
+            if (m_atlas->m_claimedSpritesheets.contains(m_filepath) || m_atlas->m_loadedBytes >= m_atlas->m_maxLoadedBytes)
+                return;
+        }
+        const QImage image(m_filepath);
+
+        // The spritesheet may have been requested (and loaded on the main thread) while we were decoding it.
+        // If keeping it would go over budget it's discarded, and it will be read normally when it's needed.
+        QMutexLocker locker(&m_atlas->m_loadMutex);
+        if (m_atlas->m_claimedSpritesheets.contains(m_filepath))
+            return;
+        const qint64 bytes = image.sizeInBytes();
+        if (m_atlas->m_loadedBytes + bytes > m_atlas->m_maxLoadedBytes)
+            return;
+        m_atlas->m_loadedSpritesheets.insert(m_filepath, image);
+        m_atlas->m_loadedBytes += bytes;
+    }
+
+private:
+    EventSpriteAtlas *const m_atlas;
+    const QString m_filepath;
+};
+
+EventSpriteAtlas::EventSpriteAtlas(qint64 maxBytes) : m_maxBytes(maxBytes), m_maxLoadedBytes(maxBytes) {
+    // Decoding spritesheets is mostly waiting on the disk, there's no need to compete with the rest of Porymap for every core.
+    m_loadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+EventSpriteAtlas::~EventSpriteAtlas() {
+    m_loadPool.clear();
+    m_loadPool.waitForDone();
+}
+
+EventSpriteAtlas::Key EventSpriteAtlas::makeKey(int gfxId, int frame, bool hFlip) {
+    if (gfxId < 0)
+        return 0;
+    return (static_cast<Key>(gfxId + 1) << 32) | (static_cast<Key>(static_cast<quint32>(frame) & 0x7FFFFFFF) << 1) | (hFlip ? 1 : 0);
+}
+
+bool EventSpriteAtlas::find(Key key, Sprite *sprite, bool countLookup) {
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        if (countLookup) m_stats.misses++;
+        return false;
+    }
+    if (countLookup) m_stats.hits++;
+    it.value().page->lastUsed = ++m_useCount;
+    if (sprite) {
+        sprite->page = &it.value().page->pixmap;
+        sprite->rect = it.value().rect;
+    }
+    return true;
+}
+
+EventSpriteAtlas::Sprite EventSpriteAtlas::insert(Key key, const QImage &image) {
+    Sprite sprite;
+    if (!key || image.isNull())
+        return sprite;
+    auto it = m_entries.constFind(key);
+    if (it != m_entries.constEnd()) {
+        sprite.page = &it.value().page->pixmap;
+        sprite.rect = it.value().rect;
+        return sprite;
+    }
+
+    QPoint pos;
+    Page *page = allocate(image.size(), &pos);
+    QPainter painter(&page->pixmap);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(pos, image);
+    painter.end();
+
+    const QRect rect(pos, image.size());
+    m_entries.insert(key, Entry{page, rect});
+    page->keys.append(key);
+    page->lastUsed = ++m_useCount;
+
+    if (m_bytes > m_maxBytes)
+        evict(page);
+
+    sprite.page = &page->pixmap;
+    sprite.rect = rect;
+    return sprite;
+}
+
+// Returns the frame as a standalone pixmap, for uses that need a QPixmap of their own (e.g. icons).
+// The pixmap is only copied out of its page once, every later request for the frame shares it.
+QPixmap EventSpriteAtlas::pixmap(Key key) {
+    auto it = m_pixmaps.constFind(key);
+    if (it != m_pixmaps.constEnd())
+        return it.value();
+
+    Sprite sprite;
+    if (!find(key, &sprite, false))
+        return QPixmap();
+    const QPixmap pixmap = sprite.page->copy(sprite.rect);
+    m_pixmaps.insert(key, pixmap);
+    return pixmap;
+}
+
+// Frames are packed into rows ("shelves") on the most recent page, and a new page is started once it's full.
+// Frames too large for a page are given a page of their own.
+EventSpriteAtlas::Page *EventSpriteAtlas::allocate(const QSize &size, QPoint *pos) {
+    Page *page = m_pages.empty() ? nullptr : m_pages.back().get();
+    if (page && size.width() <= PageSize && size.height() <= PageSize) {
+        if (page->shelfX + size.width() > PageSize || size.height() > page->shelfHeight) {
+            // Doesn't fit on the current shelf, start a new one below it.
+            if (page->shelfX > 0) {
+                page->shelfY += page->shelfHeight;
+                page->shelfX = 0;
+                page->shelfHeight = 0;
+            }
+        }
+        if (page->shelfY + size.height() <= page->pixmap.height() && page->shelfX + size.width() <= page->pixmap.width()) {
+            *pos = QPoint(page->shelfX, page->shelfY);
+            page->shelfX += size.width();
+            page->shelfHeight = qMax(page->shelfHeight, size.height());
+            return page;
+        }
+    }
+
+    auto newPage = std::make_unique<Page>();
+    newPage->pixmap = QPixmap(qMax(size.width(), static_cast<int>(PageSize)), qMax(size.height(), static_cast<int>(PageSize)));
+    newPage->pixmap.fill(Qt::transparent);
+    newPage->shelfX = size.width();
+    newPage->shelfHeight = size.height();
+    m_bytes += pageBytes(*newPage);
+    m_pages.push_back(std::move(newPage));
+
+    *pos = QPoint(0, 0);
+    return m_pages.back().get();
+}
+
+// Discard the least recently used pages until the atlas is back under budget.
+// Their frames will be recreated from the spritesheets the next time they're requested.
+void EventSpriteAtlas::evict(const Page *keep) {
+    std::vector<Page *> candidates;
+    for (const auto &page : m_pages) {
+        if (page.get() != keep)
+            candidates.push_back(page.get());
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Page *a, const Page *b) { return a->lastUsed < b->lastUsed; });
+
+    QSet<const Page *> evicted;
+    for (const Page *page : candidates) {
+        if (m_bytes <= m_maxBytes)
+            break;
+        for (const Key &key : page->keys) {
+            m_entries.remove(key);
+            m_pixmaps.remove(key);
+        }
+        m_bytes -= pageBytes(*page);
+        m_stats.evictions++;
+        evicted.insert(page);
+    }
+    m_pages.erase(std::remove_if(m_pages.begin(), m_pages.end(), [&evicted](const std::unique_ptr<Page> &page) {
+        return evicted.contains(page.get());
+    }), m_pages.end());
+}
+
+void EventSpriteAtlas::clear() {
+    m_pages.clear();
+    m_entries.clear();
+    m_pixmaps.clear();
+    m_bytes = 0;
+
+    m_loadPool.clear();
+    m_loadPool.waitForDone();
+    QMutexLocker locker(&m_loadMutex);
+    m_loadedSpritesheets.clear();
+    m_claimedSpritesheets.clear();
+    m_loadedBytes = 0;
+}
+
+void EventSpriteAtlas::setMaxBytes(qint64 maxBytes) {
+    m_maxBytes = maxBytes;
+    if (m_bytes > m_maxBytes)
+        evict(nullptr);
+
+    QMutexLocker locker(&m_loadMutex);
+    m_maxLoadedBytes = maxBytes;
+    if (m_loadedBytes > m_maxLoadedBytes) {
+        // Nothing has used these yet, so there's no better order to discard them in.
+        m_loadedSpritesheets.clear();
+        m_loadedBytes = 0;
+    }
+}
+
+EventSpriteAtlas::Stats EventSpriteAtlas::stats() const {
+    Stats stats = m_stats;
+    stats.numPages = static_cast<int>(m_pages.size());
+    stats.numSprites = m_entries.size();
+    stats.bytes = m_bytes;
+    QMutexLocker locker(&m_loadMutex);
+    stats.preloadedBytes = m_loadedBytes;
+    return stats;
+}
+
+qint64 EventSpriteAtlas::pageBytes(const Page &page) {
+    return static_cast<qint64>(page.pixmap.width()) * page.pixmap.height() * page.pixmap.depth() / 8;
+}
+
+void EventSpriteAtlas::preload(const QStringList &filepaths) {
+    for (const auto &filepath : filepaths) {
+        m_loadPool.start(new LoadTask(this, filepath));
+    }
+}
+
+QImage EventSpriteAtlas::takeSpritesheet(const QString &filepath) {
+    QMutexLocker locker(&m_loadMutex);
+    m_claimedSpritesheets.insert(filepath);
+    const QImage image = m_loadedSpritesheets.take(filepath);
+    m_loadedBytes -= image.sizeInBytes();
+    return image;
+}
@@ -5,6 +5,7 @@
 #include "utility.h"
 #include "editcommands.h"
 #include "project.h"
+#include "scriptlabelindex.h"
 
 #include <QTime>
 #include <QPainter>
@@ -12,6 +13,7 @@
 #include <QRegularExpression>
 
 bool Map::m_fileWatchingEnabled = true;
+quint64 Map::s_connectionRenderGeneration = 0;
 
 Map::Map(QObject *parent) : QObject(parent)
 {
@@ -29,6 +31,7 @@ Map::Map(const Map &other, QObject *parent) : Map(parent) {
     m_sharedEventsMap = other.m_sharedEventsMap;
     m_sharedScriptsMap = other.m_sharedScriptsMap;
     m_customAttributes = other.m_customAttributes;
+    m_scriptLabelIndex = other.m_scriptLabelIndex;
     *m_header = *other.m_header;
     m_layout = other.m_layout;
     m_isPersistedToFile = false;
@@ -94,7 +97,9 @@ QRect Map::getConnectionRect(const QString &direction, Layout * fromLayout) cons
     return QRect(x, y, w, h);
 }
 
-QPixmap Map::renderConnection(const QString &direction, Layout * fromLayout) {
+// Connections are rendered incrementally. Each render is kept, and later requests only redraw the blocks that changed since.
+// Anything else that affects the render (tileset contents, palettes) must be reported with 'ignoreCache' or 'invalidateConnectionRenders'.
+QPixmap Map::renderConnection(const QString &direction, Layout * fromLayout, bool ignoreCache) {
     if (!m_layout)
         return QPixmap();
 
@@ -102,13 +107,36 @@ QPixmap Map::renderConnection(const QString &direction, Layout * fromLayout) {
     if (!bounds.isValid())
         return QPixmap();
 
-    // 'fromLayout' will be used in 'render' to get the palettes from the parent map.
+    // 'fromLayout' is used to get the palettes from the parent map.
     // Dive/Emerge connections render normally with their own palettes, so we ignore this.
     if (MapConnection::isDiving(direction))
         fromLayout = nullptr;
+    const Tileset *primaryTileset = fromLayout ? fromLayout->tileset_primary : m_layout->tileset_primary;
+    const Tileset *secondaryTileset = fromLayout ? fromLayout->tileset_secondary : m_layout->tileset_secondary;
+
+    ConnectionRender &cached = m_connectionRenders[direction];
+    if (ignoreCache
+     || cached.generation != s_connectionRenderGeneration
+     || cached.layout != m_layout
+     || cached.primaryTileset != primaryTileset
+     || cached.secondaryTileset != secondaryTileset
+     || cached.bounds != bounds
+     || cached.layerOrder != m_layout->metatileLayerOrder()
+     || cached.layerOpacity != m_layout->metatileLayerOpacity()) {
+        cached = ConnectionRender();
+        cached.bounds = bounds;
+        cached.layout = m_layout;
+        cached.primaryTileset = primaryTileset;
+        cached.secondaryTileset = secondaryTileset;
+        cached.layerOrder = m_layout->metatileLayerOrder();
+        cached.layerOpacity = m_layout->metatileLayerOpacity();
+        cached.generation = s_connectionRenderGeneration;
+    }
 
-    QPixmap connectionPixmap = m_layout->render(true, fromLayout, bounds);
-    return connectionPixmap.copy(bounds);
+    QRect changedRect = m_layout->renderArea(&cached.image, bounds, &cached.metatileIds, primaryTileset, secondaryTileset);
+    if (changedRect.isValid() || cached.pixmap.isNull())
+        cached.pixmap = QPixmap::fromImage(cached.image);
+    return cached.pixmap;
 }
 
 void Map::openScript(const QString &label) {
@@ -124,20 +152,24 @@ void Map::setSharedScriptsMap(const QString &sharedScriptsMap) {
 
 void Map::invalidateScripts() {
     m_scriptsLoaded = false;
-
-    // m_scriptFileWatcher is a QPointer so clearing it shouldn't be necessary,
-    // but it's possible that Map::getScriptLabels will be called before events are processed.
-    delete m_scriptFileWatcher;
-    m_scriptFileWatcher = nullptr;
-
     emit scriptsModified();
 }
 
+void Map::onScriptsFileChanged(const QString &filepath) {
+    if (m_scriptsLoaded && filepath == getScriptsFilepath())
+        invalidateScripts();
+}
+
 QStringList Map::getScriptLabels(Event::Group group) {
     if (!m_scriptsLoaded && m_isPersistedToFile) {
         const QString scriptsFilepath = getScriptsFilepath();
         QString error;
-        m_scriptLabels = ParseUtil::getGlobalScriptLabels(scriptsFilepath, &error);
+        if (m_scriptLabelIndex) {
+            m_scriptLabels = m_scriptLabelIndex->fileLabels(scriptsFilepath, &error);
+            connect(m_scriptLabelIndex, &ScriptLabelIndex::fileChanged, this, &Map::onScriptsFileChanged, Qt::UniqueConnection);
+        } else {
+            m_scriptLabels = ParseUtil::getGlobalScriptLabels(scriptsFilepath, &error);
+        }
 
         if (!error.isEmpty() && !m_loggedScriptsFileError) {
             logWarn(QString("Failed to read scripts file '%1' for %2: %3")
@@ -145,33 +177,10 @@ QStringList Map::getScriptLabels(Event::Group group) {
                             .arg(m_name)
                             .arg(error));
 
-            // Setting this flag here (and below) lets us skip some steps and logging if we already know it failed.
             // Script labels may be re-requested often, so we don't want to fill the log with warnings.
             m_loggedScriptsFileError = true;
         }
 
-        if (m_fileWatchingEnabled && !m_loggedScriptsFileError) {
-            if (!m_scriptFileWatcher) {
-                // Only create the file watcher when it's first needed (even an empty QFileSystemWatcher will consume system resources).
-                // The other option would be for Porymap to have a single global QFileSystemWatcher, but that has complications of its own.
-                m_scriptFileWatcher = new QFileSystemWatcher(this);
-                connect(m_scriptFileWatcher, &QFileSystemWatcher::fileChanged, this, &Map::invalidateScripts);
-            }
-            // m_scriptFileWatcher can stil be nullptr here if the inotify limit was reached on Linux.
-            // Porymap isn't using enough resources in general for this to be a problem, but the user may have lowered the inotify limit.
-            if (!m_scriptFileWatcher) {
-                logWarn(QString("Failed to add scripts file '%1' to file watcher for %2: Reached system resource limit.")
-                                .arg(Util::stripPrefix(scriptsFilepath, projectConfig.projectDir() + "/"))
-                                .arg(m_name));
-                m_loggedScriptsFileError = true;
-            } else if (!m_scriptFileWatcher->files().contains(scriptsFilepath) && !m_scriptFileWatcher->addPath(scriptsFilepath)) {
-                logWarn(QString("Failed to add scripts file '%1' to file watcher for %2.")
-                                .arg(Util::stripPrefix(scriptsFilepath, projectConfig.projectDir() + "/"))
-                                .arg(m_name));
-                m_loggedScriptsFileError = true;
-            }
-        }
-
         m_scriptsLoaded = true;
     }
 
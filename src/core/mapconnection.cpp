@@ -60,12 +60,12 @@ Map* MapConnection::targetMap() const {
     return getMap(m_targetMapName);
 }
 
-QPixmap MapConnection::render() const {
+QPixmap MapConnection::render(bool ignoreCache) const {
     auto map = targetMap();
     if (!map)
         return QPixmap();
 
-    return map->renderConnection(m_direction, m_parentMap ? m_parentMap->layout() : nullptr);
+    return map->renderConnection(m_direction, m_parentMap ? m_parentMap->layout() : nullptr, ignoreCache);
 }
 
 QImage MapConnection::renderImage() const {
@@ -4,9 +4,12 @@
 
 #include "scripting.h"
 #include "imageproviders.h"
+#include "collisionatlas.h"
 #include "utility.h"
 #include "project.h"
 #include "layoutpixmapitem.h"
+#include "saveplan.h"
+#include "perftrace.h"
 
 QList<int> Layout::s_globalMetatileLayerOrder;
 QList<float> Layout::s_globalMetatileLayerOpacity;
@@ -360,15 +363,68 @@ void Layout::magicFillCollisionElevation(int initialX, int initialY, uint16_t co
 }
 
 QPixmap Layout::render(bool ignoreCache, Layout *fromLayout, const QRect &bounds) {
-    bool changed_any = false;
+    renderImage(ignoreCache, fromLayout, bounds);
+    return QPixmap::fromImage(this->image);
+}
+
+// Updates 'image' for any blocks that changed since it was last rendered, and returns the area of the image that changed.
+// If 'bounds' is given, only the changed blocks within it are drawn. The rest are drawn once they're needed (see 'renderPendingImageBlocks').
+QRect Layout::renderImage(bool ignoreCache, Layout *fromLayout, const QRect &bounds) {
+    PERF_TRACE("Layout::renderImage");
+    const QRect changedRect = invalidateImage(ignoreCache);
+    renderPendingImageBlocks(bounds.isValid() ? bounds : this->image.rect(), fromLayout);
+    return changedRect;
+}
+
+// Records which blocks changed since 'image' was last updated, without drawing them, and returns the area of the image that changed.
+// The map view only draws the blocks that are in view, so most of a large layout may never need to be drawn.
+QRect Layout::invalidateImage(bool ignoreCache) {
+    QRect changedRect;
     if (this->image.isNull() || this->image.width() != pixelWidth() || this->image.height() != pixelHeight()) {
         this->image = QImage(pixelWidth(), pixelHeight(), QImage::Format_RGBA8888);
-        changed_any = true;
+        this->image.fill(Qt::transparent);
+        changedRect = this->image.rect();
+        ignoreCache = true;
     }
     if (this->blockdata.isEmpty() || this->width == 0 || this->height == 0) {
-        this->pixmap = this->pixmap.fromImage(this->image);
-        return this->pixmap;
+        return changedRect;
+    }
+    if (this->pendingImageBlocks.size() != this->blockdata.length()) {
+        this->pendingImageBlocks = QBitArray(this->blockdata.length());
+        this->numPendingImageBlocks = 0;
+        ignoreCache = true;
+    }
+
+    for (int i = 0; i < this->blockdata.length(); i++) {
+        if (!ignoreCache && !layoutBlockChanged(i, this->blockdata, this->cached_blockdata)) {
+            continue;
+        }
+        if (!this->pendingImageBlocks.testBit(i)) {
+            this->pendingImageBlocks.setBit(i);
+            this->numPendingImageBlocks++;
+        }
+        int x = (i % this->width) * Metatile::pixelWidth();
+        int y = (i / this->width) * Metatile::pixelHeight();
+        changedRect |= QRect(x, y, Metatile::pixelWidth(), Metatile::pixelHeight());
+    }
+    if (changedRect.isValid()) {
+        cacheBlockdata();
+    }
+    return changedRect;
+}
+
+// Draws any pending blocks (see 'invalidateImage') within 'bounds' (in pixels) to 'image'.
+void Layout::renderPendingImageBlocks(const QRect &bounds, Layout *fromLayout) {
+    const QRect area = bounds & this->image.rect();
+    if (this->numPendingImageBlocks <= 0 || area.isEmpty() || this->width == 0) {
+        return;
     }
+    PERF_TRACE("Layout::renderPendingImageBlocks");
+
+    const int left = area.left() / Metatile::pixelWidth();
+    const int top = area.top() / Metatile::pixelHeight();
+    const int right = area.right() / Metatile::pixelWidth();
+    const int bottom = area.bottom() / Metatile::pixelHeight();
 
     // There are a lot of external changes that can invalidate a general metatile image cache.
     // However, during a single pass at rendering the layout there shouldn't be any changes to
@@ -377,73 +433,149 @@ QPixmap Layout::render(bool ignoreCache, Layout *fromLayout, const QRect &bounds
     QHash<uint16_t, QImage> imageCache;
 
     QPainter painter(&this->image);
-    for (int i = 0; i < this->blockdata.length(); i++) {
-        if (!ignoreCache && !layoutBlockChanged(i, this->blockdata, this->cached_blockdata)) {
-            continue;
-        }
-        int x = this->width ? ((i % this->width) * Metatile::pixelWidth()) : 0;
-        int y = this->width ? ((i / this->width) * Metatile::pixelHeight()) : 0;
-        if (bounds.isValid() && !bounds.contains(x, y)) {
+    // Blocks replace whatever was drawn there before, even if their metatile isn't fully opaque.
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int y = top; y <= bottom; y++)
+    for (int x = left; x <= right; x++) {
+        const int i = y * this->width + x;
+        if (i >= this->pendingImageBlocks.size() || !this->pendingImageBlocks.testBit(i)) {
             continue;
         }
+        this->pendingImageBlocks.clearBit(i);
+        this->numPendingImageBlocks--;
 
         uint16_t metatileId = this->blockdata.at(i).metatileId();
-        QImage metatileImage;
-        if (imageCache.contains(metatileId)) {
-            metatileImage = imageCache.value(metatileId);
-        } else {
-            metatileImage = getMetatileImage(
+        auto it = imageCache.find(metatileId);
+        if (it == imageCache.end()) {
+            it = imageCache.insert(metatileId, getMetatileImage(
                 metatileId,
                 fromLayout ? fromLayout->tileset_primary   : this->tileset_primary,
                 fromLayout ? fromLayout->tileset_secondary : this->tileset_secondary,
                 metatileLayerOrder(),
                 metatileLayerOpacity()
-            );
-            imageCache.insert(metatileId, metatileImage);
+            ));
         }
-        painter.drawImage(x, y, metatileImage);
-        changed_any = true;
+        painter.drawImage(x * Metatile::pixelWidth(), y * Metatile::pixelHeight(), it.value());
     }
-    painter.end();
-    if (changed_any) {
-        cacheBlockdata();
-        this->pixmap = this->pixmap.fromImage(this->image);
+}
+
+// Returns a small preview of the layout that fits in 'maxSize', where each pixel is the average color of the metatile at that position.
+// Unlike scaling down 'image', this doesn't need every block of the layout to have been drawn.
+QImage Layout::renderThumbnail(const QSize &maxSize) const {
+    if (this->blockdata.isEmpty() || this->width <= 0 || this->height <= 0 || maxSize.isEmpty()) {
+        return QImage();
+    }
+    const QSize size = QSize(this->width, this->height).scaled(maxSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+
+    QImage thumbnail(size, QImage::Format_RGBA8888);
+    QHash<uint16_t, QRgb> colors;
+    for (int y = 0; y < size.height(); y++)
+    for (int x = 0; x < size.width(); x++) {
+        const int i = (y * this->height / size.height()) * this->width + (x * this->width / size.width());
+        if (i >= this->blockdata.length()) {
+            thumbnail.setPixel(x, y, qRgba(0, 0, 0, 0));
+            continue;
+        }
+        const uint16_t metatileId = this->blockdata.at(i).metatileId();
+        auto it = colors.find(metatileId);
+        if (it == colors.end()) {
+            const QImage metatileImage = getMetatileImage(metatileId, this->tileset_primary, this->tileset_secondary,
+                                                          metatileLayerOrder(), metatileLayerOpacity());
+            const QRgb color = metatileImage.isNull() ? qRgba(0, 0, 0, 0)
+                                                      : metatileImage.scaled(1, 1, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).pixel(0, 0);
+            it = colors.insert(metatileId, color);
+        }
+        thumbnail.setPixel(x, y, it.value());
     }
+    return thumbnail;
+}
+
+// Renders the area of the layout within 'bounds' (in pixels) to 'areaImage', which covers only that area.
+// Unlike 'renderImage' this doesn't touch the layout's own image, and the tilesets to render with are given explicitly.
+// 'cachedMetatileIds' holds the metatile IDs that were last rendered to 'areaImage'; only blocks whose metatile changed since then are redrawn.
+// Returns the area of 'areaImage' that changed.
+QRect Layout::renderArea(QImage *areaImage, const QRect &bounds, QVector<uint16_t> *cachedMetatileIds,
+                         const Tileset *primaryTileset, const Tileset *secondaryTileset) const {
+    PERF_TRACE("Layout::renderArea");
+    const QRect area = bounds & QRect(0, 0, pixelWidth(), pixelHeight());
+    if (!areaImage || !cachedMetatileIds || area.isEmpty() || this->blockdata.isEmpty())
+        return QRect();
+
+    const int left = area.left() / Metatile::pixelWidth();
+    const int top = area.top() / Metatile::pixelHeight();
+    const int right = area.right() / Metatile::pixelWidth();
+    const int bottom = area.bottom() / Metatile::pixelHeight();
+    const int numBlocks = (right - left + 1) * (bottom - top + 1);
+
+    QRect changedRect;
+    if (areaImage->size() != bounds.size() || cachedMetatileIds->length() != numBlocks) {
+        *areaImage = QImage(bounds.size(), QImage::Format_RGBA8888);
+        areaImage->fill(Qt::transparent);
+        cachedMetatileIds->fill(0xFFFF, numBlocks);
+        changedRect = areaImage->rect();
+    }
+
+    QHash<uint16_t, QImage> imageCache;
+    QPainter painter(areaImage);
+    int n = 0;
+    for (int y = top; y <= bottom; y++)
+    for (int x = left; x <= right; x++, n++) {
+        const int i = y * this->width + x;
+        if (i >= this->blockdata.length())
+            continue;
+        const uint16_t metatileId = this->blockdata.at(i).metatileId();
+        if (!changedRect.isValid() && cachedMetatileIds->at(n) == metatileId)
+            continue;
+        (*cachedMetatileIds)[n] = metatileId;
 
-    return this->pixmap;
+        auto it = imageCache.find(metatileId);
+        if (it == imageCache.end())
+            it = imageCache.insert(metatileId, getMetatileImage(metatileId, primaryTileset, secondaryTileset, metatileLayerOrder(), metatileLayerOpacity()));
+        const QRect blockRect(x * Metatile::pixelWidth() - bounds.x(), y * Metatile::pixelHeight() - bounds.y(),
+                              Metatile::pixelWidth(), Metatile::pixelHeight());
+        painter.drawImage(blockRect.topLeft(), it.value());
+        changedRect |= blockRect;
+    }
+    painter.end();
+    return changedRect & areaImage->rect();
 }
 
-QPixmap Layout::renderCollision(bool ignoreCache) {
-    bool changed_any = false;
+// Updates 'collision_image' for any blocks that changed since it was last rendered, and returns the area of the image that changed.
+// The opacity is applied to the image itself (see CollisionAtlas), so it should be displayed fully opaque.
+QRect Layout::renderCollisionImage(bool ignoreCache, qreal opacity) {
+    PERF_TRACE("Layout::renderCollisionImage");
+    QRect changedRect;
     if (collision_image.isNull() || collision_image.width() != pixelWidth() || collision_image.height() != pixelHeight()) {
         collision_image = QImage(pixelWidth(), pixelHeight(), QImage::Format_RGBA8888);
-        changed_any = true;
+        collision_image.fill(Qt::transparent);
+        changedRect = collision_image.rect();
     }
     if (this->blockdata.isEmpty() || this->width == 0 || this->height == 0) {
-        collision_pixmap = collision_pixmap.fromImage(collision_image);
-        return collision_pixmap;
+        return changedRect;
+    }
+
+    // Every block needs to be drawn again if the opacity or the collision icons changed since the last render.
+    auto atlas = CollisionAtlas::get(opacity);
+    if (atlas != this->collision_atlas) {
+        this->collision_atlas = atlas;
+        ignoreCache = true;
     }
-    QPainter painter(&collision_image);
+
     for (int i = 0; i < this->blockdata.length(); i++) {
         if (!ignoreCache && !layoutBlockChanged(i, this->blockdata, this->cached_collision)) {
             continue;
         }
-        changed_any = true;
-        Block block = this->blockdata.at(i);
-        QImage collision_metatile_image = getCollisionMetatileImage(block);
-        int x = this->width ? ((i % this->width) * Metatile::pixelWidth()) : 0;
-        int y = this->width ? ((i / this->width) * Metatile::pixelHeight()) : 0;
-        painter.drawImage(x, y, collision_metatile_image);
+        int x = (i % this->width) * Metatile::pixelWidth();
+        int y = (i / this->width) * Metatile::pixelHeight();
+        atlas->drawBlock(&collision_image, x, y, this->blockdata.at(i));
+        changedRect |= QRect(x, y, Metatile::pixelWidth(), Metatile::pixelHeight());
     }
-    painter.end();
     cacheCollision();
-    if (changed_any) {
-        collision_pixmap = collision_pixmap.fromImage(collision_image);
-    }
-    return collision_pixmap;
+    return changedRect;
 }
 
 QPixmap Layout::renderBorder(bool ignoreCache) {
+    PERF_TRACE("Layout::renderBorder");
     bool changed_any = false, border_resized = false;
     int pixelWidth = this->border_width * Metatile::pixelWidth();
     int pixelHeight = this->border_height * Metatile::pixelHeight();
@@ -481,15 +613,12 @@ QPixmap Layout::renderBorder(bool ignoreCache) {
     return this->border_pixmap;
 }
 
-QPixmap Layout::getLayoutItemPixmap() {
-    return this->layoutItem ? this->layoutItem->pixmap() : QPixmap();
-}
-
 bool Layout::hasUnsavedChanges() const {
     return !this->editHistory.isClean() || this->hasUnsavedDataChanges || !this->newFolderPath.isEmpty();
 }
 
-bool Layout::save(const QString &root) {
+// If 'plan' is given the layout's files are only queued, and the layout is marked clean once the plan has written them.
+bool Layout::save(const QString &root, SavePlan *plan) {
     if (!this->newFolderPath.isEmpty()) {
         // Layout directory doesn't exist yet, create it now.
         const QString fullPath = QString("%1/%2").arg(root).arg(this->newFolderPath);
@@ -500,37 +629,23 @@ bool Layout::save(const QString &root) {
         this->newFolderPath = QString();
     }
 
-    bool success = true;
-    if (!saveBorder(root)) success = false;
-    if (!saveBlockdata(root)) success = false;
-    if (!success)
-        return false;
+    const QList<QPair<QString, QByteArray>> files = {
+        qMakePair(QString("%1/%2").arg(root).arg(this->border_path), this->border.serialize()),
+        qMakePair(QString("%1/%2").arg(root).arg(this->blockdata_path), this->blockdata.serialize()),
+    };
 
-    this->editHistory.setClean();
-    this->hasUnsavedDataChanges = false;
-    return true;
-}
-
-bool Layout::saveBorder(const QString &root) {
-    QString path = QString("%1/%2").arg(root).arg(this->border_path);
-    return writeBlockdata(path, this->border);
-}
+    auto setClean = [this] {
+        this->editHistory.setClean();
+        this->hasUnsavedDataChanges = false;
+    };
 
-bool Layout::saveBlockdata(const QString &root) {
-    QString path = QString("%1/%2").arg(root).arg(this->blockdata_path);
-    return writeBlockdata(path, this->blockdata);
-}
-
-bool Layout::writeBlockdata(const QString &path, const Blockdata &blockdata) const {
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) {
-        logError(QString("Failed to write '%1' for %2: %3").arg(path).arg(this->name).arg(file.errorString()));
-        return false;
+    if (plan) {
+        plan->addFiles(files, setClean);
+        return true;
     }
-
-    QByteArray data = blockdata.serialize();
-    file.write(data);
-    return true;
+    SavePlan localPlan;
+    localPlan.addFiles(files, setClean);
+    return localPlan.write();
 }
 
 bool Layout::loadBorder(const QString &root) {
@@ -2,6 +2,7 @@
 #include "tileset.h"
 #include "project.h"
 #include "utility.h"
+#include "log.h"
 
 // Stores how each attribute should be laid out for all metatiles, according to the vanilla games.
 // Used to set default config values and import maps with AdvanceMap.
@@ -18,7 +19,17 @@ static const QMap<Metatile::Attr, BitPacker> attributePackersRSE = {
     {Metatile::Attr::LayerType,     BitPacker(0xF000) },
 };
 
-static QMap<Metatile::Attr, BitPacker> attributePackers;
+// The project's attribute layout, indexed by Metatile::Attr.
+// Kept as a flat array (rather than a map) because it's consulted for every attribute read.
+static BitPacker attributePackers[Metatile::Attr::Unused + 1];
+
+// Union of all the masks in attributePackers
+static uint32_t attributesMask = 0;
+
+void MetatileTiles::reportOverflow() {
+    Q_ASSERT_X(false, "MetatileTiles::append", "Too many tiles for a metatile");
+    logError(QString("Metatile can't have more than %1 tiles, extra tile was discarded.").arg(capacity()));
+}
 
 Metatile::Metatile(const int numTiles) {
     Tile tile = Tile();
@@ -60,22 +71,13 @@ QString Metatile::getLayerName(int layerNum) {
     return layerTitles.value(layerNum);
 }
 
-// Read and pack together this metatile's attributes.
-uint32_t Metatile::getAttributes() const {
-    uint32_t data = 0;
-    for (auto i = this->attributes.cbegin(), end = this->attributes.cend(); i != end; i++){
-        const auto packer = attributePackers.value(i.key());
-        data |= packer.pack(i.value());
-    }
-    return data;
+uint32_t Metatile::getAttribute(Metatile::Attr attr) const {
+    return attributePackers[attr].unpack(m_attributes);
 }
 
-// Unpack and insert metatile attributes from the given data.
+// Insert metatile attributes from the given data. Bits that don't belong to any attribute are discarded.
 void Metatile::setAttributes(uint32_t data) {
-    for (auto i = attributePackers.cbegin(), end = attributePackers.cend(); i != end; i++){
-        const auto packer = i.value();
-        this->setAttribute(i.key(), packer.unpack(data));
-    }
+    m_attributes = data & attributesMask;
 }
 
 // Unpack and insert metatile attributes from the given data using a vanilla layout. For AdvanceMap import
@@ -89,8 +91,8 @@ void Metatile::setAttributes(uint32_t data, BaseGameVersion version) {
 
 // Set the value for a metatile attribute, and fit it within the valid value range.
 void Metatile::setAttribute(Metatile::Attr attr, uint32_t value) {
-    const auto packer = attributePackers.value(attr);
-    this->attributes.insert(attr, packer.clamp(value));
+    const BitPacker &packer = attributePackers[attr];
+    m_attributes = (m_attributes & ~packer.mask()) | packer.pack(packer.clamp(value));
 }
 
 int Metatile::getDefaultAttributesSize(BaseGameVersion version) {
@@ -127,8 +129,7 @@ void Metatile::setLayout(Project * project) {
     unusedMask &= Metatile::getMaxAttributesMask();
 
     BitPacker packer = BitPacker(unusedMask);
-    attributePackers.clear();
-    attributePackers.insert(Metatile::Attr::Unused, unusedMask);
+    attributePackers[Metatile::Attr::Unused] = packer;
 
     // Validate metatile behavior mask
     packer.setMask(behaviorMask);
@@ -139,7 +140,7 @@ void Metatile::setLayout(Project * project) {
                             .arg(Util::toHexString(behaviorMask))
                             .arg(Util::toHexString(maxBehavior)));
     }
-    attributePackers.insert(Metatile::Attr::Behavior, packer);
+    attributePackers[Metatile::Attr::Behavior] = packer;
 
     // Validate terrain type mask
     packer.setMask(terrainTypeMask);
@@ -151,7 +152,7 @@ void Metatile::setLayout(Project * project) {
                             .arg(Util::toHexString(maxTerrainType)));
         }
     }
-    attributePackers.insert(Metatile::Attr::TerrainType, packer);
+    attributePackers[Metatile::Attr::TerrainType] = packer;
 
     // Validate encounter type mask
     packer.setMask(encounterTypeMask);
@@ -163,7 +164,7 @@ void Metatile::setLayout(Project * project) {
                             .arg(Util::toHexString(maxEncounterType)));
         }
     }
-    attributePackers.insert(Metatile::Attr::EncounterType, packer);
+    attributePackers[Metatile::Attr::EncounterType] = packer;
 
     // Validate layer type mask
     packer.setMask(layerTypeMask);
@@ -173,5 +174,7 @@ void Metatile::setLayout(Project * project) {
                             .arg(Util::toHexString(layerTypeMask))
                             .arg(maxLayerType + 1));
     }
-    attributePackers.insert(Metatile::Attr::LayerType, packer);
+    attributePackers[Metatile::Attr::LayerType] = packer;
+
+    attributesMask = behaviorMask | terrainTypeMask | encounterTypeMask | layerTypeMask | unusedMask;
 }
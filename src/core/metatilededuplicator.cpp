@@ -0,0 +1,51 @@
+#include "metatilededuplicator.h"
+#include "tileset.h"
+#include "metatile.h"
+
+#include <QByteArray>
+#include <QHash>
+
+// Packs the metatile's tiles and attributes into a single key, so that identical metatiles can be found by hashing.
+static QByteArray getMetatileKey(const Metatile &metatile) {
+    QByteArray key;
+    key.reserve(metatile.tiles.length() * Tile::sizeInBytes() + sizeof(uint32_t));
+    for (const auto &tile : metatile.tiles) {
+        const uint16_t value = tile.rawValue();
+        key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    const uint32_t attributes = metatile.getAttributes();
+    key.append(reinterpret_cast<const char *>(&attributes), sizeof(attributes));
+    return key;
+}
+
+QMap<uint16_t, uint16_t> MetatileDeduplicator::findDuplicates(const Tileset *primaryTileset, const Tileset *secondaryTileset, const Options &options) {
+    QMap<uint16_t, uint16_t> duplicates;
+    QHash<QByteArray, uint16_t> primaryMetatileIds;
+    QHash<QByteArray, uint16_t> secondaryMetatileIds;
+    const Metatile emptyMetatile(projectConfig.getNumTilesInMetatile());
+
+    for (const Tileset *tileset : {primaryTileset, secondaryTileset}) {
+        if (!tileset) continue;
+        const bool isSecondary = (tileset == secondaryTileset);
+
+        for (int i = 0; i < tileset->numMetatiles(); i++) {
+            const Metatile *metatile = tileset->metatileAt(i);
+            if (*metatile == emptyMetatile)
+                continue;
+
+            const uint16_t metatileId = tileset->firstMetatileId() + i;
+            const QByteArray key = getMetatileKey(*metatile);
+            QHash<QByteArray, uint16_t> *keptMetatileIds = &primaryMetatileIds;
+            if (isSecondary && !(options.mergeSecondaryIntoPrimary && primaryMetatileIds.contains(key)))
+                keptMetatileIds = &secondaryMetatileIds;
+
+            auto it = keptMetatileIds->constFind(key);
+            if (it == keptMetatileIds->constEnd()) {
+                keptMetatileIds->insert(key, metatileId);
+            } else if (!options.pinnedMetatileIds.contains(metatileId)) {
+                duplicates.insert(metatileId, it.value());
+            }
+        }
+    }
+    return duplicates;
+}
@@ -2,11 +2,13 @@
 #include "parseutil.h"
 #include "loadingscreen.h"
 #include "utility.h"
+#include "perftrace.h"
 
 #include <QRegularExpression>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QStack>
+#include <QElapsedTimer>
 
 #include "lib/fex/lexer.h"
 #include "lib/fex/parser.h"
@@ -18,6 +20,10 @@ const QRegularExpression ParseUtil::re_globalPoryScriptLabel("\\b(script)(\\((gl
 const QRegularExpression ParseUtil::re_poryRawSection("\\b(raw)\\s*`(?<raw_script>[^`]*)");
 const QString ParseUtil::incbinRegexText(R"(INCBIN_[US][0-9][0-9]?\s*\(\s*\"(?<path>[^\"]*)\"[^\)]*\))");
 
+std::atomic<int> ParseUtil::s_numFilesRead{0};
+std::atomic<qint64> ParseUtil::s_numBytesRead{0};
+std::atomic<qint64> ParseUtil::s_readNsecs{0};
+
 ParseUtil::ParseUtil() {
     resetCDefines();
 }
@@ -64,24 +70,72 @@ void ParseUtil::updateSplashScreen(QString path) {
     porysplash->showLoadingMessage(Util::stripPrefix(path, this->root));
 }
 
+// Read the whole file at once and decode it in a single pass, rather than line-by-line.
+// Large files (e.g. the project's event scripts or big JSON files) are memory-mapped, which avoids copying them into a buffer first.
 QString ParseUtil::readTextFile(const QString &path, QString *error) {
+    PERF_TRACE("ParseUtil::readTextFile", path);
+    QElapsedTimer timer;
+    timer.start();
+
     QFile file(path);
     if (!file.open(QIODevice::ReadOnly)) {
         if (error) *error = file.errorString();
         return QString();
     }
-    QTextStream in(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    in.setCodec("UTF-8");
-#endif // Qt6 defaults to UTF-8, but setCodec is renamed to setEncoding
-    QString text = "";
-    while (!in.atEnd()) {
-        text += in.readLine() + '\n';
+
+    static const qint64 minMappedFileSize = 64 * 1024;
+    QString text;
+    qint64 size = file.size();
+    uchar *mapped = (size >= minMappedFileSize) ? file.map(0, size) : nullptr;
+    if (mapped) {
+        text = decodeText(reinterpret_cast<const char *>(mapped), size);
+        file.unmap(mapped);
+    } else {
+        const QByteArray data = file.readAll();
+        size = data.size();
+        text = decodeText(data.constData(), size);
+    }
+
+    s_numFilesRead++;
+    s_numBytesRead += size;
+    s_readNsecs += timer.nsecsElapsed();
+    PERF_COUNT("Bytes read", size);
+    return text;
+}
+
+// Decode UTF-8 text, normalizing the line endings the same way as reading it with QTextStream::readLine would.
+// "\r\n" becomes "\n", and the text always ends with a newline (unless it's empty).
+QString ParseUtil::decodeText(const char *data, qint64 size) {
+    // Skip the byte order mark, if present.
+    if (size >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF') {
+        data += 3;
+        size -= 3;
     }
+    if (size <= 0)
+        return QString("");
 
+    QString text = QString::fromUtf8(data, size);
+    if (text.contains('\r'))
+        text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    if (!text.endsWith('\n'))
+        text.append('\n');
     return text;
 }
 
+ParseUtil::ReadStats ParseUtil::readStats() {
+    ReadStats stats;
+    stats.numFiles = s_numFilesRead;
+    stats.numBytes = s_numBytesRead;
+    stats.nsecs = s_readNsecs;
+    return stats;
+}
+
+void ParseUtil::resetReadStats() {
+    s_numFilesRead = 0;
+    s_numBytesRead = 0;
+    s_readNsecs = 0;
+}
+
 // Load the specified text file, either from the cache or by reading the file.
 // Note that this doesn't insert any parsed files into the file cache, and we don't
 // want it to (we read a lot of files only once, storing them all is a waste of memory).
@@ -636,9 +690,10 @@ bool ParseUtil::gameStringToBool(const QString &gameString, bool * ok) {
 
 OrderedMap<QString, QHash<QString, QString>> ParseUtil::readCStructs(const QString &filename, const QString &label, const QHash<int, QString> &memberMap) {
     QString filePath = pathWithRoot(filename);
-    auto cParser = fex::Parser();
-    auto tokens = fex::Lexer().LexFile(filePath);
-    auto topLevelObjects = cParser.ParseTopLevelObjects(tokens);
+    fex::Parser cParser;
+    fex::Lexer lexer;
+    lexer.Open(filePath);
+    auto topLevelObjects = cParser.ParseTopLevelObjects(&lexer);
     OrderedMap<QString, QHash<QString, QString>> structs;
     for (auto it = topLevelObjects.begin(); it != topLevelObjects.end(); it++) {
         QString structLabel = QString::fromStdString(it->first);
@@ -0,0 +1,182 @@
+#include "perftrace.h"
+
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <chrono>
+#include <vector>
+
+std::atomic<bool> PerfTrace::s_enabled{false};
+
+// Each event is small, but a busy trace (e.g. painting with every metatile image traced) adds up quickly.
+// Past this limit events are only counted in the summary.
+static const int maxEvents = 1000000;
+
+namespace {
+struct Event {
+    const char *name;
+    QString detail;
+    Qt::HANDLE threadId;
+    qint64 start;
+    qint64 duration; // -1 for counters
+    qint64 value;
+};
+
+struct Totals {
+    bool isCounter = false;
+    int count = 0;
+    qint64 totalNsecs = 0;
+    qint64 maxNsecs = 0;
+    qint64 value = 0;
+};
+
+QMutex s_mutex;
+std::vector<Event> s_events;
+QHash<const char *, Totals> s_totals;
+int s_numDroppedEvents = 0;
+qint64 s_startTime = 0;
+}
+
+void PerfTrace::setEnabled(bool enabled) {
+    QMutexLocker locker(&s_mutex);
+    if (enabled && s_events.empty())
+        s_startTime = now();
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void PerfTrace::clear() {
+    QMutexLocker locker(&s_mutex);
+    s_events.clear();
+    s_events.shrink_to_fit();
+    s_totals.clear();
+    s_numDroppedEvents = 0;
+    s_startTime = now();
+}
+
+qint64 PerfTrace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PerfTrace::addEvent(const char *name, const QString &detail, qint64 start, qint64 end) {
+    const qint64 duration = end - start;
+    const Qt::HANDLE threadId = QThread::currentThreadId();
+
+    QMutexLocker locker(&s_mutex);
+    Totals &totals = s_totals[name];
+    totals.count++;
+    totals.totalNsecs += duration;
+    totals.maxNsecs = qMax(totals.maxNsecs, duration);
+
+    if (static_cast<int>(s_events.size()) < maxEvents) {
+        s_events.push_back(Event{name, detail, threadId, start, duration, 0});
+    } else {
+        s_numDroppedEvents++;
+    }
+}
+
+void PerfTrace::addCount(const char *name, qint64 delta) {
+    const qint64 time = now();
+    const Qt::HANDLE threadId = QThread::currentThreadId();
+
+    QMutexLocker locker(&s_mutex);
+    Totals &totals = s_totals[name];
+    totals.isCounter = true;
+    totals.count++;
+    totals.value += delta;
+
+    if (static_cast<int>(s_events.size()) < maxEvents) {
+        s_events.push_back(Event{name, QString(), threadId, time, -1, totals.value});
+    } else {
+        s_numDroppedEvents++;
+    }
+}
+
+QList<PerfTrace::Summary> PerfTrace::summary() {
+    QMutexLocker locker(&s_mutex);
+
+    // The same name may have been recorded from different string literals, so merge them by name.
+    QMap<QString, Summary> summaries;
+    for (auto it = s_totals.constBegin(); it != s_totals.constEnd(); it++) {
+        const QString name = QString::fromUtf8(it.key());
+        Summary &summary = summaries[name];
+        summary.name = name;
+        summary.isCounter = it.value().isCounter;
+        summary.count += it.value().count;
+        summary.totalNsecs += it.value().totalNsecs;
+        summary.maxNsecs = qMax(summary.maxNsecs, it.value().maxNsecs);
+        summary.value += it.value().value;
+    }
+    return summaries.values();
+}
+
+int PerfTrace::numDroppedEvents() {
+    QMutexLocker locker(&s_mutex);
+    return s_numDroppedEvents;
+}
+
+bool PerfTrace::exportChromeTrace(const QString &filepath, QString *error) {
+    QJsonArray traceEvents;
+    {
+        QMutexLocker locker(&s_mutex);
+
+        // Trace viewers show threads by their ID, so give them small, stable IDs (the main thread is always 1).
+        QHash<Qt::HANDLE, int> threadIds;
+        threadIds.insert(QThread::currentThreadId(), 1);
+        auto getThreadId = [&threadIds](Qt::HANDLE handle) {
+            auto it = threadIds.constFind(handle);
+            if (it != threadIds.constEnd())
+                return it.value();
+            const int id = threadIds.size() + 1;
+            threadIds.insert(handle, id);
+            return id;
+        };
+
+        for (const auto &event : s_events) {
+            QJsonObject object;
+            object["name"] = QString::fromUtf8(event.name);
+            object["pid"] = 1;
+            object["tid"] = getThreadId(event.threadId);
+            // Timestamps are in microseconds.
+            object["ts"] = static_cast<double>(event.start - s_startTime) / 1000.0;
+            if (event.duration >= 0) {
+                object["ph"] = "X";
+                object["cat"] = "porymap";
+                object["dur"] = static_cast<double>(event.duration) / 1000.0;
+                if (!event.detail.isEmpty())
+                    object["args"] = QJsonObject{{"detail", event.detail}};
+            } else {
+                object["ph"] = "C";
+                object["args"] = QJsonObject{{"value", static_cast<double>(event.value)}};
+            }
+            traceEvents.append(object);
+        }
+
+        for (auto it = threadIds.constBegin(); it != threadIds.constEnd(); it++) {
+            const QString threadName = (it.value() == 1) ? QStringLiteral("Main thread") : QString("Worker %1").arg(it.value() - 1);
+            traceEvents.append(QJsonObject{
+                {"name", "thread_name"},
+                {"ph", "M"},
+                {"pid", 1},
+                {"tid", it.value()},
+                {"args", QJsonObject{{"name", threadName}}},
+            });
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
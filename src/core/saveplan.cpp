@@ -0,0 +1,105 @@
+#include "saveplan.h"
+#include "log.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QVector>
+
+namespace {
+class WriteFileTask : public QRunnable {
+public:
+    WriteFileTask(const QString &path, const QByteArray &data, SavePlan::Result *result, QString *error)
+        : m_path(path), m_data(data), m_result(result), m_error(error) {}
+
+    void run() override {
+        *m_result = SavePlan::writeFile(m_path, m_data, m_error);
+    }
+
+private:
+    const QString m_path;
+    const QByteArray m_data;
+    SavePlan::Result *m_result;
+    QString *m_error;
+};
+}
+
+void SavePlan::addFile(const QString &path, const QByteArray &data, const std::function<void()> &onSaved) {
+    addFiles({qMakePair(path, data)}, onSaved);
+}
+
+void SavePlan::addFiles(const QList<QPair<QString, QByteArray>> &files, const std::function<void()> &onSaved) {
+    const int group = m_groupCallbacks.length();
+    m_groupCallbacks.append(onSaved);
+    for (const auto &file : files) {
+        m_files.append(File{file.first, file.second, group});
+    }
+}
+
+bool SavePlan::write(QStringList *writtenPaths) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Each task only writes to its own File, and m_files isn't resized until the pool is done.
+    if (m_files.length() == 1) {
+        m_files[0].result = writeFile(m_files[0].path, m_files[0].data, &m_files[0].error);
+    } else if (!m_files.isEmpty()) {
+        QThreadPool pool;
+        for (File &file : m_files) {
+            pool.start(new WriteFileTask(file.path, file.data, &file.result, &file.error));
+        }
+        pool.waitForDone();
+    }
+
+    bool success = true;
+    int numWritten = 0;
+    int numUnchanged = 0;
+    QVector<bool> groupSucceeded(m_groupCallbacks.length(), true);
+    for (const File &file : m_files) {
+        if (file.result == Result::Failed) {
+            logError(file.error);
+            groupSucceeded[file.group] = false;
+            success = false;
+        } else if (file.result == Result::Written) {
+            numWritten++;
+            if (writtenPaths) writtenPaths->append(file.path);
+        } else {
+            numUnchanged++;
+        }
+    }
+    for (int i = 0; i < m_groupCallbacks.length(); i++) {
+        if (groupSucceeded.at(i) && m_groupCallbacks.at(i))
+            m_groupCallbacks.at(i)();
+    }
+    if (m_files.length() > 1) {
+        logInfo(QString("Saved %1 file(s), %2 unchanged, in %3 ms").arg(numWritten).arg(numUnchanged).arg(timer.elapsed()));
+    }
+
+    m_files.clear();
+    m_groupCallbacks.clear();
+    return success;
+}
+
+// Safe to call from any thread. Errors are returned rather than logged.
+SavePlan::Result SavePlan::writeFile(const QString &path, const QByteArray &data, QString *error) {
+    QFile existingFile(path);
+    if (existingFile.exists() && existingFile.size() == data.size() && existingFile.open(QIODevice::ReadOnly)) {
+        if (existingFile.readAll() == data)
+            return Result::Unchanged;
+        existingFile.close();
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = QString("Could not open '%1' for writing: %2").arg(path).arg(file.errorString());
+        return Result::Failed;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        if (error) *error = QString("Failed to write '%1': %2").arg(path).arg(file.errorString());
+        return Result::Failed;
+    }
+    return Result::Written;
+}
@@ -0,0 +1,316 @@
+#include "scriptlabelindex.h"
+#include "parseutil.h"
+#include "saveplan.h"
+#include "log.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QRunnable>
+
+// Bump this if the format of the cache file (or the way labels are parsed) changes, so that old caches are ignored.
+static const int cacheVersion = 1;
+
+// Scanning each file is quick, so files are handed to the thread pool in batches to reduce overhead.
+static const int scanBatchSize = 16;
+
+class ScriptLabelIndex::ScanTask : public QRunnable {
+public:
+    struct File {
+        QString filepath;
+        qint64 modified;
+        qint64 size;
+    };
+
+    ScanTask(ScriptLabelIndex *index, const QList<File> &files) : m_index(index), m_files(files) {}
+
+    void run() override {
+        QList<ScanResult> results;
+        for (const File &file : m_files) {
+            ScanResult result;
+            result.filepath = file.filepath;
+
+            const QFileInfo info(file.filepath);
+            if (info.exists()) {
+                result.modified = info.lastModified().toMSecsSinceEpoch();
+                result.size = info.size();
+            }
+            if (result.modified != file.modified || result.size != file.size || file.modified < 0) {
+                if (result.modified >= 0)
+                    result.labels = ParseUtil::getGlobalScriptLabels(file.filepath);
+                result.changed = true;
+            }
+            results.append(result);
+        }
+
+        // The index waits for the thread pool in its destructor, so it's still alive here.
+        ScriptLabelIndex *index = m_index;
+        QMetaObject::invokeMethod(index, [index, results] { index->onScanFinished(results); }, Qt::QueuedConnection);
+    }
+
+private:
+    ScriptLabelIndex *const m_index;
+    const QList<File> m_files;
+};
+
+ScriptLabelIndex::ScriptLabelIndex(QObject *parent) : QObject(parent) {}
+
+ScriptLabelIndex::~ScriptLabelIndex() {
+    m_threadPool.clear();
+    m_threadPool.waitForDone();
+    if (m_cacheDirty)
+        saveCache();
+}
+
+QString ScriptLabelIndex::cacheFilepathFor(const QString &projectRoot) {
+    const QByteArray hash = QCryptographicHash::hash(QDir::cleanPath(projectRoot).toUtf8(), QCryptographicHash::Sha1);
+    return QString("%1/script_labels/%2.json")
+                .arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                .arg(QString::fromLatin1(hash.toHex()));
+}
+
+void ScriptLabelIndex::setCacheFilepath(const QString &filepath) {
+    if (m_cacheFilepath == filepath)
+        return;
+    m_cacheFilepath = filepath;
+    loadCache();
+}
+
+void ScriptLabelIndex::setGlobalFiles(const QStringList &filepaths) {
+    for (auto it = m_entries.begin(); it != m_entries.end(); it++) {
+        it.value().isGlobal = false;
+    }
+    m_globalFiles = filepaths;
+    for (const auto &filepath : m_globalFiles) {
+        m_entries[filepath].isGlobal = true;
+    }
+
+    // Any labels we have cached from the previous session are available immediately. The scan will correct them if they're out-of-date.
+    m_globalLabelsDirty = true;
+    emit globalLabelsChanged();
+
+    scan(m_globalFiles);
+}
+
+QStringList ScriptLabelIndex::globalLabels() const {
+    if (m_globalLabelsDirty) {
+        m_globalLabels.clear();
+        for (const auto &filepath : m_globalFiles) {
+            m_globalLabels.append(m_entries.value(filepath).labels);
+        }
+        m_globalLabels.sort(Qt::CaseInsensitive);
+        m_globalLabels.removeDuplicates();
+        m_globalLabelsDirty = false;
+    }
+    return m_globalLabels;
+}
+
+QStringList ScriptLabelIndex::fileLabels(const QString &filepath, QString *error) {
+    Entry &entry = m_entries[filepath];
+    entry.isRequested = true;
+
+    const QFileInfo info(filepath);
+    const qint64 modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+    const qint64 size = info.exists() ? info.size() : -1;
+    if (entry.modified < 0 || entry.modified != modified || entry.size != size) {
+        QString readError;
+        entry.labels = ParseUtil::getGlobalScriptLabels(filepath, &readError);
+        if (!readError.isEmpty()) {
+            if (error) *error = readError;
+            entry.modified = -1;
+            entry.size = -1;
+            return entry.labels;
+        }
+        entry.modified = modified;
+        entry.size = size;
+        m_cacheDirty = true;
+        if (entry.isGlobal)
+            m_globalLabelsDirty = true;
+    }
+    watchFiles({filepath});
+    return entry.labels;
+}
+
+void ScriptLabelIndex::scan(const QStringList &filepaths) {
+    QList<ScanTask::File> batch;
+    for (const auto &filepath : filepaths) {
+        if (m_scanning.contains(filepath))
+            continue;
+        m_scanning.insert(filepath);
+
+        const Entry entry = m_entries.value(filepath);
+        batch.append(ScanTask::File{filepath, entry.modified, entry.size});
+        if (batch.length() >= scanBatchSize) {
+            m_threadPool.start(new ScanTask(this, batch));
+            m_numPendingTasks++;
+            batch.clear();
+        }
+    }
+    if (!batch.isEmpty()) {
+        m_threadPool.start(new ScanTask(this, batch));
+        m_numPendingTasks++;
+    }
+}
+
+void ScriptLabelIndex::onScanFinished(const QList<ScanResult> &results) {
+    m_numPendingTasks--;
+
+    QStringList changedFiles;
+    QStringList scannedFiles;
+    QStringList rescanFiles;
+    for (const ScanResult &result : results) {
+        m_scanning.remove(result.filepath);
+        if (m_needsRescan.remove(result.filepath))
+            rescanFiles.append(result.filepath);
+
+        auto it = m_entries.find(result.filepath);
+        if (it == m_entries.end())
+            continue;
+        Entry &entry = it.value();
+        if (result.changed) {
+            entry.modified = result.modified;
+            entry.size = result.size;
+            entry.labels = result.labels;
+            m_cacheDirty = true;
+            if (entry.isGlobal)
+                m_globalLabelsDirty = m_globalLabelsChanged = true;
+            changedFiles.append(result.filepath);
+        }
+        if (entry.modified >= 0)
+            scannedFiles.append(result.filepath);
+    }
+
+    watchFiles(scannedFiles);
+    if (!rescanFiles.isEmpty())
+        scan(rescanFiles);
+
+    for (const auto &filepath : changedFiles) {
+        emit fileChanged(filepath);
+    }
+    if (m_numPendingTasks == 0) {
+        if (m_globalLabelsChanged) {
+            m_globalLabelsChanged = false;
+            emit globalLabelsChanged();
+        }
+        if (m_cacheDirty)
+            saveCache();
+    }
+}
+
+void ScriptLabelIndex::onFileChanged(const QString &filepath) {
+    // The watcher stops watching files that are deleted or replaced (which is how many editors save), so they'll be re-added after the scan.
+    if (m_fileWatcher && !m_fileWatcher->files().contains(filepath))
+        m_watchedFiles.remove(filepath);
+
+    if (m_scanning.contains(filepath)) {
+        // The scan in progress may have read the file before it changed.
+        m_needsRescan.insert(filepath);
+    } else {
+        scan({filepath});
+    }
+}
+
+void ScriptLabelIndex::setFileWatchingEnabled(bool enabled) {
+    if (m_fileWatchingEnabled == enabled)
+        return;
+    m_fileWatchingEnabled = enabled;
+    if (!enabled) {
+        delete m_fileWatcher;
+        m_fileWatcher = nullptr;
+        m_watchedFiles.clear();
+    }
+}
+
+void ScriptLabelIndex::watchFiles(const QStringList &filepaths) {
+    if (!m_fileWatchingEnabled)
+        return;
+
+    QStringList newFilepaths;
+    for (const auto &filepath : filepaths) {
+        if (!m_watchedFiles.contains(filepath))
+            newFilepaths.append(filepath);
+    }
+    if (newFilepaths.isEmpty())
+        return;
+
+    if (!m_fileWatcher) {
+        // A single watcher is shared by every script file, rather than each map watching its own.
+        m_fileWatcher = new QFileSystemWatcher(this);
+        connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &ScriptLabelIndex::onFileChanged);
+    }
+
+    // Failed paths are still recorded as watched, otherwise we'd try (and fail) to add them again after every scan.
+    const QStringList failedFilepaths = m_fileWatcher->addPaths(newFilepaths);
+    for (const auto &filepath : newFilepaths) {
+        m_watchedFiles.insert(filepath);
+    }
+    if (!failedFilepaths.isEmpty() && !m_loggedWatchError) {
+        logWarn(QString("Failed to monitor %1 script file(s) for changes. Script labels may be out-of-date until the project is reloaded.")
+                    .arg(failedFilepaths.length()));
+        m_loggedWatchError = true;
+    }
+}
+
+bool ScriptLabelIndex::loadCache() {
+    QFile file(m_cacheFilepath);
+    if (m_cacheFilepath.isEmpty() || !file.exists())
+        return false;
+    if (!file.open(QIODevice::ReadOnly)) {
+        logWarn(QString("Failed to read script label cache '%1': %2").arg(m_cacheFilepath).arg(file.errorString()));
+        return false;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != cacheVersion)
+        return false;
+
+    const QJsonObject files = root.value("files").toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); it++) {
+        if (m_entries.contains(it.key()))
+            continue;
+        const QJsonObject obj = it.value().toObject();
+        Entry &entry = m_entries[it.key()];
+        entry.modified = static_cast<qint64>(obj.value("modified").toDouble(-1));
+        entry.size = static_cast<qint64>(obj.value("size").toDouble(-1));
+        for (const auto &label : obj.value("labels").toArray()) {
+            entry.labels.append(label.toString());
+        }
+    }
+    m_globalLabelsDirty = true;
+    return true;
+}
+
+bool ScriptLabelIndex::saveCache() {
+    if (m_cacheFilepath.isEmpty())
+        return false;
+
+    // Only files that are still in use are saved, so the cache doesn't keep growing with files that have since been removed.
+    QJsonObject files;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); it++) {
+        const Entry &entry = it.value();
+        if (entry.modified < 0 || (!entry.isGlobal && !entry.isRequested))
+            continue;
+        QJsonObject obj;
+        obj["modified"] = static_cast<double>(entry.modified);
+        obj["size"] = static_cast<double>(entry.size);
+        obj["labels"] = QJsonArray::fromStringList(entry.labels);
+        files[it.key()] = obj;
+    }
+    QJsonObject root;
+    root["version"] = cacheVersion;
+    root["files"] = files;
+
+    QDir().mkpath(QFileInfo(m_cacheFilepath).absolutePath());
+    QString error;
+    if (SavePlan::writeFile(m_cacheFilepath, QJsonDocument(root).toJson(QJsonDocument::Compact), &error) == SavePlan::Result::Failed) {
+        logWarn(QString("Failed to save script label cache: %1").arg(error));
+        return false;
+    }
+    m_cacheDirty = false;
+    return true;
+}
@@ -0,0 +1,187 @@
+#include "tilecompactor.h"
+#include "tileset.h"
+#include "metatile.h"
+
+#include <QByteArray>
+#include <cstring>
+
+// The pixels of a tile as they appear with the given flips.
+static QByteArray getFlippedPixels(const uchar *pixels, bool xflip, bool yflip) {
+    QByteArray result(Tile::numPixels(), 0);
+    uchar *dest = reinterpret_cast<uchar *>(result.data());
+    for (int y = 0; y < Tile::pixelHeight(); y++) {
+        const uchar *src = pixels + (yflip ? Tile::pixelHeight() - 1 - y : y) * Tile::pixelWidth();
+        for (int x = 0; x < Tile::pixelWidth(); x++) {
+            *dest++ = src[xflip ? Tile::pixelWidth() - 1 - x : x];
+        }
+    }
+    return result;
+}
+
+// Of the 4 ways a tile can be flipped, returns the pixels of the one that sorts first. Tiles that are flipped copies
+// of each other share this key. 'orientation' is set to the flips that turn the tile into the key (bit 0 for xflip, bit 1 for yflip).
+static QByteArray getCanonicalPixels(const uchar *pixels, int *orientation) {
+    QByteArray key;
+    for (int i = 0; i < 4; i++) {
+        const QByteArray flipped = getFlippedPixels(pixels, i & 1, i & 2);
+        if (key.isEmpty() || memcmp(flipped.constData(), key.constData(), Tile::numPixels()) < 0) {
+            key = flipped;
+            *orientation = i;
+        }
+    }
+    return key;
+}
+
+TileCompactor::TileCompactor(const Tileset *primaryTileset, const Tileset *secondaryTileset, const Options &options) {
+    find(primaryTileset, secondaryTileset, options);
+}
+
+void TileCompactor::find(const Tileset *primaryTileset, const Tileset *secondaryTileset, const Options &options) {
+    struct Candidate {
+        uint16_t tileId = 0;
+        int orientation = 0;
+        bool isValid = false;
+    };
+    struct Group {
+        Candidate primary;
+        Candidate secondary;
+    };
+    struct Duplicate {
+        uint16_t tileId;
+        uint16_t keptTileId;
+        int orientation; // Flips that turn the kept tile into the duplicate.
+    };
+    QHash<QByteArray, Group> groups;
+    QList<Duplicate> duplicates;
+
+    // Tiles are compared in order, so each set of duplicates keeps its earliest tile (preferring primary tiles).
+    for (const Tileset *tileset : {primaryTileset, secondaryTileset}) {
+        if (!tileset) continue;
+        const bool isSecondary = (tileset == secondaryTileset);
+        bool compact = isSecondary ? options.compactSecondary : options.compactPrimary;
+
+        // Tiles beyond the tile limit aren't loaded, and would be lost if we rebuilt the tiles image.
+        const QImage &tilesImage = tileset->tilesImage();
+        const int numImageTiles = (tilesImage.width() / Tile::pixelWidth()) * (tilesImage.height() / Tile::pixelHeight());
+        if (numImageTiles > tileset->numTiles())
+            compact = false;
+
+        int lastPinnedIndex = -1;
+        for (const auto &tileId : options.pinnedTileIds) {
+            if (tileId >= tileset->firstTileId() && tileId < tileset->firstTileId() + tileset->numTiles())
+                lastPinnedIndex = qMax(lastPinnedIndex, tileId - tileset->firstTileId());
+        }
+
+        QList<uint16_t> *keptTiles = isSecondary ? &m_keptSecondaryTiles : &m_keptPrimaryTiles;
+        for (int i = 0; i < tileset->numTiles(); i++) {
+            const uint16_t tileId = tileset->firstTileId() + i;
+            const uchar *pixels = tileset->tilePixels(tileId);
+            if (!pixels) continue;
+
+            int orientation = 0;
+            Group &group = groups[getCanonicalPixels(pixels, &orientation)];
+            Candidate *keptTile = &group.primary;
+            if (isSecondary && !(options.mergeSecondaryIntoPrimary && group.primary.isValid))
+                keptTile = &group.secondary;
+
+            if (!keptTile->isValid) {
+                *keptTile = Candidate{tileId, orientation, true};
+                keptTiles->append(tileId);
+            } else if (compact && i > lastPinnedIndex) {
+                // Both tiles equal the key when flipped by their orientation, and flips undo themselves,
+                // so flipping the kept tile by both orientations reproduces this tile.
+                duplicates.append(Duplicate{tileId, keptTile->tileId, keptTile->orientation ^ orientation});
+            } else {
+                keptTiles->append(tileId);
+            }
+        }
+        if (isSecondary) {
+            m_numReclaimedSecondary = tileset->numTiles() - keptTiles->length();
+        } else {
+            m_numReclaimedPrimary = tileset->numTiles() - keptTiles->length();
+        }
+    }
+
+    // The remaining tiles move down to fill the gaps left by the duplicates.
+    QHash<uint16_t, uint16_t> newTileIds;
+    for (const Tileset *tileset : {primaryTileset, secondaryTileset}) {
+        if (!tileset) continue;
+        const QList<uint16_t> &keptTiles = (tileset == secondaryTileset) ? m_keptSecondaryTiles : m_keptPrimaryTiles;
+        for (int i = 0; i < keptTiles.length(); i++) {
+            const uint16_t newTileId = tileset->firstTileId() + i;
+            newTileIds.insert(keptTiles.at(i), newTileId);
+            if (newTileId != keptTiles.at(i))
+                m_remap.insert(keptTiles.at(i), Tile(newTileId, false, false, 0));
+        }
+    }
+    for (const auto &duplicate : duplicates) {
+        m_remap.insert(duplicate.tileId, Tile(newTileIds.value(duplicate.keptTileId), (duplicate.orientation & 1) != 0, (duplicate.orientation & 2) != 0, 0));
+    }
+}
+
+int TileCompactor::numReclaimedTiles(const Tileset *tileset) const {
+    if (!tileset) return 0;
+    return tileset->is_secondary ? m_numReclaimedSecondary : m_numReclaimedPrimary;
+}
+
+Tile TileCompactor::remap(const Tile &tile) const {
+    auto it = m_remap.constFind(tile.tileId);
+    if (it == m_remap.constEnd())
+        return tile;
+    Tile newTile = tile;
+    newTile.tileId = it.value().tileId;
+    newTile.xflip ^= it.value().xflip;
+    newTile.yflip ^= it.value().yflip;
+    return newTile;
+}
+
+void TileCompactor::remap(Metatile *metatile) const {
+    if (!metatile) return;
+    for (auto &tile : metatile->tiles) {
+        tile = remap(tile);
+    }
+}
+
+void TileCompactor::apply(Tileset *primaryTileset, Tileset *secondaryTileset) const {
+    if (m_remap.isEmpty())
+        return;
+
+    // Build both tiles images before changing either tileset.
+    QImage primaryTilesImage, secondaryTilesImage;
+    if (primaryTileset && m_numReclaimedPrimary > 0)
+        primaryTilesImage = buildTilesImage(primaryTileset, m_keptPrimaryTiles);
+    if (secondaryTileset && m_numReclaimedSecondary > 0)
+        secondaryTilesImage = buildTilesImage(secondaryTileset, m_keptSecondaryTiles);
+
+    for (Tileset *tileset : {primaryTileset, secondaryTileset}) {
+        if (!tileset) continue;
+        for (int i = 0; i < tileset->numMetatiles(); i++) {
+            remap(Tileset::getMetatile(tileset->firstMetatileId() + i, primaryTileset, secondaryTileset));
+        }
+    }
+    if (!primaryTilesImage.isNull())
+        primaryTileset->loadTilesImage(&primaryTilesImage);
+    if (!secondaryTilesImage.isNull())
+        secondaryTileset->loadTilesImage(&secondaryTilesImage);
+}
+
+// Lays out the given tiles in a new tiles image, keeping the width and colors of the tileset's current tiles image.
+QImage TileCompactor::buildTilesImage(const Tileset *tileset, const QList<uint16_t> &tileIds) {
+    const QImage &tilesImage = tileset->tilesImage();
+    const int tilesWide = qMax(1, tilesImage.width() / Tile::pixelWidth());
+    const int tilesHigh = qMax(1, (tileIds.length() + tilesWide - 1) / tilesWide);
+
+    QImage image(tilesWide * Tile::pixelWidth(), tilesHigh * Tile::pixelHeight(), QImage::Format_Indexed8);
+    image.setColorTable(tilesImage.colorTable());
+    image.fill(0);
+    for (int i = 0; i < tileIds.length(); i++) {
+        const uchar *pixels = tileset->tilePixels(tileIds.at(i));
+        if (!pixels) continue;
+        const int x = (i % tilesWide) * Tile::pixelWidth();
+        const int y = (i / tilesWide) * Tile::pixelHeight();
+        for (int row = 0; row < Tile::pixelHeight(); row++, pixels += Tile::pixelWidth()) {
+            memcpy(image.scanLine(y + row) + x, pixels, Tile::pixelWidth());
+        }
+    }
+    return image;
+}
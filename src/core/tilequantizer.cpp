@@ -0,0 +1,307 @@
+#include "tilequantizer.h"
+#include "tileset.h"
+
+#include <QHash>
+#include <QThread>
+#include <algorithm>
+#include <climits>
+#include <future>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+// Colors are handled as 15-bit GBA colors, which are the most precise colors the palettes can hold.
+using Color = uint16_t;
+static const int NoColor = -1; // A transparent pixel
+static const int maxTileColors = Tileset::numColorsPerPalette() - 1;
+
+static inline int colorChannel(Color color, int channel) { return (color >> (channel * 5)) & 0x1F; }
+static inline Color toColor(QRgb rgb) { return (qRed(rgb) >> 3) | ((qGreen(rgb) >> 3) << 5) | ((qBlue(rgb) >> 3) << 10); }
+// Expands each 5-bit channel to 8 bits so that the full 0-255 range is used (e.g. 31 becomes 255 rather than 248).
+static inline int expandChannel(int value) { return (value << 3) | (value >> 2); }
+static inline QRgb toRgb(Color color) { return qRgb(expandChannel(colorChannel(color, 0)), expandChannel(colorChannel(color, 1)), expandChannel(colorChannel(color, 2))); }
+
+static inline int colorDistance(Color a, Color b) {
+    int distance = 0;
+    for (int channel = 0; channel < 3; channel++) {
+        const int diff = colorChannel(a, channel) - colorChannel(b, channel);
+        distance += diff * diff;
+    }
+    return distance;
+}
+
+struct WeightedColor {
+    Color color;
+    int weight;
+};
+
+struct TileColors {
+    int pixels[Tile::numPixels()];    // The color of each pixel, or NoColor
+    std::vector<WeightedColor> colors; // Each color in the tile, and how many pixels use it
+    std::vector<Color> paletteColors;  // The colors the tile needs from its palette (sorted). At most 15.
+};
+
+// Calls 'func' for each index in [0, count), split between several threads if there's enough work.
+template <typename Func>
+static void runInParallel(int count, int minPerTask, const Func &func) {
+    const int numTasks = qBound(1, count / qMax(1, minPerTask), qMax(1, QThread::idealThreadCount()));
+    const int perTask = (count + numTasks - 1) / numTasks;
+    auto run = [&func](int start, int end) {
+        for (int i = start; i < end; i++) func(i);
+    };
+    std::vector<std::future<void>> tasks;
+    for (int start = perTask; start < count; start += perTask) {
+        tasks.push_back(std::async(std::launch::async, run, start, qMin(start + perTask, count)));
+    }
+    run(0, qMin(perTask, count));
+    for (auto &task : tasks) {
+        task.wait();
+    }
+}
+
+// Reduces the colors to at most 'maxColors' by repeatedly splitting the group of colors with the widest range
+// at its (pixel-weighted) median, then averaging each group.
+static std::vector<Color> medianCut(std::vector<WeightedColor> colors, int maxColors) {
+    std::vector<Color> result;
+    if (static_cast<int>(colors.size()) <= maxColors) {
+        for (const auto &color : colors) result.push_back(color.color);
+        return result;
+    }
+
+    struct Box {
+        int start;
+        int end;
+    };
+    std::vector<Box> boxes{Box{0, static_cast<int>(colors.size())}};
+    while (static_cast<int>(boxes.size()) < maxColors) {
+        int bestBox = -1;
+        int bestChannel = 0;
+        int bestRange = 0;
+        for (int i = 0; i < static_cast<int>(boxes.size()); i++) {
+            for (int channel = 0; channel < 3; channel++) {
+                int min = INT_MAX, max = INT_MIN;
+                for (int j = boxes[i].start; j < boxes[i].end; j++) {
+                    const int value = colorChannel(colors[j].color, channel);
+                    min = qMin(min, value);
+                    max = qMax(max, value);
+                }
+                if (max - min > bestRange) {
+                    bestBox = i;
+                    bestChannel = channel;
+                    bestRange = max - min;
+                }
+            }
+        }
+        if (bestBox < 0)
+            break; // Every group is a single color
+
+        const Box box = boxes[bestBox];
+        std::sort(colors.begin() + box.start, colors.begin() + box.end, [bestChannel](const WeightedColor &a, const WeightedColor &b) {
+            return colorChannel(a.color, bestChannel) < colorChannel(b.color, bestChannel);
+        });
+        long long totalWeight = 0;
+        for (int j = box.start; j < box.end; j++) totalWeight += colors[j].weight;
+        int split = box.start + 1;
+        long long weight = colors[box.start].weight;
+        while (split < box.end - 1 && weight * 2 < totalWeight) {
+            weight += colors[split++].weight;
+        }
+        boxes[bestBox] = Box{box.start, split};
+        boxes.push_back(Box{split, box.end});
+    }
+
+    for (const auto &box : boxes) {
+        long long sums[3] = {0, 0, 0};
+        long long totalWeight = 0;
+        for (int j = box.start; j < box.end; j++) {
+            for (int channel = 0; channel < 3; channel++) {
+                sums[channel] += static_cast<long long>(colorChannel(colors[j].color, channel)) * colors[j].weight;
+            }
+            totalWeight += colors[j].weight;
+        }
+        Color color = 0;
+        for (int channel = 0; channel < 3; channel++) {
+            const int value = totalWeight ? static_cast<int>((sums[channel] + totalWeight / 2) / totalWeight) : 0;
+            color |= (value & 0x1F) << (channel * 5);
+        }
+        result.push_back(color);
+    }
+    return result;
+}
+
+static int findNearestColor(const std::vector<Color> &palette, Color color, int *distance) {
+    int nearest = 0;
+    *distance = INT_MAX;
+    for (int i = 0; i < static_cast<int>(palette.size()); i++) {
+        const int d = colorDistance(palette[i], color);
+        if (d < *distance) {
+            *distance = d;
+            nearest = i;
+            if (d == 0) break;
+        }
+    }
+    return nearest;
+}
+
+TileQuantizer::Result TileQuantizer::quantize(const QImage &source, int numPalettes, QRgb transparentColor, bool topLeftIsTransparent) {
+    Result result;
+    numPalettes = qMax(1, numPalettes);
+    const QImage image = source.convertToFormat(QImage::Format_ARGB32);
+    const int tilesWide = image.width() / Tile::pixelWidth();
+    const int tilesHigh = image.height() / Tile::pixelHeight();
+    const int numTiles = tilesWide * tilesHigh;
+
+    // Colors that are treated as transparent, in addition to pixels that are mostly transparent.
+    std::vector<Color> transparentColors{toColor(transparentColor)};
+    if (topLeftIsTransparent && !image.isNull() && qAlpha(image.pixel(0, 0)) >= 128)
+        transparentColors.push_back(toColor(image.pixel(0, 0)));
+    auto isTransparent = [&transparentColors](QRgb rgb) {
+        return qAlpha(rgb) < 128 || std::find(transparentColors.begin(), transparentColors.end(), toColor(rgb)) != transparentColors.end();
+    };
+
+    // Read the colors of each tile. Tiles with more than 15 colors can't fit in any palette, so their colors are reduced first.
+    std::vector<TileColors> tiles(numTiles);
+    std::vector<char> tileChanged(numTiles, false);
+    runInParallel(numTiles, 64, [&](int i) {
+        TileColors &tile = tiles[i];
+        const int x = (i % tilesWide) * Tile::pixelWidth();
+        const int y = (i / tilesWide) * Tile::pixelHeight();
+        for (int row = 0; row < Tile::pixelHeight(); row++) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y + row)) + x;
+            for (int col = 0; col < Tile::pixelWidth(); col++) {
+                int &pixel = tile.pixels[row * Tile::pixelWidth() + col];
+                if (isTransparent(line[col])) {
+                    pixel = NoColor;
+                    continue;
+                }
+                const Color color = toColor(line[col]);
+                pixel = color;
+                auto it = std::find_if(tile.colors.begin(), tile.colors.end(), [color](const WeightedColor &c) { return c.color == color; });
+                if (it != tile.colors.end()) {
+                    it->weight++;
+                } else {
+                    tile.colors.push_back(WeightedColor{color, 1});
+                }
+            }
+        }
+        if (static_cast<int>(tile.colors.size()) > maxTileColors)
+            tileChanged[i] = true;
+        tile.paletteColors = medianCut(tile.colors, maxTileColors);
+        std::sort(tile.paletteColors.begin(), tile.paletteColors.end());
+        tile.paletteColors.erase(std::unique(tile.paletteColors.begin(), tile.paletteColors.end()), tile.paletteColors.end());
+    });
+
+    // Assign tiles to palettes, starting with the tiles that need the most colors. Each tile goes to the palette that needs
+    // the fewest new colors to fit it, so tiles that share colors share a palette. If a tile doesn't fit in any palette,
+    // it's added to the palette that needs the fewest new colors anyway, and that palette's colors are reduced afterwards.
+    std::vector<std::vector<Color>> palettes(numPalettes);
+    std::vector<int> tilePalettes(numTiles, 0);
+    std::vector<int> order(numTiles);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&tiles](int a, int b) {
+        return tiles[a].paletteColors.size() > tiles[b].paletteColors.size();
+    });
+    for (const int i : order) {
+        const auto &colors = tiles[i].paletteColors;
+        int best = 0;
+        int bestNewColors = INT_MAX;
+        bool bestFits = false;
+        for (int p = 0; p < numPalettes; p++) {
+            int newColors = 0;
+            for (const auto &color : colors) {
+                if (!std::binary_search(palettes[p].begin(), palettes[p].end(), color))
+                    newColors++;
+            }
+            const bool fits = static_cast<int>(palettes[p].size()) + newColors <= maxTileColors;
+            if ((fits && !bestFits)
+             || (fits == bestFits && (newColors < bestNewColors || (newColors == bestNewColors && palettes[p].size() > palettes[best].size())))) {
+                best = p;
+                bestNewColors = newColors;
+                bestFits = fits;
+            }
+        }
+        std::vector<Color> merged;
+        std::set_union(palettes[best].begin(), palettes[best].end(), colors.begin(), colors.end(), std::back_inserter(merged));
+        palettes[best] = std::move(merged);
+        tilePalettes[i] = best;
+    }
+
+    // Reduce the colors of any palettes that ended up with too many colors, using the colors of all the pixels of the palette's tiles.
+    std::vector<QHash<Color, int>> paletteWeights(numPalettes);
+    for (int i = 0; i < numTiles; i++) {
+        if (static_cast<int>(palettes[tilePalettes[i]].size()) <= maxTileColors)
+            continue;
+        for (const auto &color : tiles[i].colors) {
+            paletteWeights[tilePalettes[i]][color.color] += color.weight;
+        }
+    }
+    runInParallel(numPalettes, 1, [&](int p) {
+        if (static_cast<int>(palettes[p].size()) <= maxTileColors)
+            return;
+        std::vector<WeightedColor> colors;
+        for (auto it = paletteWeights[p].constBegin(); it != paletteWeights[p].constEnd(); it++) {
+            colors.push_back(WeightedColor{it.key(), it.value()});
+        }
+        palettes[p] = medianCut(colors, maxTileColors);
+    });
+
+    // Convert each tile's pixels to palette indices. If the tile's colors were changed, a different palette may now be a closer fit.
+    result.image = QImage(tilesWide * Tile::pixelWidth(), tilesHigh * Tile::pixelHeight(), QImage::Format_Indexed8);
+    // Non-const QImage::scanLine() may detach the image, which isn't safe to do from several threads at once.
+    // Take the pixels once here, and have each thread only write to its own tile's pixels.
+    uchar *const bits = result.image.bits();
+    const auto bytesPerLine = result.image.bytesPerLine();
+    runInParallel(numTiles, 64, [&](int i) {
+        const TileColors &tile = tiles[i];
+        auto getError = [&tile](const std::vector<Color> &palette) {
+            int error = 0;
+            for (int j = 0; j < Tile::numPixels(); j++) {
+                if (tile.pixels[j] == NoColor) continue;
+                int distance;
+                findNearestColor(palette, tile.pixels[j], &distance);
+                if (distance == INT_MAX)
+                    return INT_MAX; // Empty palette
+                error += distance;
+            }
+            return error;
+        };
+        int error = getError(palettes[tilePalettes[i]]);
+        for (int p = 0; p < numPalettes && error > 0; p++) {
+            const int paletteError = getError(palettes[p]);
+            if (paletteError < error) {
+                error = paletteError;
+                tilePalettes[i] = p;
+            }
+        }
+        if (error > 0)
+            tileChanged[i] = true;
+
+        const std::vector<Color> &palette = palettes[tilePalettes[i]];
+        const int x = (i % tilesWide) * Tile::pixelWidth();
+        const int y = (i / tilesWide) * Tile::pixelHeight();
+        for (int row = 0; row < Tile::pixelHeight(); row++) {
+            uchar *line = bits + (y + row) * bytesPerLine + x;
+            for (int col = 0; col < Tile::pixelWidth(); col++) {
+                const int pixel = tile.pixels[row * Tile::pixelWidth() + col];
+                int distance;
+                line[col] = (pixel == NoColor) ? 0 : (findNearestColor(palette, pixel, &distance) + 1);
+            }
+        }
+    });
+
+    for (const auto &palette : palettes) {
+        QList<QRgb> colors;
+        colors.append(transparentColor);
+        for (const auto &color : palette) {
+            colors.append(toRgb(color));
+        }
+        while (colors.length() < Tileset::numColorsPerPalette()) {
+            colors.append(qRgb(0, 0, 0));
+        }
+        result.palettes.append(colors);
+    }
+    result.image.setColorTable(result.palettes.first().toVector());
+    result.tilePalettes = QList<int>(tilePalettes.begin(), tilePalettes.end());
+    result.isLossless = std::none_of(tileChanged.begin(), tileChanged.end(), [](char changed) { return changed; });
+    return result;
+}
@@ -5,10 +5,13 @@
 #include "config.h"
 #include "imageproviders.h"
 #include "validator.h"
+#include "perftrace.h"
 
 #include <QPainter>
 #include <QImage>
+#include <QThread>
 #include <algorithm>
+#include <future>
 
 
 Tileset::Tileset(const Tileset &other)
@@ -25,16 +28,16 @@ Tileset::Tileset(const Tileset &other)
       metatileLabels(other.metatileLabels),
       palettes(other.palettes),
       palettePreviews(other.palettePreviews),
+      m_tilePixels(other.m_tilePixels),
+      m_numTiles(other.m_numTiles),
+      m_tilesColorTable(other.m_tilesColorTable),
       m_tilesImage(other.m_tilesImage.copy()),
-      m_hasUnsavedTilesImage(other.m_hasUnsavedTilesImage)
+      m_hasUnsavedTilesImage(other.m_hasUnsavedTilesImage),
+      m_tileColorMasks(other.m_tileColorMasks),
+      m_tileColorMasksValid(other.m_tileColorMasksValid)
 {
-    for (auto tile : other.m_tiles) {
-        m_tiles.append(tile.copy());
-    }
-
-    for (auto *metatile : other.m_metatiles) {
-        m_metatiles.append(new Metatile(*metatile));
-    }
+    reserveMetatiles(other.numMetatiles());
+    m_metatiles.assign(other.m_metatiles.cbegin(), other.m_metatiles.cend());
 }
 
 Tileset &Tileset::operator=(const Tileset &other) {
@@ -53,46 +56,43 @@ Tileset &Tileset::operator=(const Tileset &other) {
     palettes = other.palettes;
     palettePreviews = other.palettePreviews;
 
-    m_tiles.clear();
-    for (auto tile : other.m_tiles) {
-        m_tiles.append(tile.copy());
-    }
+    // The tile pixels are never modified in place, so the copies can share them.
+    m_tilePixels = other.m_tilePixels;
+    m_numTiles = other.m_numTiles;
+    m_tilesColorTable = other.m_tilesColorTable;
+    m_tileColorMasks = other.m_tileColorMasks;
+    m_tileColorMasksValid = other.m_tileColorMasksValid;
 
-    clearMetatiles();
-    for (auto *metatile : other.m_metatiles) {
-        m_metatiles.append(new Metatile(*metatile));
-    }
+    reserveMetatiles(other.numMetatiles());
+    m_metatiles.assign(other.m_metatiles.cbegin(), other.m_metatiles.cend());
 
     return *this;
 }
 
-Tileset::~Tileset() {
-    clearMetatiles();
+// Make room for at least 'count' metatiles, or the tileset's maximum number of metatiles (whichever is larger).
+// Reserving the full amount up front means pointers to metatiles remain valid as metatiles are added or removed.
+void Tileset::reserveMetatiles(int count) {
+    m_metatiles.reserve(qMax(count, maxMetatiles()));
 }
 
 void Tileset::clearMetatiles() {
-    qDeleteAll(m_metatiles);
     m_metatiles.clear();
 }
 
-void Tileset::setMetatiles(const QList<Metatile*> &metatiles) {
-    clearMetatiles();
-    m_metatiles = metatiles;
+void Tileset::setMetatiles(const QList<Metatile> &metatiles) {
+    reserveMetatiles(metatiles.length());
+    m_metatiles.assign(metatiles.cbegin(), metatiles.cend());
 }
 
-void Tileset::addMetatile(Metatile* metatile) {
-    m_metatiles.append(metatile);
+void Tileset::addMetatile(const Metatile &metatile) {
+    reserveMetatiles(numMetatiles() + 1);
+    m_metatiles.push_back(metatile);
 }
 
 void Tileset::resizeMetatiles(int newNumMetatiles) {
     if (newNumMetatiles < 0) newNumMetatiles = 0;
-    while (m_metatiles.length() > newNumMetatiles) {
-        delete m_metatiles.takeLast();
-    }
-    const int numTiles = projectConfig.getNumTilesInMetatile();
-    while (m_metatiles.length() < newNumMetatiles) {
-        m_metatiles.append(new Metatile(numTiles));
-    }
+    reserveMetatiles(newNumMetatiles);
+    m_metatiles.resize(newNumMetatiles, Metatile(projectConfig.getNumTilesInMetatile()));
 }
 
 uint16_t Tileset::firstMetatileId() const {
@@ -100,7 +100,7 @@ uint16_t Tileset::firstMetatileId() const {
 }
 
 uint16_t Tileset::lastMetatileId() const {
-    return qMax(1, firstMetatileId() + m_metatiles.length()) - 1;
+    return qMax(1, firstMetatileId() + numMetatiles()) - 1;
 }
 
 int Tileset::maxMetatiles() const {
@@ -112,7 +112,7 @@ uint16_t Tileset::firstTileId() const {
 }
 
 uint16_t Tileset::lastTileId() const {
-    return qMax(1, firstMetatileId() + m_tiles.length()) - 1;
+    return qMax(1, firstMetatileId() + m_numTiles) - 1;
 }
 
 int Tileset::maxTiles() const {
@@ -173,7 +173,10 @@ const Metatile* Tileset::getMetatile(int metatileId, const Tileset *primaryTiles
         return nullptr;
     }
     int index = Metatile::getIndexInTileset(metatileId);
-    return tileset->m_metatiles.value(index, nullptr);
+    if (index < 0 || index >= tileset->numMetatiles()) {
+        return nullptr;
+    }
+    return &tileset->m_metatiles[index];
 }
 
 // Metatile labels are stored per-tileset. When looking for a metatile label, first search in the tileset
@@ -472,15 +475,16 @@ bool Tileset::loadMetatiles() {
         numMetatiles = maxMetatiles();
     }
 
+    reserveMetatiles(numMetatiles);
     for (int i = 0; i < numMetatiles; i++) {
-        auto metatile = new Metatile;
+        Metatile metatile;
         int index = i * bytesPerMetatile;
         for (int j = 0; j < tilesPerMetatile; j++) {
             uint16_t tileRaw = static_cast<unsigned char>(data[index++]);
             tileRaw |= static_cast<unsigned char>(data[index++]) << 8;
-            metatile->tiles.append(Tile(tileRaw));
+            metatile.tiles.append(Tile(tileRaw));
         }
-        m_metatiles.append(metatile);
+        m_metatiles.push_back(metatile);
     }
     return true;
 }
@@ -496,7 +500,7 @@ bool Tileset::saveMetatiles() {
     int numTiles = projectConfig.getNumTilesInMetatile();
     for (const auto &metatile : m_metatiles) {
         for (int i = 0; i < numTiles; i++) {
-            uint16_t tile = metatile->tiles.value(i).rawValue();
+            uint16_t tile = metatile.tiles.value(i).rawValue();
             data.append(static_cast<char>(tile));
             data.append(static_cast<char>(tile >> 8));
         }
@@ -514,7 +518,7 @@ bool Tileset::loadMetatileAttributes() {
 
     QByteArray data = file.readAll();
     int attrSize = projectConfig.metatileAttributesSize;
-    int numMetatiles = m_metatiles.length();
+    int numMetatiles = this->numMetatiles();
     int numMetatileAttrs = data.length() / attrSize;
     if (numMetatileAttrs > numMetatiles) {
         logWarn(QString("%1 metatile attributes count %2 exceeds metatile count of %3. Additional attributes will be ignored.")
@@ -533,7 +537,7 @@ bool Tileset::loadMetatileAttributes() {
         uint32_t attributes = 0;
         for (int j = 0; j < attrSize; j++)
             attributes |= static_cast<unsigned char>(data.at(i * attrSize + j)) << (8 * j);
-        m_metatiles.at(i)->setAttributes(attributes);
+        m_metatiles[i].setAttributes(attributes);
     }
     return true;
 }
@@ -547,7 +551,7 @@ bool Tileset::saveMetatileAttributes() {
 
     QByteArray data;
     for (const auto &metatile : m_metatiles) {
-        uint32_t attributes = metatile->getAttributes();
+        uint32_t attributes = metatile.getAttributes();
         for (int i = 0; i < projectConfig.metatileAttributesSize; i++)
             data.append(static_cast<char>(attributes >> (8 * i)));
     }
@@ -583,6 +587,11 @@ bool Tileset::loadTilesImage(QImage *importedImage) {
         return false;
     }
 
+    // The tiles are stored as color indices, so the image must be indexed.
+    if (image.format() != QImage::Format_Indexed8) {
+        image = image.convertToFormat(QImage::Format_Indexed8, Qt::ThresholdDither);
+    }
+
     // Validate the number of colors in the image.
     int colorCount = image.colorCount();
     if (colorCount > Tileset::numColorsPerPalette()) {
@@ -596,23 +605,30 @@ bool Tileset::loadTilesImage(QImage *importedImage) {
     }
     m_tilesImage = image;
 
-    // Cut up the full tiles image into individual tile images.
-    m_tiles.clear();
-    for (int y = 0; y < image.height(); y += Tile::pixelHeight())
-    for (int x = 0; x < image.width(); x += Tile::pixelWidth()) {
-        m_tiles.append(image.copy(x, y, Tile::pixelWidth(), Tile::pixelHeight()));
-    }
-
-    if (m_tiles.length() > maxTiles()) {
+    // Cut up the full tiles image into tiles, which are stored one after another with 1 byte per pixel.
+    const int tilesWide = image.width() / Tile::pixelWidth();
+    int numTiles = tilesWide * (image.height() / Tile::pixelHeight());
+    if (numTiles > maxTiles()) {
         logWarn(QString("%1 tile count of %2 exceeds limit of %3. Additional tiles will not be displayed.")
                             .arg(this->name)
-                            .arg(m_tiles.length())
+                            .arg(numTiles)
                             .arg(maxTiles()));
 
-        // Just resize m_tiles so that numTiles() reports the correct tile count.
         // We'll leave m_tilesImage alone (it doesn't get displayed, and we don't want to delete the user's image data).
-        m_tiles = m_tiles.mid(0, maxTiles());
+        numTiles = maxTiles();
+    }
+    m_tilePixels = QByteArray(numTiles * Tile::numPixels(), 0);
+    uchar *tilePixels = reinterpret_cast<uchar *>(m_tilePixels.data());
+    for (int i = 0; i < numTiles; i++) {
+        const int x = (i % tilesWide) * Tile::pixelWidth();
+        const int y = (i / tilesWide) * Tile::pixelHeight();
+        for (int row = 0; row < Tile::pixelHeight(); row++, tilePixels += Tile::pixelWidth()) {
+            memcpy(tilePixels, image.constScanLine(y + row) + x, Tile::pixelWidth());
+        }
     }
+    m_numTiles = numTiles;
+    m_tilesColorTable = image.colorTable();
+    m_tileColorMasksValid = false;
 
     if (imported) {
         // Only set this flag once we've successfully loaded the tiles image.
@@ -675,6 +691,7 @@ bool Tileset::savePalettes() {
 }
 
 bool Tileset::load() {
+    PERF_TRACE("Tileset::load", this->name);
     bool success = true;
     if (!loadPalettes()) success = false;
     if (!loadTilesImage()) success = false;
@@ -697,84 +714,102 @@ QString Tileset::stripPrefix(const QString &fullName) {
     return QString(fullName).replace(projectConfig.getIdentifier(ProjectIdentifier::symbol_tilesets_prefix), "");
 }
 
-// Find which of the specified color IDs in 'searchColors' are not used by any of this tileset's metatiles.
-// The 'pairedTileset' may be used to get the tile images for any tiles that don't belong to this tileset.
-// If 'searchColors' is empty, it will for search for all unused colors.
-QSet<int> Tileset::getUnusedColorIds(int paletteId, const Tileset *pairedTileset, const QSet<int> &searchColors) const {
-    QSet<int> unusedColors = searchColors;
-    if (unusedColors.isEmpty()) {
-        // Search for all colors
-        for (int i = 0; i < Tileset::numColorsPerPalette(); i++) {
-            unusedColors.insert(i);
+// Scanning every tile's pixels is the expensive part of finding which colors are in use, so we only do it once
+// after the tiles change. Large tilesets are split between several threads.
+void Tileset::buildTileColorMasks() const {
+    const int numTiles = m_numTiles;
+    m_tileColorMasks.assign(numTiles, 0);
+
+    auto buildMasks = [this](int start, int end) {
+        const uchar *pixels = reinterpret_cast<const uchar *>(m_tilePixels.constData()) + start * Tile::numPixels();
+        for (int i = start; i < end; i++) {
+            uint16_t mask = 0;
+            for (int j = 0; j < Tile::numPixels(); j++, pixels++) {
+                if (*pixels < Tileset::numColorsPerPalette())
+                    mask |= (1 << *pixels);
+            }
+            m_tileColorMasks[i] = mask;
         }
+    };
+
+    static const int minTilesPerTask = 256;
+    const int numTasks = qBound(1, numTiles / minTilesPerTask, QThread::idealThreadCount());
+    const int tilesPerTask = (numTiles + numTasks - 1) / numTasks;
+    std::vector<std::future<void>> tasks;
+    for (int start = tilesPerTask; start < numTiles; start += tilesPerTask) {
+        tasks.push_back(std::async(std::launch::async, buildMasks, start, qMin(start + tilesPerTask, numTiles)));
+    }
+    buildMasks(0, qMin(tilesPerTask, numTiles));
+    for (auto &task : tasks) {
+        task.wait();
     }
+    m_tileColorMasksValid = true;
+}
+
+const uchar *Tileset::tilePixels(uint16_t tileId) const {
+    const int index = Tile::getIndexInTileset(tileId);
+    if (index < 0 || index >= m_numTiles)
+        return nullptr;
+    return reinterpret_cast<const uchar *>(m_tilePixels.constData()) + index * Tile::numPixels();
+}
+
+QImage Tileset::tileImage(uint16_t tileId) const {
+    const uchar *pixels = tilePixels(tileId);
+    if (!pixels)
+        return QImage();
+    QImage image(Tile::pixelWidth(), Tile::pixelHeight(), QImage::Format_Indexed8);
+    image.setColorTable(m_tilesColorTable);
+    for (int y = 0; y < Tile::pixelHeight(); y++, pixels += Tile::pixelWidth()) {
+        memcpy(image.scanLine(y), pixels, Tile::pixelWidth());
+    }
+    return image;
+}
+
+uint16_t Tileset::tileColorMask(uint16_t tileId) const {
+    if (!m_tileColorMasksValid)
+        buildTileColorMasks();
+    const int index = Tile::getIndexInTileset(tileId);
+    return (index >= 0 && index < static_cast<int>(m_tileColorMasks.size())) ? m_tileColorMasks[index] : 0;
+}
+
+static uint16_t getTileColorMask(uint16_t tileId, const Tileset *primaryTileset, const Tileset *secondaryTileset) {
+    const Tileset *tileset = Tileset::getTileTileset(tileId, primaryTileset, secondaryTileset);
+    return tileset ? tileset->tileColorMask(tileId) : 0;
+}
+
+// Returns a mask of the colors used by this tileset's metatiles with the given palette (bit N is set if color N is used).
+uint16_t Tileset::getUsedColorsMask(int paletteId, const Tileset *pairedTileset) const {
     const Tileset *primaryTileset = this->is_secondary ? pairedTileset : this;
     const Tileset *secondaryTileset = this->is_secondary ? this : pairedTileset;
-    QSet<uint16_t> seenTileIds;
+    const uint16_t allColors = (1 << Tileset::numColorsPerPalette()) - 1;
+    uint16_t usedColors = 0;
     for (const auto &metatile : m_metatiles)
-    for (const auto &tile : metatile->tiles) {
+    for (const auto &tile : metatile.tiles) {
         if (tile.palette != paletteId)
             continue;
-
-        // Save time by ignoring tiles we've already inspected.
-        if (seenTileIds.contains(tile.tileId))
-            continue;
-        seenTileIds.insert(tile.tileId);
-
-        QImage image = getTileImage(tile.tileId, primaryTileset, secondaryTileset);
-        if (image.isNull() || image.sizeInBytes() < Tile::numPixels())
-            continue;
-
-        const uchar * pixels = image.constBits();
-        for (int i = 0; i < Tile::numPixels(); i++) {
-            auto it = unusedColors.constFind(pixels[i]);
-            if (it != unusedColors.constEnd()) {
-                unusedColors.erase(it);
-                if (unusedColors.isEmpty()) {
-                    return {};
-                }
-            }
-        }
+        usedColors |= getTileColorMask(tile.tileId, primaryTileset, secondaryTileset);
+        if (usedColors == allColors)
+            return usedColors;
     }
-    return unusedColors;
+    return usedColors;
 }
 
 // Returns the list of metatile IDs representing all the metatiles in this tileset that use the specified color ID.
 QList<uint16_t> Tileset::findMetatilesUsingColor(int paletteId, int colorId, const Tileset *pairedTileset) const {
     const Tileset *primaryTileset = this->is_secondary ? pairedTileset : this;
     const Tileset *secondaryTileset = this->is_secondary ? this : pairedTileset;
-    QSet<uint16_t> metatileIdSet;
-    QHash<uint16_t, bool> tileContainsColor;
+    const uint16_t colorMask = 1 << colorId;
+
+    // Metatiles are visited in order, so the resulting list is already sorted.
+    QList<uint16_t> metatileIds;
     uint16_t metatileIdBase = firstMetatileId();
-    for (int i = 0; i < m_metatiles.length(); i++) {
-        uint16_t metatileId = i + metatileIdBase;
-        for (const auto &tile : m_metatiles.at(i)->tiles) {
-            if (tile.palette != paletteId)
-                continue;
-
-            // Save time on tiles we've already inspected by getting the cached result.
-            auto tileIt = tileContainsColor.constFind(tile.tileId);
-            if (tileIt != tileContainsColor.constEnd()) {
-                if (tileIt.value()) metatileIdSet.insert(metatileId);
-                continue;
-            }
-            tileContainsColor[tile.tileId] = false;
-
-            QImage image = getTileImage(tile.tileId, primaryTileset, secondaryTileset);
-            if (image.isNull() || image.sizeInBytes() < Tile::numPixels())
-                continue;
-
-            const uchar * pixels = image.constBits();
-            for (int j = 0; j < Tile::numPixels(); j++) {
-                if (pixels[j] == colorId) {
-                    metatileIdSet.insert(metatileId);
-                    tileContainsColor[tile.tileId] = true;
-                    break;
-                }
+    for (int i = 0; i < numMetatiles(); i++) {
+        for (const auto &tile : m_metatiles[i].tiles) {
+            if (tile.palette == paletteId && (getTileColorMask(tile.tileId, primaryTileset, secondaryTileset) & colorMask)) {
+                metatileIds.append(i + metatileIdBase);
+                break;
             }
         }
     }
-    QList<uint16_t> metatileIds(metatileIdSet.constBegin(), metatileIdSet.constEnd());
-    std::sort(metatileIds.begin(), metatileIds.end());
     return metatileIds;
 }
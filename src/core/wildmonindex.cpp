@@ -0,0 +1,79 @@
+#include "wildmonindex.h"
+
+#include <algorithm>
+
+void WildMonIndex::build(const OrderedMap<QString, OrderedMap<QString, WildPokemonHeader>> &wildMonData) {
+    clear();
+    for (const auto &mapPair : wildMonData) {
+        updateMap(mapPair.first, mapPair.second);
+    }
+}
+
+void WildMonIndex::updateMap(const QString &mapConstant, const OrderedMap<QString, WildPokemonHeader> &encounterGroups) {
+    removeMap(mapConstant);
+
+    Entry entry;
+    entry.mapConstant = mapConstant;
+    for (const auto &groupPair : encounterGroups) {
+        entry.groupName = groupPair.first;
+        for (const auto &fieldPair : groupPair.second.wildMons) {
+            entry.fieldName = fieldPair.first;
+            const WildMonInfo &monInfo = fieldPair.second;
+            for (int slot = 0; slot < monInfo.wildPokemon.length(); slot++) {
+                const WildPokemon &wildMon = monInfo.wildPokemon.at(slot);
+                if (wildMon.species.isEmpty())
+                    continue;
+                entry.slot = slot;
+                entry.minLevel = wildMon.minLevel;
+                entry.maxLevel = wildMon.maxLevel;
+                addEntry(wildMon.species, entry);
+            }
+        }
+    }
+}
+
+void WildMonIndex::addEntry(const QString &species, const Entry &entry) {
+    auto it = m_entriesBySpecies.find(species);
+    if (it == m_entriesBySpecies.end()) {
+        it = m_entriesBySpecies.insert(species, {});
+        m_speciesByFoldedName.insert(species.toCaseFolded(), species);
+    }
+    it.value().append(entry);
+    m_speciesByMap[entry.mapConstant].insert(species);
+}
+
+void WildMonIndex::removeMap(const QString &mapConstant) {
+    // Only the species that appear on the map need to be visited.
+    const QSet<QString> speciesOnMap = m_speciesByMap.take(mapConstant);
+    for (const auto &species : speciesOnMap) {
+        auto it = m_entriesBySpecies.find(species);
+        if (it == m_entriesBySpecies.end())
+            continue;
+        QList<Entry> &entries = it.value();
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&mapConstant](const Entry &entry) {
+            return entry.mapConstant == mapConstant;
+        }), entries.end());
+        if (entries.isEmpty()) {
+            m_entriesBySpecies.erase(it);
+            m_speciesByFoldedName.remove(species.toCaseFolded(), species);
+        }
+    }
+}
+
+void WildMonIndex::clear() {
+    m_entriesBySpecies.clear();
+    m_speciesByMap.clear();
+    m_speciesByFoldedName.clear();
+}
+
+QStringList WildMonIndex::findSpecies(const QString &prefix, int maxResults) const {
+    QStringList species;
+    const QString foldedPrefix = prefix.toCaseFolded();
+    // Keys are sorted, so every species with the prefix is in a single run starting from the lower bound.
+    for (auto it = m_speciesByFoldedName.lowerBound(foldedPrefix); it != m_speciesByFoldedName.constEnd(); it++) {
+        if (!it.key().startsWith(foldedPrefix) || species.length() == maxResults)
+            break;
+        species.append(it.value());
+    }
+    return species;
+}
@@ -1,6 +1,7 @@
 #include "editor.h"
 #include "eventpixmapitem.h"
 #include "imageproviders.h"
+#include "collisionatlas.h"
 #include "log.h"
 #include "connectionslistitem.h"
 #include "currentselectedmetatilespixmapitem.h"
@@ -76,6 +77,7 @@ Editor::~Editor()
     delete this->map_ruler;
     for (auto sublist : collisionIcons)
         qDeleteAll(sublist);
+    CollisionAtlas::clearCache();
 
     closeProject();
 }
@@ -768,6 +770,7 @@ void Editor::saveEncounterTabData() {
             encounterHeader.wildMons[fieldName] = model->encounterData();
         }
     }
+    project->wildMonIndex.updateMap(map->constantName(), encounterMap);
 }
 
 EncounterTableModel* Editor::getCurrentWildMonTable() {
@@ -827,6 +830,7 @@ void Editor::updateEncounterFields(EncounterFields newFields) {
         }
     }
     project->wildMonFields = newFields;
+    project->wildMonIndex.build(project->wildMonData);
 }
 
 void Editor::displayConnection(MapConnection *connection) {
@@ -1133,6 +1137,8 @@ void Editor::onWheelZoom(int s) {
 
 const QList<double> zoomLevels = QList<double>
 {
+    0.125,
+    0.25,
     0.5,
     0.75,
     1.0,
@@ -1255,7 +1261,7 @@ void Editor::setStatusFromMapPos(const QPoint &pos) {
                               .arg(pos.x())
                               .arg(pos.y())
                               .arg(getMetatileDisplayMessage(block.metatileId()))
-                              .arg(QString::number(zoomLevels[this->scaleIndex], 'g', 2)));
+                              .arg(QString::number(zoomLevels[this->scaleIndex], 'g', 3)));
     } else if (this->editMode == EditMode::Collision) {
         this->ui->statusBar->showMessage(QString("X: %1, Y: %2, %3")
                               .arg(pos.x())
@@ -1265,7 +1271,7 @@ void Editor::setStatusFromMapPos(const QPoint &pos) {
         this->ui->statusBar->showMessage(QString("X: %1, Y: %2, Scale = %3x")
                               .arg(pos.x())
                               .arg(pos.y())
-                              .arg(QString::number(zoomLevels[this->scaleIndex], 'g', 2)));
+                              .arg(QString::number(zoomLevels[this->scaleIndex], 'g', 3)));
     }
 }
 
@@ -1876,41 +1882,33 @@ void Editor::maskNonVisibleConnectionTiles() {
 }
 
 void Editor::clearMapBorder() {
-    for (QGraphicsPixmapItem* item : borderItems) {
-        if (item->scene()) {
-            item->scene()->removeItem(item);
-        }
-        delete item;
+    if (this->mapBorderItem && this->mapBorderItem->scene()) {
+        this->mapBorderItem->scene()->removeItem(this->mapBorderItem);
     }
-    borderItems.clear();
+    delete this->mapBorderItem;
+    this->mapBorderItem = nullptr;
 }
 
 void Editor::displayMapBorder() {
     clearMapBorder();
 
-    QPixmap pixmap = this->layout->renderBorder();
-    const QMargins borderMargins = layout->getBorderMargins();
-    for (int y = -borderMargins.top(); y < this->layout->getHeight() + borderMargins.bottom(); y += this->layout->getBorderHeight())
-    for (int x = -borderMargins.left(); x < this->layout->getWidth() + borderMargins.right(); x += this->layout->getBorderWidth()) {
-        QGraphicsPixmapItem *item = new QGraphicsPixmapItem(pixmap);
-        item->setX(x * Metatile::pixelWidth());
-        item->setY(y * Metatile::pixelHeight());
-        item->setZValue(ZValue::MapBorder);
-        scene->addItem(item);
-        borderItems.append(item);
-    }
+    this->mapBorderItem = new MapBorderItem(this->layout);
+    this->mapBorderItem->setZValue(ZValue::MapBorder);
+    scene->addItem(this->mapBorderItem);
 }
 
 void Editor::updateMapBorder() {
-    QPixmap pixmap = this->layout->renderBorder(true);
-    for (auto item : this->borderItems) {
-        item->setPixmap(pixmap);
-    }
+    if (this->mapBorderItem)
+        this->mapBorderItem->draw(true);
 }
 
+// Called when the current tilesets or palettes change, which invalidates any cached connection renders that use them.
 void Editor::updateMapConnections() {
+    Map::invalidateConnectionRenders();
     for (auto item : connection_items)
-        item->render(true);
+        item->render();
+    for (auto item : diving_map_items)
+        item->updatePixmap();
 }
 
 void Editor::toggleGrid(bool checked) {
@@ -1924,7 +1922,8 @@ void Editor::toggleGrid(bool checked) {
     ui->actionShow_Grid->setChecked(checked);
     ui->checkBox_ToggleGrid->setChecked(checked);
 
-    this->mapGrid->setVisible(checked);
+    if (this->mapGrid)
+        this->mapGrid->setVisible(checked);
 
     if (ui->graphicsView_Map->scene())
         ui->graphicsView_Map->scene()->update();
@@ -1938,42 +1937,15 @@ void Editor::clearMapGrid() {
 void Editor::displayMapGrid() {
     clearMapGrid();
 
-    // Note: The grid lines are not added to the scene. They need to be drawn on top of the overlay
-    //       elements of the scripting API, so they're painted manually in MapView::drawForeground.
-    this->mapGrid = new QGraphicsItemGroup();
-
-    const int pixelMapWidth = this->layout->pixelWidth();
-    const int pixelMapHeight = this->layout->pixelHeight();
-
-    // The grid can be moved with a user-specified x/y offset. The grid's dash patterns will only wrap in full pattern increments,
-    // so we draw an additional row/column outside the map that can be revealed as the offset changes.
-    const int offsetX = (this->gridSettings.offsetX % this->gridSettings.width) - this->gridSettings.width;
-    const int offsetY = (this->gridSettings.offsetY % this->gridSettings.height) - this->gridSettings.height;
-
-    QPen pen;
-    pen.setColor(this->gridSettings.color);
-
-    // Create vertical lines
-    pen.setDashPattern(this->gridSettings.getVerticalDashPattern());
-    for (int i = offsetX; i <= pixelMapWidth; i += this->gridSettings.width) {
-        auto line = new QGraphicsLineItem(i, offsetY, i, pixelMapHeight);
-        line->setPen(pen);
-        this->mapGrid->addToGroup(line);
-    }
-
-    // Create horizontal lines
-    pen.setDashPattern(this->gridSettings.getHorizontalDashPattern());
-    for (int i = offsetY; i <= pixelMapHeight; i += this->gridSettings.height) {
-        auto line = new QGraphicsLineItem(offsetX, i, pixelMapWidth, i);
-        line->setPen(pen);
-        this->mapGrid->addToGroup(line);
-    }
-
+    // Note: The grid is not added to the scene. It needs to be drawn on top of the overlay
+    //       elements of the scripting API, so it's painted manually in MapView::drawForeground.
+    this->mapGrid = new MapGrid(this->gridSettings);
     this->mapGrid->setVisible(porymapConfig.showGrid);
 }
 
 void Editor::updateMapGrid() {
-    displayMapGrid();
+    if (this->mapGrid)
+        this->mapGrid->setSettings(this->gridSettings);
     if (ui->graphicsView_Map->scene())
         ui->graphicsView_Map->scene()->update();
 }
@@ -2012,10 +1984,9 @@ void Editor::updateBorderVisibility() {
     bool visible = (editingConnections || ui->checkBox_ToggleBorder->isChecked());
 
     // Update border
-    const qreal borderOpacity = editingConnections ? 0.4 : 1;
-    for (QGraphicsPixmapItem* item : borderItems) {
-        item->setVisible(visible);
-        item->setOpacity(borderOpacity);
+    if (this->mapBorderItem) {
+        this->mapBorderItem->setVisible(visible);
+        this->mapBorderItem->setOpacity(editingConnections ? 0.4 : 1);
     }
 
     // Update map connections
@@ -2024,11 +1995,10 @@ void Editor::updateBorderVisibility() {
         item->setEditable(editingConnections);
         item->setEnabled(visible);
 
-        // When connecting a map to itself we don't bother to re-render the map connections in real-time,
+        // When connecting a map to itself we don't re-render the map connections in real-time,
         // i.e. if the user paints a new metatile on the map this isn't immediately reflected in the connection.
-        // We're rendering them now, so we take the opportunity to do a full re-render for self-connections.
-        bool fullRender = (this->map && item->connection && this->map->name() == item->connection->targetMapName());
-        item->render(fullRender);
+        // Connection renders only redraw the blocks that changed, so we take the opportunity to update them now.
+        item->render();
     }
 }
 
@@ -2455,6 +2425,7 @@ void Editor::setCollisionGraphics() {
     for (auto sublist : collisionIcons)
         qDeleteAll(sublist);
     collisionIcons.clear();
+    CollisionAtlas::clearCache();
 
     // Use the image sheet to create an icon for each collision/elevation combination.
     // Any icons for combinations that aren't provided by the image sheet are also created now using default graphics.
@@ -8,6 +8,67 @@
 namespace fex
 {
 
+    Lexer::~Lexer()
+    {
+        Close();
+    }
+
+    void Lexer::Close()
+    {
+        if (mapped_)
+        {
+            file_.unmap(mapped_);
+            mapped_ = nullptr;
+        }
+        if (file_.isOpen())
+        {
+            file_.close();
+        }
+        buffer_.clear();
+        data_ = std::string_view();
+        index_ = 0;
+        line_number_ = 1;
+    }
+
+    bool Lexer::Open(const QString &path)
+    {
+        Close();
+        filename_ = path.toStdString();
+
+        // Note: Using QFile instead of ifstream to handle encoding differences between platforms
+        //       (specifically to handle accented characters on Windows)
+        file_.setFileName(path);
+        if (!file_.open(QIODevice::ReadOnly))
+            return false;
+
+        const qint64 size = file_.size();
+        mapped_ = (size > 0) ? file_.map(0, size) : nullptr;
+        if (mapped_)
+        {
+            data_ = std::string_view(reinterpret_cast<const char *>(mapped_), static_cast<size_t>(size));
+        }
+        else
+        {
+            buffer_ = file_.readAll();
+            data_ = std::string_view(buffer_.constData(), static_cast<size_t>(buffer_.size()));
+            file_.close();
+        }
+        return true;
+    }
+
+    void Lexer::Open(std::string_view data, const std::string &filename)
+    {
+        Close();
+        filename_ = filename;
+        data_ = data;
+    }
+
+    const std::string &Token::filename() const
+    {
+        static const std::string empty;
+        return filename_ ? *filename_ : empty;
+    }
+
     bool Lexer::IsNumber()
     {
         char c = Peek();
@@ -39,31 +100,59 @@ namespace fex
 
     char Lexer::Peek()
     {
-        return data_[index_];
+        return AtEnd() ? '\0' : data_[index_];
     }
 
     char Lexer::Next()
     {
         char c = Peek();
-        index_++;
+        if (!AtEnd())
+        {
+            index_++;
+        }
         return c;
     }
 
+    void Lexer::SkipLineComment()
+    {
+        while (!AtEnd() && Peek() != '\n')
+        {
+            Next();
+        }
+    }
+
+    void Lexer::SkipBlockComment()
+    {
+        while (!AtEnd())
+        {
+            char c = Next();
+            if (c == '\n')
+            {
+                line_number_++;
+            }
+            else if (c == '*' && Peek() == '/')
+            {
+                Next();
+                return;
+            }
+        }
+    }
+
     Token Lexer::ConsumeKeyword(Token identifier)
     {
-        const std::string &value = identifier.string_value();
+        std::string_view value = identifier.string_value();
 
         if (value == "extern")
         {
-            return Token(Token::Type::kExtern, identifier.filename(), identifier.line_number());
+            return Token(Token::Type::kExtern, &filename_, identifier.line_number());
         }
         if (value == "const")
         {
-            return Token(Token::Type::kConst, identifier.filename(), identifier.line_number());
+            return Token(Token::Type::kConst, &filename_, identifier.line_number());
         }
         if (value == "struct")
         {
-            return Token(Token::Type::kStruct, identifier.filename(), identifier.line_number());
+            return Token(Token::Type::kStruct, &filename_, identifier.line_number());
         }
 
         return identifier;
@@ -71,60 +160,61 @@ namespace fex
 
     Token Lexer::ConsumeIdentifier()
     {
-        std::string identifer = "";
+        const size_t start = index_;
 
         while (IsAlphaNumber() || Peek() == '_')
         {
-            identifer += Next();
+            Next();
         }
 
-        return ConsumeKeyword(Token(Token::Type::kIdentifier, filename_, line_number_, identifer));
+        return ConsumeKeyword(Token(Token::Type::kIdentifier, &filename_, line_number_, data_.substr(start, index_ - start)));
     }
 
     Token Lexer::ConsumeNumber()
     {
-        std::string identifer = "";
+        const size_t start = index_;
 
         if (Peek() == '0')
         {
-            identifer += Next();
+            Next();
             if (Peek() == 'x')
             {
-                identifer += Next();
+                Next();
             }
 
             while (IsNumber() || IsHexAlpha())
             {
-                identifer += Next();
+                Next();
             }
 
-            return Token(Token::Type::kNumber, filename_, line_number_, std::stoi(identifer, nullptr, 16));
+            return Token(Token::Type::kNumber, &filename_, line_number_, std::stoi(std::string(data_.substr(start, index_ - start)), nullptr, 16));
         }
 
         while (IsNumber())
         {
-            identifer += Next();
+            Next();
         }
 
-        return Token(Token::Type::kNumber, filename_, line_number_, std::stoi(identifer));
+        return Token(Token::Type::kNumber, &filename_, line_number_, std::stoi(std::string(data_.substr(start, index_ - start))));
     }
 
     // TODO: Doesn't currently support escape characters
     Token Lexer::ConsumeString()
     {
-        std::string value = "";
         if (Next() != '\"')
         {
             // Error
         }
 
         // TODO: error if we never see a quote
-        while (Peek() != '\"')
+        const size_t start = index_;
+        while (!AtEnd() && Peek() != '\"')
         {
-            value += Next();
+            Next();
         }
+        std::string_view value = data_.substr(start, index_ - start);
         Next(); // Consume final quote
-        return Token(Token::Type::kString, filename_, line_number_, value);
+        return Token(Token::Type::kString, &filename_, line_number_, value);
     }
 
     Token Lexer::ConsumeMacro()
@@ -133,54 +223,45 @@ namespace fex
 
         if (id.string_value() == "ifdef")
         {
-            return Token(Token::Type::kIfDef, filename_, line_number_);
+            return Token(Token::Type::kIfDef, &filename_, line_number_);
         }
         if (id.string_value() == "ifndef")
         {
-            return Token(Token::Type::kIfNDef, filename_, line_number_);
+            return Token(Token::Type::kIfNDef, &filename_, line_number_);
         }
         if (id.string_value() == "define")
         {
-            return Token(Token::Type::kDefine, filename_, line_number_);
+            return Token(Token::Type::kDefine, &filename_, line_number_);
         }
         if (id.string_value() == "endif")
         {
-            return Token(Token::Type::kEndIf, filename_, line_number_);
+            return Token(Token::Type::kEndIf, &filename_, line_number_);
         }
 
         if (id.string_value() == "include")
         {
-            return Token(Token::Type::kInclude, filename_, line_number_);
+            return Token(Token::Type::kInclude, &filename_, line_number_);
         }
 
-        return Token(Token::Type::kDefine, filename_, line_number_);
+        return Token(Token::Type::kDefine, &filename_, line_number_);
     }
 
     std::vector<Token> Lexer::LexFile(const QString &path)
     {
-        filename_ = path.toStdString();
-        line_number_ = 1;
-
-        // Note: Using QFile instead of ifstream to handle encoding differences between platforms
-        //       (specifically to handle accented characters on Windows)
-        QFile file(path);
-        if (!file.open(QIODevice::ReadOnly)) return Lex();
-
-        const QByteArray data = file.readAll();
-
-        index_ = 0;
-        data_ = data.toStdString();
-
-        file.close();
+        std::vector<Token> tokens;
+        if (!Open(path))
+            return tokens;
 
-        return Lex();
+        for (Token token = NextToken(); token.type() != Token::Type::kEndOfFile; token = NextToken())
+        {
+            tokens.push_back(token);
+        }
+        return tokens;
     }
 
-    std::vector<Token> Lexer::Lex()
+    Token Lexer::NextToken()
     {
-        std::vector<Token> tokens;
-
-        while (index_ < data_.length())
+        while (true)
         {
             while (IsWhitespace())
             {
@@ -191,156 +272,129 @@ namespace fex
                 Next();
             }
 
+            if (AtEnd())
+            {
+                return Token(Token::Type::kEndOfFile, &filename_, line_number_);
+            }
+
             if (IsAlpha())
             {
-                tokens.push_back(ConsumeIdentifier());
-                continue;
+                return ConsumeIdentifier();
             }
 
             if (IsNumber())
             {
-                tokens.push_back(ConsumeNumber());
-                continue;
+                return ConsumeNumber();
             }
 
             switch (Peek())
             {
             case '*':
                 Next();
-                tokens.push_back(Token(Token::Type::kTimes, filename_, line_number_));
-                break;
+                return Token(Token::Type::kTimes, &filename_, line_number_);
             case '-':
                 Next();
-                tokens.push_back(Token(Token::Type::kMinus, filename_, line_number_));
-                break;
+                return Token(Token::Type::kMinus, &filename_, line_number_);
             case '+':
                 Next();
-                tokens.push_back(Token(Token::Type::kPlus, filename_, line_number_));
-                break;
+                return Token(Token::Type::kPlus, &filename_, line_number_);
             case '(':
                 Next();
-                tokens.push_back(Token(Token::Type::kOpenParen, filename_, line_number_));
-                break;
+                return Token(Token::Type::kOpenParen, &filename_, line_number_);
             case ')':
                 Next();
-                tokens.push_back(Token(Token::Type::kCloseParen, filename_, line_number_));
-                break;
+                return Token(Token::Type::kCloseParen, &filename_, line_number_);
             case '&':
                 Next();
                 if (Peek() == '&')
                 {
                     Next();
-                    tokens.push_back(Token(Token::Type::kLogicalAnd, filename_, line_number_));
-                    break;
+                    return Token(Token::Type::kLogicalAnd, &filename_, line_number_);
                 }
-                tokens.push_back(Token(Token::Type::kBitAnd, filename_, line_number_));
-                break;
+                return Token(Token::Type::kBitAnd, &filename_, line_number_);
             case '|':
                 Next();
                 if (Peek() == '|')
                 {
                     Next();
-                    tokens.push_back(Token(Token::Type::kLogicalOr, filename_, line_number_));
-                    break;
+                    return Token(Token::Type::kLogicalOr, &filename_, line_number_);
                 }
-                tokens.push_back(Token(Token::Type::kBitOr, filename_, line_number_));
-                break;
+                return Token(Token::Type::kBitOr, &filename_, line_number_);
             case '^':
                 Next();
-                tokens.push_back(Token(Token::Type::kBitXor, filename_, line_number_));
-                break;
+                return Token(Token::Type::kBitXor, &filename_, line_number_);
             case ',':
                 Next();
-                tokens.push_back(Token(Token::Type::kComma, filename_, line_number_));
-                break;
+                return Token(Token::Type::kComma, &filename_, line_number_);
             case '=':
                 Next();
-                tokens.push_back(Token(Token::Type::kEqual, filename_, line_number_));
-                break;
+                return Token(Token::Type::kEqual, &filename_, line_number_);
             case ';':
                 Next();
-                tokens.push_back(Token(Token::Type::kSemicolon, filename_, line_number_));
-                break;
+                return Token(Token::Type::kSemicolon, &filename_, line_number_);
             case '[':
                 Next();
-                tokens.push_back(Token(Token::Type::kOpenSquare, filename_, line_number_));
-                break;
+                return Token(Token::Type::kOpenSquare, &filename_, line_number_);
             case ']':
                 Next();
-                tokens.push_back(Token(Token::Type::kCloseSquare, filename_, line_number_));
-                break;
+                return Token(Token::Type::kCloseSquare, &filename_, line_number_);
             case '{':
                 Next();
-                tokens.push_back(Token(Token::Type::kOpenCurly, filename_, line_number_));
-                break;
+                return Token(Token::Type::kOpenCurly, &filename_, line_number_);
             case '}':
                 Next();
-                tokens.push_back(Token(Token::Type::kCloseCurly, filename_, line_number_));
-                break;
+                return Token(Token::Type::kCloseCurly, &filename_, line_number_);
             case '.':
                 Next();
-                tokens.push_back(Token(Token::Type::kPeriod, filename_, line_number_));
-                break;
+                return Token(Token::Type::kPeriod, &filename_, line_number_);
             case '_':
                 Next();
-                tokens.push_back(Token(Token::Type::kUnderscore, filename_, line_number_));
-                break;
+                return Token(Token::Type::kUnderscore, &filename_, line_number_);
             case '#':
                 Next();
-                tokens.push_back(ConsumeMacro());
-                break;
+                return ConsumeMacro();
             case '\"':
-                tokens.push_back(ConsumeString());
-                break;
+                return ConsumeString();
             case '<':
                 Next();
                 if (Peek() == '<')
                 {
                     Next();
-                    tokens.push_back(Token(Token::Type::kLeftShift, filename_, line_number_));
-                    break;
+                    return Token(Token::Type::kLeftShift, &filename_, line_number_);
                 }
                 if (Peek() == '=')
                 {
                     Next();
-                    tokens.push_back(Token(Token::Type::kLessThanEqual, filename_, line_number_));
-                    break;
+                    return Token(Token::Type::kLessThanEqual, &filename_, line_number_);
                 }
-                tokens.push_back(Token(Token::Type::kLessThan, filename_, line_number_));
-                break;
+                return Token(Token::Type::kLessThan, &filename_, line_number_);
             case '>':
                 Next();
                 if (Peek() == '>')
                 {
                     Next();
-                    tokens.push_back(Token(Token::Type::kRightShift, filename_, line_number_));
-                    break;
+                    return Token(Token::Type::kRightShift, &filename_, line_number_);
                 }
                 if (Peek() == '=')
                 {
                     Next();
-                    tokens.push_back(Token(Token::Type::kGreaterThanEqual, filename_, line_number_));
-                    break;
+                    return Token(Token::Type::kGreaterThanEqual, &filename_, line_number_);
                 }
-                tokens.push_back(Token(Token::Type::kGreaterThan, filename_, line_number_));
-                break;
+                return Token(Token::Type::kGreaterThan, &filename_, line_number_);
 
             case '/':
                 Next();
                 switch (Peek())
                 {
                 case '/':
-                    while (Next() != '\n')
-                        ;
+                    SkipLineComment();
                     continue;
                 case '*':
-                    while (Next() != '*')
-                        ;
-                    Next(); // last /
+                    Next();
+                    SkipBlockComment();
                     continue;
                 default:
-                    tokens.push_back(Token(Token::Type::kDivide, filename_, line_number_));
-                    continue;
+                    return Token(Token::Type::kDivide, &filename_, line_number_);
                 }
 
             case '\0':
@@ -353,8 +407,6 @@ namespace fex
                 break;
             }
         }
-
-        return tokens;
     }
 
     std::string Token::ToString() const
@@ -381,10 +433,10 @@ namespace fex
             out += "Number: " + std::to_string(int_value());
             break;
         case Token::Type::kString:
-            out += "String: " + string_value();
+            out += "String: " + std::string(string_value());
             break;
         case Token::Type::kIdentifier:
-            out += "Identifier: " + string_value();
+            out += "Identifier: " + std::string(string_value());
             break;
         case Token::Type::kOpenParen:
             out += "Symbol: (";
@@ -476,6 +528,9 @@ namespace fex
         case Token::Type::kUnderscore:
             out += "Symbol: _";
             break;
+        case Token::Type::kEndOfFile:
+            out += "End of file";
+            break;
         }
 
         return out;
@@ -1,5 +1,6 @@
 #include "lib/fex/parser.h"
 
+#include <algorithm>
 #include <iostream>
 #include <regex>
 #include <vector>
@@ -120,18 +121,61 @@ namespace fex
         return output;
     }
 
-    Token Parser::Peek() { return tokens_[index_]; }
+    void Parser::Reset(std::vector<Token> tokens, Lexer *lexer)
+    {
+        index_ = 0;
+        tokens_ = std::move(tokens);
+        lexer_ = lexer;
+        lexer_done_ = (lexer == nullptr);
+    }
+
+    // When streaming from a lexer, tokens that have already been parsed are no longer needed.
+    void Parser::DiscardConsumedTokens()
+    {
+        if (lexer_ && index_ > 0)
+        {
+            tokens_.erase(tokens_.begin(), tokens_.begin() + std::min<size_t>(index_, tokens_.size()));
+            index_ = 0;
+        }
+    }
+
+    bool Parser::AtEnd()
+    {
+        return Peek().type() == Token::Type::kEndOfFile;
+    }
+
+    Token Parser::Peek()
+    {
+        while (index_ >= tokens_.size() && !lexer_done_)
+        {
+            Token token = lexer_->NextToken();
+            if (token.type() == Token::Type::kEndOfFile)
+            {
+                lexer_done_ = true;
+                break;
+            }
+            tokens_.push_back(token);
+        }
+        if (index_ >= tokens_.size())
+        {
+            return Token(Token::Type::kEndOfFile, nullptr, 0);
+        }
+        return tokens_[index_];
+    }
 
     Token Parser::Next()
     {
         Token t = Peek();
-        index_++;
+        if (t.type() != Token::Type::kEndOfFile)
+        {
+            index_++;
+        }
         return t;
     }
 
     int Parser::ResolveIdentifier(const Token &token)
     {
-        std::string iden_val = token.string_value();
+        std::string iden_val(token.string_value());
 
         if (top_level_.find(iden_val) == top_level_.end())
         {
@@ -207,7 +251,7 @@ namespace fex
                     result = op1 | op2;
                 }
 
-                stack.push_back(Token(Token::Type::kNumber, token.filename(), token.line_number(), result));
+                stack.push_back(Token(Token::Type::kNumber, &token.filename(), token.line_number(), result));
             }
 
             if (token.type() == Token::Type::kNumber)
@@ -217,7 +261,7 @@ namespace fex
 
             if (token.type() == Token::Type::kIdentifier)
             {
-                stack.push_back(Token(Token::Type::kNumber, token.filename(), token.line_number(), ResolveIdentifier(token)));
+                stack.push_back(Token(Token::Type::kNumber, &token.filename(), token.line_number(), ResolveIdentifier(token)));
             }
         }
         return stack.size() ? stack.back().int_value() : 0;
@@ -236,6 +280,12 @@ namespace fex
 
         while (Peek().type() != Token::Type::kCloseParen)
         {
+            if (AtEnd())
+            {
+                index_ = save_index;
+                return false;
+            }
+
             // Nested parens aren't allowed in param list
             if (Peek().type() == Token::Type::kOpenParen)
             {
@@ -282,7 +332,7 @@ namespace fex
             // error
         }
 
-        std::string identifer = Next().string_value();
+        std::string identifer(Next().string_value());
         int value = 0;
 
         if (IsParamMacro())
@@ -292,9 +342,9 @@ namespace fex
             // Parameters (x, y, x) Expression
             Next();
 
-            while (Peek().type() != Token::Type::kCloseParen)
+            while (Peek().type() != Token::Type::kCloseParen && !AtEnd())
             {
-                auto formal = Next().string_value();
+                Next(); // formal parameter
                 if (Peek().type() == Token::Type::kComma)
                 {
                     Next();
@@ -314,7 +364,7 @@ namespace fex
 
             Next();
             int paren_count = 1;
-            while (paren_count > 0)
+            while (paren_count > 0 && !AtEnd())
             {
                 if (Peek().type() == Token::Type::kOpenParen)
                 {
@@ -342,8 +392,8 @@ namespace fex
         tsl::ordered_map<std::string, int> out;
 
         Lexer lexer;
-        auto tokens = lexer.LexFile(filename);
-        auto defines = Parse(tokens);
+        lexer.Open(filename);
+        auto defines = Parse(&lexer);
 
         for (const auto &define : defines)
         {
@@ -364,7 +414,7 @@ namespace fex
         if (Peek().type() == Token::Type::kOpenSquare)
         {
             Next(); // [
-            std::string identifier = Next().string_value();
+            std::string identifier(Next().string_value());
             Next(); // ]
             Next(); // =
             std::unique_ptr<ArrayValue> value = std::unique_ptr<ArrayValue>(new ArrayValue(ParseObject()));
@@ -408,14 +458,14 @@ namespace fex
         if (Peek().type() == Token::Type::kIdentifier)
         {
             std::vector<ArrayValue> idens = {};
-            idens.push_back(ArrayValue::Identifier(Next().string_value()));
+            idens.push_back(ArrayValue::Identifier(std::string(Next().string_value())));
 
             // NELEMS(...)
             if (Peek().type() == Token::Type::kOpenParen)
             {
-                while (Peek().type() != Token::Type::kCloseParen)
+                while (Peek().type() != Token::Type::kCloseParen && !AtEnd())
                 {
-                    std::string out = Next().ToString();
+                    Next();
                 }
                 Next(); // )
             }
@@ -423,7 +473,7 @@ namespace fex
             // ABC | DEF | GHI
             while (Peek().type() == Token::Type::kBitOr) {
                 Next();
-                idens.push_back(ArrayValue::Identifier(Next().string_value()));
+                idens.push_back(ArrayValue::Identifier(std::string(Next().string_value())));
             }
 
             if (idens.size() == 1)
@@ -438,7 +488,7 @@ namespace fex
         {
             Next(); // _
             Next(); // (
-            std::string value = Next().string_value();
+            std::string value(Next().string_value());
             Next(); // )
             return ArrayValue::String(value);
         }
@@ -446,7 +496,7 @@ namespace fex
         if (Peek().type() == Token::Type::kPeriod)
         {
             Next(); // .
-            std::string identifier = Next().string_value();
+            std::string identifier(Next().string_value());
             Next(); // =
 
             std::unique_ptr<ArrayValue> value = std::unique_ptr<ArrayValue>(new ArrayValue(ParseObject()));
@@ -460,19 +510,26 @@ namespace fex
 
     std::vector<Array> Parser::ParseTopLevelArrays(std::vector<Token> tokens)
     {
-        index_ = 0;
-        tokens_ = std::move(tokens);
+        Reset(std::move(tokens), nullptr);
+        return ParseTopLevelArrays(nullptr);
+    }
+
+    std::vector<Array> Parser::ParseTopLevelArrays(Lexer *lexer)
+    {
+        if (lexer)
+            Reset({}, lexer);
 
         std::vector<Array> items;
 
-        while (index_ < tokens_.size())
+        while (!AtEnd())
         {
+            DiscardConsumedTokens();
             if (Next().type() != Token::Type::kConst)
                 continue;
             Next(); // struct
 
-            std::string type = Next().string_value();
-            std::string name = Next().string_value();
+            std::string type(Next().string_value());
+            std::string name(Next().string_value());
 
             Array value(type, name);
 
@@ -490,19 +547,26 @@ namespace fex
 
     tsl::ordered_map<std::string, ArrayValue> Parser::ParseTopLevelObjects(std::vector<Token> tokens)
     {
-        index_ = 0;
-        tokens_ = std::move(tokens);
+        Reset(std::move(tokens), nullptr);
+        return ParseTopLevelObjects(nullptr);
+    }
+
+    tsl::ordered_map<std::string, ArrayValue> Parser::ParseTopLevelObjects(Lexer *lexer)
+    {
+        if (lexer)
+            Reset({}, lexer);
 
         tsl::ordered_map<std::string, ArrayValue> items;
 
-        while (index_ < tokens_.size())
+        while (!AtEnd())
         {
+            DiscardConsumedTokens();
             if (Next().type() != Token::Type::kConst)
                 continue;
             Next(); // struct
 
             Next(); // type
-            std::string name = Next().string_value();
+            std::string name(Next().string_value());
 
             Next(); // =
             items[name] = ParseObject();
@@ -514,12 +578,20 @@ namespace fex
 
     std::vector<DefineStatement> Parser::Parse(std::vector<Token> tokens)
     {
-        index_ = 0;
-        tokens_ = std::move(tokens);
+        Reset(std::move(tokens), nullptr);
+        return Parse(nullptr);
+    }
+
+    std::vector<DefineStatement> Parser::Parse(Lexer *lexer)
+    {
+        if (lexer)
+            Reset({}, lexer);
+
         std::vector<DefineStatement> statements;
 
-        while (index_ < tokens_.size())
+        while (!AtEnd())
         {
+            DiscardConsumedTokens();
             switch (Peek().type())
             {
             case Token::Type::kDefine:
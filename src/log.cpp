@@ -4,15 +4,50 @@
 #include <QStandardPaths>
 #include <QSysInfo>
 #include <QLabel>
+#include <QMutex>
 #include <QPointer>
 #include <QTimer>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
+// Messages are written to the console, the log file, and the status bar by a background thread.
+// Logging only has to format the message and push it onto a lock-free queue, so it's cheap and
+// safe to do from any thread. The writer wakes up periodically (or immediately for errors) and
+// handles everything that was logged since it last ran in a single batch.
 namespace Log {
     static QString mostRecentError;
+    static QMutex mostRecentErrorMutex;
     static QString path;
     static QFile file;
     static QTextStream textStream;
-    static bool initialized = false;
+    static std::atomic<bool> initialized{false};
+    // The number of log() calls that are between checking 'initialized' and queueing their entry.
+    static std::atomic<int> activeLoggers{0};
+
+    struct Entry {
+        QString text;    // The full line written to the log file
+        QString message; // The message shown in the status bar
+        LogType type;
+        Entry *next;
+    };
+    // Newest entry first. Producers push with a CAS loop, and the writer takes the whole list at once.
+    static std::atomic<Entry*> pendingEntries{nullptr};
+
+    static std::mutex writerMutex;
+    static std::condition_variable writerWakeup;
+    static bool stopWriter = false;
+
+    // The writer is normally stopped when the application is destroyed. If that never happens (e.g. the application exits
+    // without destroying its QApplication) it's stopped when the statics are destroyed instead, because destroying a thread
+    // that's still joinable would terminate the program. It's declared after everything the writer uses, so it's destroyed first.
+    struct WriterThread {
+        std::thread thread;
+        ~WriterThread();
+    };
+    static WriterThread writer;
 
     struct Display {
         QPointer<QStatusBar> statusBar;
@@ -24,6 +59,10 @@ namespace Log {
     static QTimer displayClearTimer;
 };
 
+// How long the writer waits to collect messages before writing them.
+// This also limits how often the status bar displays are updated.
+static const int flushIntervalMs = 100;
+
 // Enabling this does not seem to be simple to color console output
 // on Windows for all CLIs without external libraries or extreme bloat.
 #ifdef Q_OS_WIN
@@ -47,7 +86,10 @@ void logWarn(const QString &message) {
 }
 
 void logError(const QString &message) {
-    Log::mostRecentError = message;
+    {
+        QMutexLocker locker(&Log::mostRecentErrorMutex);
+        Log::mostRecentError = message;
+    }
     log(message, LogType::LOG_ERROR);
 }
 
@@ -164,16 +206,110 @@ void log(const QString &message, LogType type) {
 
     QString fullMessage = QString("%1 %2 %3").arg(now).arg(typeString).arg(message);
 
-    qDebug().noquote() << colorizeMessage(fullMessage, type);
-
+    // Registering before checking 'initialized' means stopLogWriter either sees this call and waits for its entry, or this call sees the writer has stopped.
+    Log::activeLoggers++;
     if (!Log::initialized) {
+        Log::activeLoggers--;
+        qDebug().noquote() << colorizeMessage(fullMessage, type);
         return;
     }
 
-    updateLogDisplays(message, type);
+    auto entry = new Log::Entry{fullMessage, message, type, Log::pendingEntries.load(std::memory_order_relaxed)};
+    while (!Log::pendingEntries.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_relaxed));
+    Log::activeLoggers--;
+
+    // Errors are written right away, in case they're followed by a crash.
+    if (type == LogType::LOG_ERROR)
+        Log::writerWakeup.notify_one();
+}
+
+// Takes every entry logged so far, oldest first.
+static QList<Log::Entry*> takeLogEntries() {
+    QList<Log::Entry*> entries;
+    Log::Entry *entry = Log::pendingEntries.exchange(nullptr, std::memory_order_acquire);
+    for (; entry; entry = entry->next) {
+        entries.prepend(entry);
+    }
+    return entries;
+}
+
+static void writeLogEntries(const QList<Log::Entry*> &entries) {
+    if (entries.isEmpty())
+        return;
+
+    QStringList consoleLines;
+    struct DisplayUpdate {
+        QString message;
+        LogType type;
+    };
+    QList<DisplayUpdate> displayUpdates;
+    for (const auto &entry : entries) {
+        consoleLines.append(colorizeMessage(entry->text, entry->type));
+        Log::textStream << entry->text << '\n';
 
-    Log::textStream << fullMessage << Qt::endl;
+        // Only the newest message of each type can still be visible once the batch has been shown,
+        // so the displays are only updated with those (in the order they were logged).
+        for (int i = 0; i < displayUpdates.length(); i++) {
+            if (displayUpdates.at(i).type == entry->type) {
+                displayUpdates.removeAt(i);
+                break;
+            }
+        }
+        displayUpdates.append(DisplayUpdate{entry->message, entry->type});
+        delete entry;
+    }
+    qDebug().noquote() << consoleLines.join('\n');
+    Log::textStream.flush();
     Log::file.flush();
+
+    // The status bar displays belong to the GUI thread.
+    if (qApp) {
+        QMetaObject::invokeMethod(qApp, [displayUpdates] {
+            for (const auto &update : displayUpdates) {
+                updateLogDisplays(update.message, update.type);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+static void runLogWriter() {
+    std::unique_lock<std::mutex> lock(Log::writerMutex);
+    while (!Log::stopWriter) {
+        Log::writerWakeup.wait_for(lock, std::chrono::milliseconds(flushIntervalMs));
+        lock.unlock();
+        writeLogEntries(takeLogEntries());
+        lock.lock();
+    }
+}
+
+// Runs when the application is destroyed. Anything logged after this is only printed to the console.
+static void stopLogWriter() {
+    Log::initialized = false;
+    {
+        std::lock_guard<std::mutex> lock(Log::writerMutex);
+        Log::stopWriter = true;
+    }
+    Log::writerWakeup.notify_one();
+    if (Log::writer.thread.joinable())
+        Log::writer.thread.join();
+
+    // Wait for any log() call that saw the writer running but hasn't queued its entry yet, so the final write below includes it.
+    while (Log::activeLoggers > 0)
+        std::this_thread::yield();
+
+    // Write anything that was logged while the writer was stopping. The application is going away, so skip the displays.
+    for (const auto &entry : takeLogEntries()) {
+        qDebug().noquote() << colorizeMessage(entry->text, entry->type);
+        Log::textStream << entry->text << '\n';
+        delete entry;
+    }
+    Log::textStream.flush();
+    Log::file.flush();
+}
+
+Log::WriterThread::~WriterThread() {
+    if (this->thread.joinable())
+        stopLogWriter();
 }
 
 QString getLogPath() {
@@ -181,6 +317,7 @@ QString getLogPath() {
 }
 
 QString getMostRecentError() {
+    QMutexLocker locker(&Log::mostRecentErrorMutex);
     return Log::mostRecentError;
 }
 
@@ -202,9 +339,13 @@ void logInit() {
         clearLogDisplays();
     });
 
+    // The file belongs to the writer thread once it starts.
+    const bool clearedLog = cleanupLargeLog();
     Log::initialized = true;
+    Log::writer.thread = std::thread(runLogWriter);
+    qAddPostRoutine(stopLogWriter);
 
-    if (cleanupLargeLog()) {
+    if (clearedLog) {
         logWarn(QString("Previous log file %1 was cleared due to being over 20MB in size.").arg(Log::path));
     }
 }
@@ -58,6 +58,11 @@
 #define USE_UPDATE_PROMOTER
 #endif
 
+// The number of event frames created at once when many events are selected.
+static const int eventFrameBatchSize = 20;
+// The number of event frames kept around for quick reselection, see MainWindow::trimEventFrames.
+static const int maxCachedEventFrames = 64;
+
 
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -136,7 +141,9 @@ void MainWindow::setWindowDisabled(bool disabled) {
             ui->actionOpen_Manual,
             ui->actionOpen_Log_File,
             ui->actionOpen_Config_Folder,
+            ui->actionPerformance_Trace,
             ui->actionCheck_for_Updates,
+            this->perfTracePanel,
         };
         auto allowedToDisable = [objectsAlwaysEnabled](QObject *object) {
             return !(object->objectName().isEmpty() || object->objectName().startsWith(QStringLiteral("_q_")) || objectsAlwaysEnabled.contains(object));
@@ -187,6 +194,7 @@ void MainWindow::setWindowDisabled(bool disabled) {
 void MainWindow::initWindow() {
     porymapConfig.load();
     this->initLogStatusBar();
+    this->initImageExportQueue();
     this->initCustomUI();
     this->initExtraSignals();
     this->initEditor();
@@ -309,6 +317,57 @@ void MainWindow::initLogStatusBar() {
     }
 }
 
+// Image exports are rendered in the background, their progress is displayed in the status bar.
+void MainWindow::initImageExportQueue() {
+    this->mapImageExportQueue = new MapImageExportQueue(this);
+
+    this->progressBar_ImageExport = new QProgressBar(this->statusBar());
+    this->progressBar_ImageExport->setMaximumWidth(250);
+    this->progressBar_ImageExport->setVisible(false);
+
+    this->button_CancelImageExports = new QToolButton(this->statusBar());
+    this->button_CancelImageExports->setIcon(QIcon(QStringLiteral(":/icons/delete.ico")));
+    this->button_CancelImageExports->setToolTip(QStringLiteral("Cancel image exports"));
+    this->button_CancelImageExports->setAutoRaise(true);
+    this->button_CancelImageExports->setVisible(false);
+    connect(this->button_CancelImageExports, &QToolButton::clicked, [this] {
+        for (const auto &job : this->mapImageExportQueue->jobs()) {
+            if (!job->outputPath().isEmpty())
+                this->mapImageExportQueue->cancel(job);
+        }
+    });
+
+    this->statusBar()->addPermanentWidget(this->progressBar_ImageExport);
+    this->statusBar()->addPermanentWidget(this->button_CancelImageExports);
+
+    connect(this->mapImageExportQueue, &MapImageExportQueue::jobProgressChanged, this, &MainWindow::updateImageExportStatus);
+    connect(this->mapImageExportQueue, &MapImageExportQueue::jobFinished, this, &MainWindow::onImageExportFinished);
+}
+
+void MainWindow::updateImageExportStatus(MapImageExportJob *job, int value, int maximum, const QString &label) {
+    // Preview jobs report their progress in the exporter window.
+    if (!job || job->outputPath().isEmpty())
+        return;
+
+    this->progressBar_ImageExport->setRange(0, maximum);
+    this->progressBar_ImageExport->setValue(value);
+    this->progressBar_ImageExport->setFormat(QString("%1 %p%").arg(label));
+    this->progressBar_ImageExport->setVisible(true);
+    this->button_CancelImageExports->setVisible(true);
+}
+
+void MainWindow::onImageExportFinished(MapImageExportJob *job) {
+    if (job && !job->outputPath().isEmpty() && job->succeeded()) {
+        logInfo(QString("Exported image to '%1'").arg(job->outputPath()));
+    }
+    for (const auto &otherJob : this->mapImageExportQueue->jobs()) {
+        if (!otherJob->outputPath().isEmpty())
+            return; // Other exports are still running
+    }
+    this->progressBar_ImageExport->setVisible(false);
+    this->button_CancelImageExports->setVisible(false);
+}
+
 void MainWindow::initCustomUI() {
     static const QMap<int, QString> mainTabNames = {
         {MainTab::Map, "Map"},
@@ -497,6 +556,10 @@ void MainWindow::openEditHistory() {
 
 void MainWindow::initMiscHeapObjects() {
     ui->tabWidget_EventType->clear();
+
+    this->mapTabIconTimer.setSingleShot(true);
+    this->mapTabIconTimer.setInterval(1000);
+    connect(&this->mapTabIconTimer, &QTimer::timeout, this, &MainWindow::updateMapTabIcon);
 }
 
 void MainWindow::initMapList() {
@@ -649,12 +712,28 @@ void MainWindow::updateWindowTitle() {
         );
     }
 
+    // Rendering the icon samples the whole layout, so it's only redrawn immediately when the layout changes.
+    // Otherwise (e.g. while the user is painting) it's redrawn once the title has stopped updating for a moment.
+    if (this->mapTabIconLayout != editor->layout) {
+        this->mapTabIconLayout = editor->layout;
+        this->mapTabIconTimer.stop();
+        updateMapTabIcon();
+    } else {
+        this->mapTabIconTimer.start();
+    }
+}
+
+void MainWindow::updateMapTabIcon() {
     // For some reason (perhaps on Qt < 6?) we had to clear the icon first here or mainTabBar wouldn't display correctly.
     ui->mainTabBar->setTabIcon(MainTab::Map, QIcon());
 
-    QPixmap pixmap = editor->layout->pixmap;
-    if (!pixmap.isNull()) {
-        ui->mainTabBar->setTabIcon(MainTab::Map, QIcon(pixmap));
+    if (!this->mapTabIconLayout)
+        return;
+
+    // The layout image is only drawn where it's been in view, so the icon is made from the layout's blocks instead.
+    const QImage image = this->mapTabIconLayout->renderThumbnail(QSize(64, 64));
+    if (!image.isNull()) {
+        ui->mainTabBar->setTabIcon(MainTab::Map, QIcon(QPixmap::fromImage(image)));
     } else {
         ui->mainTabBar->setTabIcon(MainTab::Map, QIcon(QStringLiteral(":/icons/map.ico")));
     }
@@ -1538,6 +1617,7 @@ void MainWindow::clearProjectUI() {
 
     this->mapHeaderForm->clear();
     ui->label_NoEvents->setText("");
+    this->pendingEventFrameEvents.clear();
 
     prefab.clearPrefabUi();
 
@@ -2556,14 +2636,18 @@ void MainWindow::updateSelectedEvents() {
 
     this->isProgrammaticEventTabChange = false;
 
+    // Building an event frame is expensive, so for large selections we only create the frames
+    // that fit on screen, and the rest are created as the user scrolls down to them.
     QList<QFrame *> frames;
+    this->pendingEventFrameEvents.clear();
     for (auto event : events) {
-        EventFrame *eventFrame = event->createEventFrame();
-        eventFrame->populate(this->editor->project);
-        eventFrame->initialize();
-        eventFrame->connectSignals(this);
-        frames.append(eventFrame);
+        if (frames.length() < eventFrameBatchSize) {
+            frames.append(prepareEventFrame(event));
+        } else {
+            this->pendingEventFrameEvents.append(event);
+        }
     }
+    this->pendingEventFrameScrollArea = scrollTarget;
 
     if (target->layout() && target->children().length()) {
         for (QFrame *frame : target->findChildren<EventFrame *>()) {
@@ -2588,6 +2672,13 @@ void MainWindow::updateSelectedEvents() {
         for (QFrame *frame : frames) {
             frame->show();
         }
+        trimEventFrames();
+
+        if (!this->pendingEventFrameEvents.isEmpty()) {
+            QScrollBar *scrollBar = scrollTarget->verticalScrollBar();
+            connect(scrollBar, &QScrollBar::valueChanged, this, &MainWindow::loadPendingEventFrames, Qt::UniqueConnection);
+            connect(scrollBar, &QScrollBar::rangeChanged, this, &MainWindow::loadPendingEventFrames, Qt::UniqueConnection);
+        }
 
         ui->label_NoEvents->hide();
         ui->tabWidget_EventType->show();
@@ -2606,6 +2697,64 @@ void MainWindow::updateSelectedEvents() {
     }
 }
 
+EventFrame *MainWindow::prepareEventFrame(Event *event) {
+    EventFrame *eventFrame = event->createEventFrame();
+    eventFrame->populate(this->editor->project);
+    eventFrame->initialize();
+    eventFrame->connectSignals(this);
+
+    this->recentEventFrames.removeOne(eventFrame);
+    this->recentEventFrames.prepend(eventFrame);
+    return eventFrame;
+}
+
+// Each event keeps its frame after it's deselected, so that reselecting it is quick.
+// To keep memory use bounded we only keep the most recently used frames, the rest are rebuilt if they're needed again.
+void MainWindow::trimEventFrames() {
+    int numFrames = 0;
+    for (auto it = this->recentEventFrames.begin(); it != this->recentEventFrames.end();) {
+        EventFrame *frame = *it;
+        if (!frame) {
+            // The frame was already deleted along with its event.
+            it = this->recentEventFrames.erase(it);
+        } else if (++numFrames > maxCachedEventFrames && frame->isHidden() && frame->getEvent()) {
+            it = this->recentEventFrames.erase(it);
+            frame->getEvent()->destroyEventFrame();
+        } else {
+            it++;
+        }
+    }
+}
+
+// Creates the next batch of frames for the selected events once the user scrolls near the bottom of the frames created so far.
+void MainWindow::loadPendingEventFrames() {
+    QScrollArea *scrollArea = this->pendingEventFrameScrollArea;
+    if (this->pendingEventFrameEvents.isEmpty() || !scrollArea || !scrollArea->widget())
+        return;
+    QScrollBar *scrollBar = scrollArea->verticalScrollBar();
+    if (scrollBar->value() < scrollBar->maximum() - scrollArea->viewport()->height())
+        return;
+    auto layout = qobject_cast<QVBoxLayout *>(scrollArea->widget()->layout());
+    if (!layout)
+        return;
+
+    QList<QFrame *> frames;
+    while (!this->pendingEventFrameEvents.isEmpty() && frames.length() < eventFrameBatchSize) {
+        Event *event = this->pendingEventFrameEvents.takeFirst();
+        // The selection may have changed since the event was queued.
+        if (!this->editor->selectedEvents.contains(event))
+            continue;
+        QFrame *frame = prepareEventFrame(event);
+        // Insert before the vertical spacer at the end of the layout.
+        layout->insertWidget(layout->count() - 1, frame);
+        frames.append(frame);
+    }
+    for (QFrame *frame : frames) {
+        frame->show();
+    }
+    trimEventFrames();
+}
+
 Event::Group MainWindow::getEventGroupFromTabWidget(QWidget *tab) {
     static const QMap<QWidget*,Event::Group> tabToGroup = {
         {ui->tab_Objects,       Event::Group::Object},
@@ -2677,7 +2826,8 @@ void MainWindow::on_slider_EmergeMapOpacity_valueChanged(int value) {
 void MainWindow::on_horizontalSlider_CollisionTransparency_valueChanged(int value) {
     this->editor->collisionOpacity = static_cast<qreal>(value) / 100;
     porymapConfig.collisionOpacity = value;
-    this->editor->collision_item->draw(true);
+    // The collision image is rendered again with the new opacity.
+    this->editor->collision_item->draw();
 }
 
 void MainWindow::on_actionPencil_triggered()     { on_toolButton_Paint_clicked(); }
@@ -2717,6 +2867,7 @@ void MainWindow::onMapLoaded(Map *map) {
 void MainWindow::onTilesetsSaved(QString primaryTilesetLabel, QString secondaryTilesetLabel) {
     // If saved tilesets are currently in-use, update them and redraw
     // Otherwise overwrite the cache for the saved tileset
+    Map::invalidateConnectionRenders();
     bool updated = false;
     if (primaryTilesetLabel == this->editor->layout->tileset_primary_label) {
         this->editor->updatePrimaryTileset(primaryTilesetLabel, true);
@@ -2803,9 +2954,9 @@ void MainWindow::showExportMapImageWindow(ImageExporterMode mode) {
     if (!this->mapImageExporter) {
         // Open new image export window
         if (this->editor->map){
-            this->mapImageExporter = new MapImageExporter(this, this->editor->project, this->editor->map, mode);
+            this->mapImageExporter = new MapImageExporter(this, this->editor->project, this->mapImageExportQueue, this->editor->map, mode);
         } else if (this->editor->layout) {
-            this->mapImageExporter = new MapImageExporter(this, this->editor->project, this->editor->layout, mode);
+            this->mapImageExporter = new MapImageExporter(this, this->editor->project, this->mapImageExportQueue, this->editor->layout, mode);
         }
         if (this->mapImageExporter) {
             connect(this, &MainWindow::mapOpened, this->mapImageExporter, &MapImageExporter::setMap);
@@ -3035,6 +3186,16 @@ void MainWindow::on_actionOpen_Config_Folder_triggered() {
     QDesktopServices::openUrl(QUrl::fromLocalFile(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)));
 }
 
+// The panel is available without a project open, so that the project load itself can be traced.
+void MainWindow::on_actionPerformance_Trace_triggered() {
+    if (!this->perfTracePanel) {
+        this->perfTracePanel = new PerfTracePanel(this);
+        addDockWidget(Qt::BottomDockWidgetArea, this->perfTracePanel);
+    }
+    this->perfTracePanel->show();
+    this->perfTracePanel->raise();
+}
+
 void MainWindow::on_actionOpen_Manual_triggered() {
     static const QUrl url("https://huderlem.github.io/porymap/");
     QDesktopServices::openUrl(url);
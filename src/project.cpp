@@ -11,6 +11,7 @@
 #include "validator.h"
 #include "orderedjson.h"
 #include "utility.h"
+#include "perftrace.h"
 
 #include <QDir>
 #include <QJsonArray>
@@ -22,6 +23,7 @@
 #include <QStandardItem>
 #include <QMessageBox>
 #include <QRegularExpression>
+#include <QElapsedTimer>
 #include <algorithm>
 
 int Project::num_tiles_primary = 512;
@@ -32,7 +34,16 @@ int Project::num_pals_total = 13;
 
 Project::Project(QObject *parent) :
     QObject(parent)
-{ }
+{
+    this->scriptLabelIndex = new ScriptLabelIndex(this);
+    connect(this->scriptLabelIndex, &ScriptLabelIndex::globalLabelsChanged, this, [this] {
+        updateConstantsModel(Constants::GlobalScriptLabels);
+        emit eventScriptLabelsRead();
+    });
+    // Keep the shared models of project constants in sync with changes made while the project is open.
+    connect(this, &Project::mapCreated, this, [this] { updateConstantsModel(Constants::MapNames); });
+    connect(this, &Project::mapSectionIdNamesChanged, this, [this] { updateConstantsModel(Constants::Locations); });
+}
 
 Project::~Project()
 {
@@ -182,11 +193,19 @@ int Project::getSupportedMajorVersion(QString *errorOut) {
 }
 
 bool Project::load() {
+    PERF_TRACE("Project::load");
+    QElapsedTimer timer;
+    timer.start();
+    ParseUtil::resetReadStats();
+
     this->parser.setUpdatesSplashScreen(true);
     resetFileWatcher();
     resetFileCache();
     QPixmapCache::clear();
 
+    // Icon and sprite lookups are served from an index of the graphics folder, which is built while the rest of the project loads.
+    this->assetIndex.build(QString("%1/graphics").arg(this->root));
+
     this->disabledSettingsNames.clear();
     bool success = readGlobalConstants()
                 && readMapLayouts()
@@ -225,7 +244,15 @@ bool Project::load() {
         initNewLayoutSettings();
         initNewMapSettings();
         applyParsedLimits();
+        updateConstantsModels();
         logFileWatchStatus();
+
+        const ParseUtil::ReadStats stats = ParseUtil::readStats();
+        logInfo(QString("Loaded project in %1 ms (%2 ms spent reading %3 text files, %4 KB)")
+                    .arg(timer.elapsed())
+                    .arg(stats.nsecs / 1000000)
+                    .arg(stats.numFiles)
+                    .arg(stats.numBytes / 1024));
     }
     this->parser.setUpdatesSplashScreen(false);
     return success;
@@ -333,6 +360,7 @@ Layout *Project::loadLayout(const QString &layoutId) {
     if (isLoadedLayout(layoutId))
         return layout;
 
+    PERF_TRACE("Project::loadLayout", layoutId);
     // Force these to run even if one fails
     bool loadedTilesets = loadLayoutTilesets(layout);
     bool loadedBlockdata = layout->loadBlockdata(this->root);
@@ -410,6 +438,7 @@ bool Project::loadMapData(Map* map) {
     if (!map->isPersistedToFile()) {
         return true;
     }
+    PERF_TRACE("Project::loadMapData", map->name());
 
     QString error;
     QJsonDocument mapDoc = readMapJson(map->name(), &error);
@@ -503,6 +532,7 @@ bool Project::loadMapData(Map* map) {
 
 Map *Project::createNewMap(const Project::NewMapSettings &settings, const Map* toDuplicate) {
     Map *map = toDuplicate ? new Map(*toDuplicate) : new Map;
+    map->setScriptLabelIndex(this->scriptLabelIndex);
     map->setName(settings.name);
     map->setHeader(settings.header);
     map->setNeedsHealLocation(settings.canFlyTo);
@@ -617,6 +647,7 @@ void Project::clearMapLayouts() {
 }
 
 bool Project::readMapLayouts() {
+    PERF_TRACE("Project::readMapLayouts");
     clearMapLayouts();
 
     const QString layoutsFilepath = projectConfig.getFilePath(ProjectFilePath::json_layouts);
@@ -703,11 +734,6 @@ bool Project::readMapLayouts() {
 
 bool Project::saveMapLayouts() {
     QString layoutsFilepath = root + "/" + projectConfig.getFilePath(ProjectFilePath::json_layouts);
-    QFile layoutsFile(layoutsFilepath);
-    if (!layoutsFile.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: %2").arg(layoutsFilepath).arg(layoutsFile.errorString()));
-        return false;
-    }
 
     OrderedJson::object layoutsObj;
     layoutsObj["layouts_table_label"] = this->layoutsLabel;
@@ -750,13 +776,9 @@ bool Project::saveMapLayouts() {
     layoutsObj["layouts"] = layoutsArr;
     OrderedJson::append(&layoutsObj, this->customLayoutsData);
 
-    ignoreWatchedFileTemporarily(layoutsFilepath);
-
     OrderedJson layoutJson(layoutsObj);
     OrderedJsonDoc jsonDoc(&layoutJson);
-    jsonDoc.dump(&layoutsFile);
-    layoutsFile.close();
-    return true;
+    return writeFile(layoutsFilepath, jsonDoc.toByteArray());
 }
 
 bool Project::watchFile(const QString &filename) {
@@ -855,6 +877,7 @@ void Project::logFileWatchStatus() {
 
         // Similarly, avoid logging a warning every time we open a map. We can assume that will also fail.
         Map::setFileWatchingEnabled(false);
+        this->scriptLabelIndex->setFileWatchingEnabled(false);
         return;
     } else {
         logInfo(QString("Successfully monitoring %1/%2 project files").arg(numSuccessful).arg(numAttempted));
@@ -873,11 +896,6 @@ void Project::resetFileWatcher() {
 
 bool Project::saveMapGroups() {
     QString mapGroupsFilepath = QString("%1/%2").arg(root).arg(projectConfig.getFilePath(ProjectFilePath::json_map_groups));
-    QFile mapGroupsFile(mapGroupsFilepath);
-    if (!mapGroupsFile.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: %2").arg(mapGroupsFilepath).arg(mapGroupsFile.errorString()));
-        return false;
-    }
 
     OrderedJson::object mapGroupsObj;
 
@@ -900,22 +918,13 @@ bool Project::saveMapGroups() {
     }
     OrderedJson::append(&mapGroupsObj, this->customMapGroupsData);
 
-    ignoreWatchedFileTemporarily(mapGroupsFilepath);
-
     OrderedJson mapGroupJson(mapGroupsObj);
     OrderedJsonDoc jsonDoc(&mapGroupJson);
-    jsonDoc.dump(&mapGroupsFile);
-    mapGroupsFile.close();
-    return true;
+    return writeFile(mapGroupsFilepath, jsonDoc.toByteArray());
 }
 
 bool Project::saveRegionMapSections() {
     const QString filepath = QString("%1/%2").arg(this->root).arg(projectConfig.getFilePath(ProjectFilePath::json_region_map_entries));
-    QFile file(filepath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: %2").arg(filepath).arg(file.errorString()));
-        return false;
-    }
 
     OrderedJson::array mapSectionArray;
     for (const auto &idName : this->mapSectionIdNamesSaveOrder) {
@@ -943,23 +952,15 @@ bool Project::saveRegionMapSections() {
     object["map_sections"] = mapSectionArray;
     OrderedJson::append(&object, this->customMapSectionsData);
 
-    ignoreWatchedFileTemporarily(filepath);
     OrderedJson json(object);
     OrderedJsonDoc jsonDoc(&json);
-    jsonDoc.dump(&file);
-    file.close();
-    return true;
+    return writeFile(filepath, jsonDoc.toByteArray());
 }
 
 bool Project::saveWildMonData() {
     if (!this->wildEncountersLoaded) return true;
 
     QString wildEncountersJsonFilepath = QString("%1/%2").arg(root).arg(projectConfig.getFilePath(ProjectFilePath::json_wild_encounters));
-    QFile wildEncountersFile(wildEncountersJsonFilepath);
-    if (!wildEncountersFile.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: %2").arg(wildEncountersJsonFilepath).arg(wildEncountersFile.errorString()));
-        return false;
-    }
 
     OrderedJson::object wildEncountersObject;
     OrderedJson::array wildEncounterGroups;
@@ -1039,12 +1040,9 @@ bool Project::saveWildMonData() {
     wildEncountersObject["wild_encounter_groups"] = wildEncounterGroups;
     OrderedJson::append(&wildEncountersObject, this->customWildMonData);
 
-    ignoreWatchedFileTemporarily(wildEncountersJsonFilepath);
     OrderedJson encounterJson(wildEncountersObject);
     OrderedJsonDoc jsonDoc(&encounterJson);
-    jsonDoc.dump(&wildEncountersFile);
-    wildEncountersFile.close();
-    return true;
+    return writeFile(wildEncountersJsonFilepath, jsonDoc.toByteArray());
 }
 
 // For a map with a constant of 'MAP_FOO', returns a unique 'HEAL_LOCATION_FOO'.
@@ -1056,11 +1054,6 @@ QString Project::getNewHealLocationName(const Map* map) const {
 
 bool Project::saveHealLocations() {
     const QString filepath = QString("%1/%2").arg(this->root).arg(projectConfig.getFilePath(ProjectFilePath::json_heal_locations));
-    QFile file(filepath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: %2").arg(filepath).arg(file.errorString()));
-        return false;
-    }
 
     // Build the JSON data for output.
     QMap<QString, QList<OrderedJson::object>> idNameToJson;
@@ -1091,12 +1084,9 @@ bool Project::saveHealLocations() {
     object["heal_locations"] = eventJsonArr;
     OrderedJson::append(&object, this->customHealLocationsData);
 
-    ignoreWatchedFileTemporarily(filepath);
     OrderedJson json(object);
     OrderedJsonDoc jsonDoc(&json);
-    jsonDoc.dump(&file);
-    file.close();
-    return true;
+    return writeFile(filepath, jsonDoc.toByteArray());
 }
 
 bool Project::saveTilesets(Tileset *primaryTileset, Tileset *secondaryTileset) {
@@ -1175,7 +1165,6 @@ bool Project::saveTilesetMetatileLabels(Tileset *primaryTileset, Tileset *second
     outputText += QString("\n#endif // %1\n").arg(guardName);
 
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_metatile_labels);
-    ignoreWatchedFileTemporarily(root + "/" + filename);
     return saveTextFile(root + "/" + filename, outputText);
 }
 
@@ -1311,17 +1300,29 @@ void Project::setNewLayoutBorder(Layout *layout) {
     layout->lastCommitBlocks.borderDimensions = QSize(width, height);
 }
 
+// Only maps and layouts with unsaved changes are serialized. Their files, along with the global data files,
+// are collected in a SavePlan and written together once everything has been serialized.
 bool Project::saveAll() {
+    SavePlan plan;
+    this->savePlan = &plan;
+
     bool success = true;
     for (auto map : this->maps) {
-        if (!saveMap(map, true)) // Avoid double-saving the layouts
+        if (map->hasUnsavedChanges() && !saveMap(map, true)) // Avoid double-saving the layouts
             success = false;
     }
     for (auto layout : this->mapLayouts) {
-        if (!saveLayout(layout))
+        if (layout->hasUnsavedChanges() && !saveLayout(layout))
             success = false;
     }
     if (!saveGlobalData()) success = false;
+
+    this->savePlan = nullptr;
+    if (!writeSavePlan(&plan)) {
+        // Some of the global data may not have been written.
+        this->hasUnsavedDataChanges = true;
+        success = false;
+    }
     return success;
 }
 
@@ -1356,11 +1357,6 @@ bool Project::saveMap(Map *map, bool skipLayout) {
 
     // Create map.json for map data.
     QString mapFilepath = map->getJsonFilepath();
-    QFile mapFile(mapFilepath);
-    if (!mapFile.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: %2").arg(mapFilepath).arg(mapFile.errorString()));
-        return false;
-    }
 
     OrderedJson::object mapObj;
     // Header values.
@@ -1434,16 +1430,22 @@ bool Project::saveMap(Map *map, bool skipLayout) {
     // Custom header fields.
     OrderedJson::append(&mapObj, map->customAttributes());
 
-    ignoreWatchedFileTemporarily(mapFilepath);
-
     OrderedJson mapJson(mapObj);
     OrderedJsonDoc jsonDoc(&mapJson);
-    jsonDoc.dump(&mapFile);
-    mapFile.close();
+    const QByteArray mapData = jsonDoc.toByteArray();
+    if (map->isPersistedToFile()) {
+        if (!writeFile(mapFilepath, mapData, [map] { map->setClean(); }))
+            return false;
+    } else {
+        // New maps are left out of map_groups.json until they've been written, so they can't wait for the SavePlan.
+        SavePlan plan;
+        plan.addFile(mapFilepath, mapData, [map] { map->setClean(); });
+        if (!writeSavePlan(&plan))
+            return false;
+    }
 
     // Try to record the MAPSEC name in case this is a new name.
     addNewMapsec(map->header()->location());
-    map->setClean();
 
     if (!skipLayout && !saveLayout(map->layout()))
         return false;
@@ -1454,7 +1456,7 @@ bool Project::saveLayout(Layout *layout) {
     if (!layout || !isLoadedLayout(layout->id))
         return true;
 
-    if (!layout->save(this->root))
+    if (!layout->save(this->root, this->savePlan))
         return false;
 
     // Update global data structures with current map data.
@@ -1590,7 +1592,7 @@ Tileset *Project::createNewTileset(QString name, bool secondary, bool checkerboa
     // Create default metatiles
     const int tilesPerMetatile = projectConfig.getNumTilesInMetatile();
     for (int i = 0; i < tileset->maxMetatiles(); ++i) {
-        auto metatile = new Metatile();
+        Metatile metatile;
         for(int j = 0; j < tilesPerMetatile; ++j){
             Tile tile = Tile();
             if (checkerboardFill) {
@@ -1603,7 +1605,7 @@ Tileset *Project::createNewTileset(QString name, bool secondary, bool checkerboa
                 if (tileset->is_secondary)
                     tile.tileId += Project::getNumTilesPrimary();
             }
-            metatile->tiles.append(tile);
+            metatile.tiles.append(tile);
         }
         tileset->addMetatile(metatile);
     }
@@ -1669,6 +1671,7 @@ QString Project::findMetatileLabelsTileset(QString label) {
 }
 
 bool Project::readTilesetMetatileLabels() {
+    PERF_TRACE("Project::readTilesetMetatileLabels");
     metatileLabelsMap.clear();
     unusedMetatileLabels.clear();
 
@@ -1710,14 +1713,29 @@ void Project::loadTilesetMetatileLabels(Tileset* tileset) {
     }
 }
 
-bool Project::saveTextFile(const QString &path, const QString &text) {
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly)) {
-        logError(QString("Could not open '%1' for writing: ").arg(path) + file.errorString());
-        return false;
+// Writes 'data' to 'path', unless it's already up-to-date. If a SavePlan is in progress the write is queued instead,
+// and 'onSaved' is called once it's done. Otherwise the file is written immediately.
+bool Project::writeFile(const QString &path, const QByteArray &data, const std::function<void()> &onSaved) {
+    if (this->savePlan) {
+        this->savePlan->addFile(path, data, onSaved);
+        return true;
     }
-    file.write(text.toUtf8());
-    return true;
+    SavePlan plan;
+    plan.addFile(path, data, onSaved);
+    return writeSavePlan(&plan);
+}
+
+// Writes the plan's files. The file watcher is told to ignore the files that were written, so that they aren't reported
+// as having been changed outside of Porymap. Unchanged files aren't touched, so changes made to them elsewhere are still reported.
+bool Project::writeSavePlan(SavePlan *plan) {
+    QStringList writtenPaths;
+    const bool success = plan->write(&writtenPaths);
+    ignoreWatchedFilesTemporarily(writtenPaths);
+    return success;
+}
+
+bool Project::saveTextFile(const QString &path, const QString &text) {
+    return writeFile(path, text.toUtf8());
 }
 
 bool Project::appendTextFile(const QString &path, const QString &text) {
@@ -1731,9 +1749,11 @@ bool Project::appendTextFile(const QString &path, const QString &text) {
 }
 
 bool Project::readWildMonData() {
+    PERF_TRACE("Project::readWildMonData");
     this->extraEncounterGroups.clear();
     this->wildMonFields.clear();
     this->wildMonData.clear();
+    this->wildMonIndex.clear();
     this->wildMonTableName.clear();
     this->encounterGroupLabels.clear();
     this->pokemonMinLevel = 0;
@@ -1915,11 +1935,13 @@ bool Project::readWildMonData() {
         setDefaultEncounterRate(i.key(), rate);
     }
 
+    this->wildMonIndex.build(this->wildMonData);
     this->wildEncountersLoaded = true;
     return true;
 }
 
 bool Project::readMapGroups() {
+    PERF_TRACE("Project::readMapGroups");
     clearMaps();
     this->mapConstantsToMapNames.clear();
     this->alphabeticalMapNames.clear();
@@ -2016,6 +2038,7 @@ bool Project::readMapGroups() {
 
             // Success, create the Map object
             auto map = new Map;
+            map->setScriptLabelIndex(this->scriptLabelIndex);
             map->setName(mapName);
             map->setConstantName(mapConstant);
 
@@ -2279,6 +2302,7 @@ void Project::appendTilesetLabel(const QString &label, const QString &isSecondar
 }
 
 bool Project::readTilesetLabels() {
+    PERF_TRACE("Project::readTilesetLabels");
     this->primaryTilesetLabels.clear();
     this->secondaryTilesetLabels.clear();
     this->tilesetLabelsOrdered.clear();
@@ -2326,6 +2350,7 @@ bool Project::readTilesetLabels() {
 }
 
 bool Project::readFieldmapProperties() {
+    PERF_TRACE("Project::readFieldmapProperties");
     const QString numTilesPrimaryName = projectConfig.getIdentifier(ProjectIdentifier::define_tiles_primary);
     const QString numTilesTotalName = projectConfig.getIdentifier(ProjectIdentifier::define_tiles_total);
     const QString numMetatilesPrimaryName = projectConfig.getIdentifier(ProjectIdentifier::define_metatiles_primary);
@@ -2431,6 +2456,7 @@ bool Project::readFieldmapProperties() {
 
 // Read data masks for Blocks and metatile attributes.
 bool Project::readFieldmapMasks() {
+    PERF_TRACE("Project::readFieldmapMasks");
     this->encounterTypeToName.clear();
     this->terrainTypeToName.clear();
 
@@ -2559,6 +2585,7 @@ bool Project::readFieldmapMasks() {
 }
 
 bool Project::readRegionMapSections() {
+    PERF_TRACE("Project::readRegionMapSections");
     this->locationData.clear();
     this->mapSectionIdNames.clear();
     this->mapSectionIdNamesSaveOrder.clear();
@@ -2732,6 +2759,7 @@ void Project::clearHealLocations() {
 }
 
 bool Project::readHealLocations() {
+    PERF_TRACE("Project::readHealLocations");
     clearHealLocations();
 
     QJsonDocument doc;
@@ -2763,6 +2791,7 @@ bool Project::readHealLocations() {
 }
 
 bool Project::readItemNames() {
+    PERF_TRACE("Project::readItemNames");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_items);
     watchFile(filename);
     QString error;
@@ -2773,6 +2802,7 @@ bool Project::readItemNames() {
 }
 
 bool Project::readFlagNames() {
+    PERF_TRACE("Project::readFlagNames");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_flags);
     watchFile(filename);
     QString error;
@@ -2783,6 +2813,7 @@ bool Project::readFlagNames() {
 }
 
 bool Project::readVarNames() {
+    PERF_TRACE("Project::readVarNames");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_vars);
     watchFile(filename);
     QString error;
@@ -2793,6 +2824,7 @@ bool Project::readVarNames() {
 }
 
 bool Project::readMovementTypes() {
+    PERF_TRACE("Project::readMovementTypes");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_obj_event_movement);
     watchFile(filename);
     QString error;
@@ -2803,6 +2835,7 @@ bool Project::readMovementTypes() {
 }
 
 bool Project::readInitialFacingDirections() {
+    PERF_TRACE("Project::readInitialFacingDirections");
     QString filename = projectConfig.getFilePath(ProjectFilePath::initial_facing_table);
     watchFile(filename);
     QString error;
@@ -2813,6 +2846,7 @@ bool Project::readInitialFacingDirections() {
 }
 
 bool Project::readMapTypes() {
+    PERF_TRACE("Project::readMapTypes");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_map_types);
     // File already being watched
     QString error;
@@ -2823,6 +2857,7 @@ bool Project::readMapTypes() {
 }
 
 bool Project::readMapBattleScenes() {
+    PERF_TRACE("Project::readMapBattleScenes");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_map_types);
     // File already being watched
     QString error;
@@ -2833,6 +2868,7 @@ bool Project::readMapBattleScenes() {
 }
 
 bool Project::readWeatherNames() {
+    PERF_TRACE("Project::readWeatherNames");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_weather);
     watchFile(filename);
     QString error;
@@ -2843,6 +2879,7 @@ bool Project::readWeatherNames() {
 }
 
 bool Project::readCoordEventWeatherNames() {
+    PERF_TRACE("Project::readCoordEventWeatherNames");
     if (!projectConfig.eventWeatherTriggerEnabled)
         return true;
 
@@ -2856,6 +2893,7 @@ bool Project::readCoordEventWeatherNames() {
 }
 
 bool Project::readSecretBaseIds() {
+    PERF_TRACE("Project::readSecretBaseIds");
     if (!projectConfig.eventSecretBaseEnabled)
         return true;
 
@@ -2869,6 +2907,7 @@ bool Project::readSecretBaseIds() {
 }
 
 bool Project::readBgEventFacingDirections() {
+    PERF_TRACE("Project::readBgEventFacingDirections");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_event_bg);
     watchFile(filename);
     QString error;
@@ -2879,6 +2918,7 @@ bool Project::readBgEventFacingDirections() {
 }
 
 bool Project::readTrainerTypes() {
+    PERF_TRACE("Project::readTrainerTypes");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_trainer_types);
     watchFile(filename);
     QString error;
@@ -2889,6 +2929,7 @@ bool Project::readTrainerTypes() {
 }
 
 bool Project::readMetatileBehaviors() {
+    PERF_TRACE("Project::readMetatileBehaviors");
     this->metatileBehaviorMap.clear();
     this->metatileBehaviorMapInverse.clear();
 
@@ -2914,6 +2955,7 @@ bool Project::readMetatileBehaviors() {
 }
 
 bool Project::readSongNames() {
+    PERF_TRACE("Project::readSongNames");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_songs);
     watchFile(filename);
     QString error;
@@ -2929,6 +2971,7 @@ bool Project::readSongNames() {
 }
 
 bool Project::readObjEventGfxConstants() {
+    PERF_TRACE("Project::readObjEventGfxConstants");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_obj_events);
     watchFile(filename);
     QString error;
@@ -2944,6 +2987,7 @@ bool Project::readObjEventGfxConstants() {
 }
 
 bool Project::readMiscellaneousConstants() {
+    PERF_TRACE("Project::readMiscellaneousConstants");
     const QString filename = projectConfig.getFilePath(ProjectFilePath::constants_global);
     const QString maxObjectEventsName = projectConfig.getIdentifier(ProjectIdentifier::define_obj_event_count);
     watchFile(filename);
@@ -2971,6 +3015,7 @@ bool Project::readMiscellaneousConstants() {
 }
 
 bool Project::readGlobalConstants() {
+    PERF_TRACE("Project::readGlobalConstants");
     this->parser.resetCDefines();
     for (const auto &path : projectConfig.globalConstantsFilepaths) {
         QString error;
@@ -2983,9 +3028,10 @@ bool Project::readGlobalConstants() {
     return true;
 }
 
+// Script labels are only needed for autocomplete, so rather than reading them during the project load
+// we hand the files to the index, which scans them in the background and emits eventScriptLabelsRead when it's done.
 bool Project::readEventScriptLabels() {
-    this->globalScriptLabels.clear();
-
+    PERF_TRACE("Project::readEventScriptLabels");
     QStringList paths;
     if (porymapConfig.scriptAutocompleteMode == ScriptAutocompleteMode::All) {
         paths = getAllEventScriptsFilepaths();
@@ -2993,24 +3039,12 @@ bool Project::readEventScriptLabels() {
         paths = getCommonEventScriptsFilepaths();
     }
 
-    for (const auto &path : paths) {
-        this->globalScriptLabels << ParseUtil::getGlobalScriptLabels(path);
-    }
-    this->globalScriptLabels.sort(Qt::CaseInsensitive);
-    this->globalScriptLabels.removeDuplicates();
-
-    emit eventScriptLabelsRead();
+    this->scriptLabelIndex->setCacheFilepath(ScriptLabelIndex::cacheFilepathFor(this->root));
+    this->scriptLabelIndex->setFileWatchingEnabled(porymapConfig.monitorFiles);
+    this->scriptLabelIndex->setGlobalFiles(paths);
     return true;
 }
 
-void Project::insertGlobalScriptLabels(QStringList &scriptLabels) const {
-    if (this->globalScriptLabels.isEmpty())
-        return;
-    scriptLabels.append(this->globalScriptLabels);
-    scriptLabels.sort();
-    scriptLabels.removeDuplicates();
-}
-
 QString Project::fixPalettePath(const QString &path) const {
     return Util::replaceExtension(path, QStringLiteral("pal"));
 }
@@ -3082,11 +3116,24 @@ void Project::loadEventPixmap(Event *event, bool forceLoad) {
 }
 
 void Project::clearEventGraphics() {
+    const EventSpriteAtlas::Stats stats = this->eventSpriteAtlas.stats();
+    if (stats.hits + stats.misses > 0) {
+        logInfo(QString("Event sprite cache: %1 hits, %2 misses, %3 evictions (%4 sprites in %5 KB)")
+                    .arg(stats.hits)
+                    .arg(stats.misses)
+                    .arg(stats.evictions)
+                    .arg(stats.numSprites)
+                    .arg(stats.bytes / 1024));
+    }
+    this->eventSpriteAtlas.clear();
+
     qDeleteAll(this->eventGraphicsMap);
     this->eventGraphicsMap.clear();
+    this->eventGraphicsById.clear();
 }
 
 bool Project::readEventGraphics() {
+    PERF_TRACE("Project::readEventGraphics");
     clearEventGraphics();
 
     const QString pointersFilepath = projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_pointers);
@@ -3166,12 +3213,38 @@ bool Project::readEventGraphics() {
         // Inanimate events will only ever use the first frame of their spritesheet.
         gfx->inanimate = ParseUtil::gameStringToBool(gfxInfoAttributes.value("inanimate"));
 
+        gfx->id = this->eventGraphicsById.length();
+        this->eventGraphicsById.append(gfx);
         this->eventGraphicsMap.insert(gfxName, gfx);
     }
+
+    // Start reading the spritesheets now, so they're likely to be ready by the time a map's events are displayed.
+    QStringList spritesheetPaths;
+    for (const auto &gfx : this->eventGraphicsById) {
+        if (!gfx->filepath.isEmpty())
+            spritesheetPaths.append(QString("%1/%2").arg(this->root).arg(gfx->filepath));
+    }
+    spritesheetPaths.removeDuplicates();
+    this->eventSpriteAtlas.setMaxBytes(static_cast<qint64>(porymapConfig.eventSpriteCacheSize) * 1024 * 1024);
+    this->eventSpriteAtlas.preload(spritesheetPaths);
     return true;
 }
 
 QPixmap Project::getEventPixmap(const QString &gfxName, const QString &movementName) {
+    return getEventPixmap(getEventSpriteKey(gfxName, movementName));
+}
+
+QPixmap Project::getEventPixmap(const QString &gfxName, int frame, bool hFlip) {
+    return getEventPixmap(getEventSpriteKey(gfxName, frame, hFlip));
+}
+
+QPixmap Project::getEventPixmap(EventSpriteAtlas::Key key) {
+    if (!getEventSprite(key, nullptr))
+        return QPixmap();
+    return this->eventSpriteAtlas.pixmap(key);
+}
+
+EventSpriteAtlas::Key Project::getEventSpriteKey(const QString &gfxName, const QString &movementName) const {
     struct FrameData {
         int index;
         bool hFlip;
@@ -3189,16 +3262,23 @@ QPixmap Project::getEventPixmap(const QString &gfxName, const QString &movementN
     };
     const QString direction = this->facingDirections.value(movementName, "DIR_SOUTH");
     auto frameData = directionToFrameData.value(direction);
-    return getEventPixmap(gfxName, frameData.index, frameData.hFlip);
+    return getEventSpriteKey(gfxName, frameData.index, frameData.hFlip);
 }
 
-QPixmap Project::getEventPixmap(const QString &gfxName, int frame, bool hFlip) {
-    QPixmap pixmap;
-    const QString cacheKey = QString("EVENT#%1#%2#%3").arg(gfxName).arg(frame).arg(hFlip ? "1" : "0");
-    if (QPixmapCache::find(cacheKey, &pixmap)) {
-        return pixmap;
+EventSpriteAtlas::Key Project::getEventSpriteKey(const QString &gfxName, int frame, bool hFlip) const {
+    const EventGraphics *gfx = getEventGraphics(gfxName);
+    if (!gfx)
+        return 0;
+
+    // Inanimate events only ever use the first frame, so they can share a single sprite regardless of direction.
+    if (gfx->inanimate) {
+        frame = 0;
+        hFlip = false;
     }
+    return EventSpriteAtlas::makeKey(gfx->id, frame, hFlip);
+}
 
+Project::EventGraphics *Project::getEventGraphics(const QString &gfxName) const {
     EventGraphics* gfx = this->eventGraphicsMap.value(gfxName, nullptr);
     if (!gfx) {
         // Invalid gfx constant. If this is a number, try to use that instead.
@@ -3206,10 +3286,39 @@ QPixmap Project::getEventPixmap(const QString &gfxName, int frame, bool hFlip) {
         int gfxNum = ParseUtil::gameStringToInt(gfxName, &ok);
         if (ok) gfx = this->eventGraphicsMap.value(this->gfxDefines.key(gfxNum, "NULL"), nullptr);
     }
+    return gfx;
+}
+
+// Finds the sprite for 'key' in the event sprite atlas, adding it to the atlas if it isn't there already.
+// Returns false if the key is invalid, or the sprite's image couldn't be loaded.
+bool Project::getEventSprite(EventSpriteAtlas::Key key, EventSpriteAtlas::Sprite *sprite, bool countLookup) {
+    if (!key)
+        return false;
+    if (this->eventSpriteAtlas.find(key, sprite, countLookup))
+        return true;
+
+    const int gfxId = static_cast<int>(key >> 32) - 1;
+    const int frame = static_cast<int>((key >> 1) & 0x7FFFFFFF);
+    const bool hFlip = key & 1;
+    const QImage image = getEventFrameImage(this->eventGraphicsById.value(gfxId, nullptr), frame, hFlip);
+    if (image.isNull())
+        return false;
+
+    const EventSpriteAtlas::Sprite inserted = this->eventSpriteAtlas.insert(key, image);
+    if (sprite) *sprite = inserted;
+    return !inserted.isNull();
+}
+
+QImage Project::getEventFrameImage(EventGraphics *gfx, int frame, bool hFlip) {
     if (gfx && !gfx->loaded) {
-        // This is the first request for this event's sprite. We'll attempt to load it now.
+        // This is the first request for this event's sprite. We'll attempt to load it now, unless it was already read in the background.
         if (!gfx->filepath.isEmpty()) {
-            gfx->spritesheet = QImage(QString("%1/%2").arg(this->root).arg(gfx->filepath));
+            const QString filepath = QString("%1/%2").arg(this->root).arg(gfx->filepath);
+            gfx->spritesheet = this->eventSpriteAtlas.takeSpritesheet(filepath);
+            if (gfx->spritesheet.isNull()) {
+                const QString indexedFilepath = this->assetIndex.find(filepath);
+                gfx->spritesheet = QImage(!indexedFilepath.isEmpty() ? indexedFilepath : filepath);
+            }
             if (gfx->spritesheet.isNull()) {
                 logWarn(QString("Failed to open '%1' for event's sprite. Event will use a default sprite instead.").arg(gfx->filepath));
             } else {
@@ -3227,7 +3336,7 @@ QPixmap Project::getEventPixmap(const QString &gfxName, int frame, bool hFlip) {
     }
     if (!gfx || gfx->spritesheet.width() == 0 || gfx->spritesheet.height() == 0) {
         // Either we didn't recognize the gfxName, or we were unable to load the sprite's image.
-        return QPixmap();
+        return QImage();
     }
 
     QImage img;
@@ -3247,10 +3356,7 @@ QPixmap Project::getEventPixmap(const QString &gfxName, int frame, bool hFlip) {
     }
     // Set first palette color fully transparent.
     img.setColor(0, qRgba(0, 0, 0, 0));
-
-    pixmap = QPixmap::fromImage(img);
-    QPixmapCache::insert(cacheKey, pixmap);
-    return pixmap;
+    return img;
 }
 
 QPixmap Project::getEventPixmap(Event::Group group) {
@@ -3288,6 +3394,7 @@ QPixmap Project::getEventPixmap(Event::Group group) {
 }
 
 bool Project::readSpeciesIconPaths() {
+    PERF_TRACE("Project::readSpeciesIconPaths");
     this->speciesToIconPath.clear();
     this->speciesNames.clear();
 
@@ -3367,6 +3474,60 @@ QString Project::getDefaultSpeciesIconPath(const QString &species) {
     return path;
 }
 
+ConstantsModel *Project::getConstantsModel(Constants constants) {
+    ConstantsModel *model = this->constantsModels.value(constants);
+    if (!model) {
+        model = new ConstantsModel(this);
+        this->constantsModels.insert(constants, model);
+        updateConstantsModel(constants);
+    }
+    // Existing models are already up-to-date. They're updated when the project is loaded and whenever their constants change,
+    // so there's no need to compare them against the project's lists each time they're requested (e.g. once per event frame).
+    return model;
+}
+
+// Brings the model for the given constants (if one has been created) up-to-date with the project's data.
+void Project::updateConstantsModel(Constants constants) {
+    ConstantsModel *model = this->constantsModels.value(constants);
+    if (!model)
+        return;
+
+    switch (constants) {
+    case Constants::Flags:                   model->setStrings(this->flagNames); break;
+    case Constants::Vars:                    model->setStrings(this->varNames); break;
+    case Constants::Items:                   model->setStrings(this->itemNames); break;
+    case Constants::Sprites:                 model->setStrings(this->gfxDefines.keys()); break;
+    case Constants::MovementTypes:           model->setStrings(this->movementTypes); break;
+    case Constants::TrainerTypes:            model->setStrings(this->trainerTypes); break;
+    case Constants::CoordEventWeathers:      model->setStrings(this->coordEventWeatherNames); break;
+    case Constants::BgEventFacingDirections: model->setStrings(this->bgEventFacingDirections); break;
+    case Constants::SecretBaseIds:           model->setStrings(this->secretBaseIds); break;
+    case Constants::MapNames:                model->setStrings(this->mapNames()); break;
+    case Constants::Species:                 model->setStrings(this->speciesNames); break;
+    case Constants::GlobalScriptLabels:      model->setStrings(this->scriptLabelIndex->globalLabels()); break;
+    case Constants::Songs:                   model->setStrings(this->songNames); break;
+    case Constants::Weathers:                model->setStrings(this->weatherNames); break;
+    case Constants::MapTypes:                model->setStrings(this->mapTypes); break;
+    case Constants::BattleScenes:            model->setStrings(this->mapBattleScenes); break;
+    case Constants::Locations:               model->setStrings(this->locationNames()); break;
+    case Constants::MetatileBehaviors: {
+        // Behaviors are listed in order of their value, which is available with Qt::UserRole.
+        QList<QVariant> values;
+        for (auto it = this->metatileBehaviorMapInverse.constBegin(); it != this->metatileBehaviorMapInverse.constEnd(); it++) {
+            values.append(it.key());
+        }
+        model->setItems(this->metatileBehaviorMapInverse.values(), values);
+        break;
+    }
+    }
+}
+
+void Project::updateConstantsModels() {
+    for (auto it = this->constantsModels.constBegin(); it != this->constantsModels.constEnd(); it++) {
+        updateConstantsModel(it.key());
+    }
+}
+
 // The name permuting in here is overkill, but it's making up for some of the fragility in the way we find pokémon icon paths.
 // For pokeemerald-expansion in particular this function is solely responsible for finding pokémon icons, because they have no icon table.
 QString Project::findSpeciesIconPath(const QStringList &names) const {
@@ -3391,8 +3552,18 @@ QString Project::findSpeciesIconPath(const QStringList &names) const {
     for (const auto &dir : possibleDirNames) {
         if (dir.isEmpty()) continue;
 
-        const QString path = QString("%1%2/icon.png").arg(basePath).arg(dir);
-        if (QFile::exists(path))
+        const QString path = this->assetIndex.find(QString("%1%2/icon.png").arg(basePath).arg(dir));
+        if (!path.isEmpty())
+            return path;
+    }
+
+    // None of the permutations matched exactly. Try again with the original names, ignoring the difference between
+    // underscores, directory separators and camel case (Ex: 'foo_bar_baz' could also be 'foo/bar/baz' or 'FooBarBaz').
+    for (const auto &dir : names) {
+        if (dir.isEmpty()) continue;
+
+        const QString path = this->assetIndex.findFuzzy(QString("%1%2/icon.png").arg(basePath).arg(dir));
+        if (!path.isEmpty())
             return path;
     }
     return QString();
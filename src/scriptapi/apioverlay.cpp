@@ -228,7 +228,7 @@ void MapView::rotate(int degrees) {
 }
 
 void MapView::addText(QString text, int x, int y, QString color, int fontSize, int layer) {
-    this->getOverlay(layer)->addText(text, x, y, color, fontSize);
+    this->getOverlay(layer)->addText(text, x, y, color, fontSize, this->font());
     this->updateScene();
 }
 
@@ -237,6 +237,36 @@ void MapView::addRect(int x, int y, int width, int height, QString borderColor,
         this->updateScene();
 }
 
+// Adds many rectangles at once, which is much faster than calling addRect for each of them.
+void MapView::addRects(QJSValue rects, QString borderColor, QString fillColor, int rounding, int layer) {
+    if (!rects.isArray()) {
+        logError("Overlay rects must be an array.");
+        return;
+    }
+
+    Overlay * overlay = this->getOverlay(layer);
+    const int length = rects.property("length").toInt();
+    bool added = false;
+    for (int i = 0; i < length; i++) {
+        const QJSValue rect = rects.property(i);
+        if (!rect.hasProperty("x") || !rect.hasProperty("y") || !rect.hasProperty("width") || !rect.hasProperty("height")) {
+            logWarn(QString("Element %1 of overlay rects does not have an x, y, width, and height.").arg(i));
+            continue;
+        }
+        // Each rectangle can override the colors and rounding shared by the others.
+        if (overlay->addRect(rect.property("x").toInt(),
+                             rect.property("y").toInt(),
+                             rect.property("width").toInt(),
+                             rect.property("height").toInt(),
+                             rect.hasProperty("borderColor") ? rect.property("borderColor").toString() : borderColor,
+                             rect.hasProperty("fillColor") ? rect.property("fillColor").toString() : fillColor,
+                             rect.hasProperty("rounding") ? rect.property("rounding").toInt() : rounding))
+            added = true;
+    }
+    if (added)
+        this->updateScene();
+}
+
 void MapView::addPath(QList<int> xCoords, QList<int> yCoords, QString borderColor, QString fillColor, int layer) {
     if (this->getOverlay(layer)->addPath(xCoords, yCoords, borderColor, fillColor))
         this->updateScene();
@@ -261,6 +291,29 @@ void MapView::addImage(int x, int y, QString filepath, int layer, bool useCache)
         this->updateScene();
 }
 
+// Adds many images at once, which is much faster than calling addImage for each of them.
+void MapView::addImages(QJSValue images, int layer, bool useCache) {
+    if (!images.isArray()) {
+        logError("Overlay images must be an array.");
+        return;
+    }
+
+    Overlay * overlay = this->getOverlay(layer);
+    const int length = images.property("length").toInt();
+    bool added = false;
+    for (int i = 0; i < length; i++) {
+        const QJSValue image = images.property(i);
+        if (!image.hasProperty("x") || !image.hasProperty("y") || !image.hasProperty("filepath")) {
+            logWarn(QString("Element %1 of overlay images does not have an x, y, and filepath.").arg(i));
+            continue;
+        }
+        if (overlay->addImage(image.property("x").toInt(), image.property("y").toInt(), image.property("filepath").toString(), useCache))
+            added = true;
+    }
+    if (added)
+        this->updateScene();
+}
+
 void MapView::createImage(int x, int y, QString filepath, int width, int height, int xOffset, int yOffset, qreal hScale, qreal vScale, int paletteId, bool setTransparency, int layer, bool useCache) {
     if (!this->editor || !this->editor->layout || !this->editor->layout->tileset_primary || !this->editor->layout->tileset_secondary)
         return;
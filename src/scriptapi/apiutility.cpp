@@ -54,6 +54,14 @@ bool ScriptUtility::registerToggleAction(QString functionName, QString actionNam
     return true;
 }
 
+// Background actions run on a worker thread with their own script engine, so a long-running action doesn't freeze Porymap.
+bool ScriptUtility::registerBackgroundAction(QString functionName, QString actionName, QString shortcut) {
+    if (!registerAction(functionName, actionName, shortcut))
+        return false;
+    this->backgroundActions.insert(this->registeredActions.length() - 1);
+    return true;
+}
+
 QString ScriptUtility::getActionFunctionName(int actionIndex) {
     return this->actionMap.value(actionIndex);
 }
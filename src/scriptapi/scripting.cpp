@@ -5,6 +5,7 @@
 #include "log.h"
 #include "config.h"
 #include "mainwindow.h"
+#include "perftrace.h"
 
 const QMap<CallbackType, QString> callbackFunctions = {
     {OnProjectOpened, "onProjectOpened"},
@@ -48,11 +49,13 @@ Scripting::Scripting(MainWindow *mainWindow) {
     }
     this->loadModules(this->filepaths);
     this->scriptUtility = new ScriptUtility(mainWindow);
+    this->worker = new ScriptWorker(mainWindow);
 }
 
 Scripting::~Scripting() {
     if (mainWindow) mainWindow->clearOverlay();
     this->engine->setInterrupted(true);
+    delete this->worker;
     qDeleteAll(this->imageCache);
     delete this->engine;
     delete this->scriptUtility;
@@ -95,40 +98,50 @@ void Scripting::populateGlobalObject(MainWindow *mainWindow) {
     QQmlEngine::setObjectOwnership(mainWindow->ui->graphicsView_Map, QQmlEngine::CppOwnership);
     QQmlEngine::setObjectOwnership(instance->scriptUtility, QQmlEngine::CppOwnership);
 
-    QJSValue constants = instance->engine->newObject();
+    setConstants(instance->engine, getConstants(mainWindow));
+}
+
+// The constants are read into a QVariantMap first so that they can also be given to
+// the script engines of background actions, which can't read from the project themselves.
+QVariantMap Scripting::getConstants(MainWindow *mainWindow) {
+    QVariantMap constants;
 
     // Get version numbers
-    QJSValue version = instance->engine->newObject();
-    version.setProperty("major", porymapVersion.majorVersion());
-    version.setProperty("minor", porymapVersion.minorVersion());
-    version.setProperty("patch", porymapVersion.microVersion());
-    constants.setProperty("version", version);
+    QVariantMap version;
+    version.insert("major", porymapVersion.majorVersion());
+    version.insert("minor", porymapVersion.minorVersion());
+    version.insert("patch", porymapVersion.microVersion());
+    constants.insert("version", version);
 
     // Get basic tileset information
-    constants.setProperty("max_primary_tiles", Project::getNumTilesPrimary());
-    constants.setProperty("max_secondary_tiles", Project::getNumTilesSecondary());
-    constants.setProperty("max_primary_metatiles", Project::getNumMetatilesPrimary());
-    constants.setProperty("max_secondary_metatiles", Project::getNumMetatilesSecondary());
-    constants.setProperty("num_primary_palettes", Project::getNumPalettesPrimary());
-    constants.setProperty("num_secondary_palettes", Project::getNumPalettesSecondary());
-    constants.setProperty("layers_per_metatile", projectConfig.getNumLayersInMetatile());
-    constants.setProperty("tiles_per_metatile", projectConfig.getNumTilesInMetatile());
+    constants.insert("max_primary_tiles", Project::getNumTilesPrimary());
+    constants.insert("max_secondary_tiles", Project::getNumTilesSecondary());
+    constants.insert("max_primary_metatiles", Project::getNumMetatilesPrimary());
+    constants.insert("max_secondary_metatiles", Project::getNumMetatilesSecondary());
+    constants.insert("num_primary_palettes", Project::getNumPalettesPrimary());
+    constants.insert("num_secondary_palettes", Project::getNumPalettesSecondary());
+    constants.insert("layers_per_metatile", projectConfig.getNumLayersInMetatile());
+    constants.insert("tiles_per_metatile", projectConfig.getNumTilesInMetatile());
 
-    constants.setProperty("base_game_version", projectConfig.getBaseGameVersionString());
+    constants.insert("base_game_version", projectConfig.getBaseGameVersionString());
 
     // Read out behavior values into constants object
-    QJSValue behaviorsArray = instance->engine->newObject();
+    QVariantMap behaviors;
     const QMap<QString, uint32_t> * map = &mainWindow->editor->project->metatileBehaviorMap;
     for (auto i = map->cbegin(), end = map->cend(); i != end; i++)
-        behaviorsArray.setProperty(i.key(), i.value());
-    constants.setProperty("metatile_behaviors", behaviorsArray);
+        behaviors.insert(i.key(), i.value());
+    constants.insert("metatile_behaviors", behaviors);
+
+    return constants;
+}
 
-    instance->engine->globalObject().setProperty("constants", constants);
+void Scripting::setConstants(QJSEngine *engine, const QVariantMap &constants) {
+    engine->globalObject().setProperty("constants", engine->toScriptValue(constants));
 
     // Prevent changes to the constants object
-    instance->engine->evaluate("Object.freeze(constants.metatile_behaviors);");
-    instance->engine->evaluate("Object.freeze(constants.version);");
-    instance->engine->evaluate("Object.freeze(constants);");
+    engine->evaluate("Object.freeze(constants.metatile_behaviors);");
+    engine->evaluate("Object.freeze(constants.version);");
+    engine->evaluate("Object.freeze(constants);");
 }
 
 bool Scripting::tryErrorJS(QJSValue js) {
@@ -159,6 +172,7 @@ bool Scripting::tryErrorJS(QJSValue js) {
 }
 
 void Scripting::invokeCallback(CallbackType type, QJSValueList args) {
+    PERF_TRACE("Scripting::invokeCallback", callbackFunctions[type]);
     for (QJSValue module : this->modules) {
         QString functionName = callbackFunctions[type];
         QJSValue callbackFunction = module.property(functionName);
@@ -174,6 +188,12 @@ void Scripting::invokeAction(int actionIndex) {
     QString functionName = instance->scriptUtility->getActionFunctionName(actionIndex);
     if (functionName.isEmpty()) return;
 
+    if (instance->scriptUtility->isBackgroundAction(actionIndex)) {
+        instance->worker->start(functionName, instance->filepaths);
+        return;
+    }
+
+    PERF_TRACE("Scripting::invokeAction", functionName);
     bool foundFunction = false;
     for (QJSValue module : instance->modules) {
         QJSValue callbackFunction = module.property(functionName);
@@ -0,0 +1,389 @@
+#ifdef QT_QML_LIB
+#include <QQmlEngine>
+#include <QProgressBar>
+#include <QStatusBar>
+#include <QToolButton>
+
+#include "scriptworker.h"
+#include "scripting.h"
+#include "mainwindow.h"
+#include "editcommands.h"
+#include "perftrace.h"
+#include "log.h"
+
+ScriptWorkerApi::ScriptWorkerApi(QJSEngine *engine, const LayoutSnapshot &layout, ScriptWorkerJob *job)
+    : m_engine(engine),
+      m_layout(layout),
+      m_job(job),
+      m_blockdata(layout.blockdata),
+      m_border(layout.border)
+{}
+
+int ScriptWorkerApi::blockIndex(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_layout.width || y >= m_layout.height)
+        return -1;
+    const int i = y * m_layout.width + x;
+    return (i < m_blockdata.length()) ? i : -1;
+}
+
+int ScriptWorkerApi::borderIndex(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_layout.borderWidth || y >= m_layout.borderHeight)
+        return -1;
+    const int i = y * m_layout.borderWidth + x;
+    return (i < m_border.length()) ? i : -1;
+}
+
+const Metatile *ScriptWorkerApi::getMetatile(int metatileId) const {
+    return Tileset::getMetatile(metatileId, m_layout.primaryTileset.get(), m_layout.secondaryTileset.get());
+}
+
+int ScriptWorkerApi::getWidth() {
+    return m_layout.width;
+}
+
+int ScriptWorkerApi::getHeight() {
+    return m_layout.height;
+}
+
+int ScriptWorkerApi::getBorderWidth() {
+    return m_layout.borderWidth;
+}
+
+int ScriptWorkerApi::getBorderHeight() {
+    return m_layout.borderHeight;
+}
+
+QJSValue ScriptWorkerApi::getBlock(int x, int y) {
+    const int i = blockIndex(x, y);
+    const Block block = (i >= 0) ? m_blockdata.at(i) : Block();
+    QJSValue obj = m_engine->newObject();
+    obj.setProperty("metatileId", block.metatileId());
+    obj.setProperty("collision", block.collision());
+    obj.setProperty("elevation", block.elevation());
+    obj.setProperty("rawValue", block.rawValue());
+    return obj;
+}
+
+void ScriptWorkerApi::setBlock(int x, int y, int metatileId, int collision, int elevation) {
+    const int i = blockIndex(x, y);
+    if (i >= 0) m_blockdata[i] = Block(metatileId, collision, elevation);
+}
+
+void ScriptWorkerApi::setBlock(int x, int y, int rawValue) {
+    const int i = blockIndex(x, y);
+    if (i >= 0) m_blockdata[i] = Block(static_cast<uint16_t>(rawValue));
+}
+
+int ScriptWorkerApi::getMetatileId(int x, int y) {
+    const int i = blockIndex(x, y);
+    return (i >= 0) ? m_blockdata.at(i).metatileId() : 0;
+}
+
+void ScriptWorkerApi::setMetatileId(int x, int y, int metatileId) {
+    const int i = blockIndex(x, y);
+    if (i >= 0) m_blockdata[i].setMetatileId(metatileId);
+}
+
+int ScriptWorkerApi::getCollision(int x, int y) {
+    const int i = blockIndex(x, y);
+    return (i >= 0) ? m_blockdata.at(i).collision() : 0;
+}
+
+void ScriptWorkerApi::setCollision(int x, int y, int collision) {
+    const int i = blockIndex(x, y);
+    if (i >= 0) m_blockdata[i].setCollision(collision);
+}
+
+int ScriptWorkerApi::getElevation(int x, int y) {
+    const int i = blockIndex(x, y);
+    return (i >= 0) ? m_blockdata.at(i).elevation() : 0;
+}
+
+void ScriptWorkerApi::setElevation(int x, int y, int elevation) {
+    const int i = blockIndex(x, y);
+    if (i >= 0) m_blockdata[i].setElevation(elevation);
+}
+
+int ScriptWorkerApi::getBorderMetatileId(int x, int y) {
+    const int i = borderIndex(x, y);
+    return (i >= 0) ? m_border.at(i).metatileId() : 0;
+}
+
+void ScriptWorkerApi::setBorderMetatileId(int x, int y, int metatileId) {
+    const int i = borderIndex(x, y);
+    if (i >= 0) m_border[i].setMetatileId(metatileId);
+}
+
+QString ScriptWorkerApi::getPrimaryTileset() {
+    return m_layout.primaryTileset ? m_layout.primaryTileset->name : QString();
+}
+
+QString ScriptWorkerApi::getSecondaryTileset() {
+    return m_layout.secondaryTileset ? m_layout.secondaryTileset->name : QString();
+}
+
+int ScriptWorkerApi::getMetatileBehavior(int metatileId) {
+    const Metatile *metatile = getMetatile(metatileId);
+    return metatile ? metatile->behavior() : -1;
+}
+
+int ScriptWorkerApi::getMetatileLayerType(int metatileId) {
+    const Metatile *metatile = getMetatile(metatileId);
+    return metatile ? metatile->layerType() : -1;
+}
+
+int ScriptWorkerApi::getMetatileEncounterType(int metatileId) {
+    const Metatile *metatile = getMetatile(metatileId);
+    return metatile ? metatile->encounterType() : -1;
+}
+
+int ScriptWorkerApi::getMetatileTerrainType(int metatileId) {
+    const Metatile *metatile = getMetatile(metatileId);
+    return metatile ? metatile->terrainType() : -1;
+}
+
+void ScriptWorkerApi::setProgress(int value, int maximum, QString label) {
+    emit m_job->progressChanged(value, maximum, label);
+}
+
+bool ScriptWorkerApi::isCanceled() {
+    return m_job->wasCanceled();
+}
+
+// Logging is safe from any thread.
+void ScriptWorkerApi::log(QString message) {
+    logInfo(message);
+}
+
+void ScriptWorkerApi::warn(QString message) {
+    logWarn(message);
+}
+
+void ScriptWorkerApi::error(QString message) {
+    logError(message);
+}
+
+
+
+ScriptWorkerJob::ScriptWorkerJob(const Input &input, QObject *parent)
+    : QObject(parent),
+      m_input(input)
+{
+    // The job is owned by the ScriptWorker, not the thread pool.
+    setAutoDelete(false);
+}
+
+void ScriptWorkerJob::cancel() {
+    if (!m_canceled) {
+        m_canceled = true;
+        return;
+    }
+    QMutexLocker locker(&m_engineMutex);
+    m_interrupted = true;
+    if (m_engine) m_engine->setInterrupted(true);
+}
+
+QHash<int, Block> ScriptWorkerJob::getChanges(const Blockdata &oldBlocks, const Blockdata &newBlocks) {
+    QHash<int, Block> changes;
+    for (int i = 0; i < qMin(oldBlocks.length(), newBlocks.length()); i++) {
+        if (oldBlocks.at(i) != newBlocks.at(i))
+            changes.insert(i, newBlocks.at(i));
+    }
+    return changes;
+}
+
+// The script engine (and everything it creates) belongs to this thread, so it's created and destroyed here.
+// The script modules are loaded again for this engine. Their top-level code can only use the 'worker' and 'constants' objects.
+void ScriptWorkerJob::run() {
+    PERF_TRACE("ScriptWorkerJob::run", m_input.functionName);
+    QJSEngine engine;
+    engine.installExtensions(QJSEngine::ConsoleExtension);
+    {
+        QMutexLocker locker(&m_engineMutex);
+        m_engine = &engine;
+        if (m_interrupted) engine.setInterrupted(true);
+    }
+
+    ScriptWorkerApi api(&engine, m_input.layout, this);
+    QQmlEngine::setObjectOwnership(&api, QQmlEngine::CppOwnership);
+    engine.globalObject().setProperty("worker", engine.newQObject(&api));
+    Scripting::setConstants(&engine, m_input.constants);
+
+    bool foundFunction = false;
+    bool failed = false;
+    for (const auto &filepath : m_input.filepaths) {
+        QJSValue module = engine.importModule(filepath);
+        if (Scripting::tryErrorJS(module)) {
+            failed = true;
+            continue;
+        }
+        QJSValue function = module.property(m_input.functionName);
+        if (!function.isCallable())
+            continue;
+        foundFunction = true;
+        if (Scripting::tryErrorJS(function.call(QJSValueList())))
+            failed = true;
+    }
+    if (!foundFunction && !failed && !m_canceled)
+        logError(QString("Unknown custom script function '%1'").arg(m_input.functionName));
+
+    m_succeeded = foundFunction && !failed && !m_canceled;
+    if (m_succeeded) {
+        m_blockChanges = getChanges(m_input.layout.blockdata, api.blockdata());
+        m_borderChanges = getChanges(m_input.layout.border, api.border());
+    }
+
+    {
+        QMutexLocker locker(&m_engineMutex);
+        m_engine = nullptr;
+    }
+    emit finished();
+}
+
+
+
+ScriptWorker::ScriptWorker(MainWindow *mainWindow) : m_mainWindow(mainWindow) {
+    m_pool.setMaxThreadCount(1);
+
+    QStatusBar *statusBar = mainWindow ? mainWindow->statusBar() : nullptr;
+    if (!statusBar)
+        return;
+
+    m_progressBar = new QProgressBar(statusBar);
+    m_progressBar->setMaximumWidth(250);
+    m_progressBar->setVisible(false);
+
+    m_cancelButton = new QToolButton(statusBar);
+    m_cancelButton->setIcon(QIcon(QStringLiteral(":/icons/delete.ico")));
+    m_cancelButton->setToolTip(QStringLiteral("Cancel script action. Click again to stop it immediately."));
+    m_cancelButton->setAutoRaise(true);
+    m_cancelButton->setVisible(false);
+    connect(m_cancelButton, &QToolButton::clicked, this, [this] {
+        if (m_job) m_job->cancel();
+    });
+
+    statusBar->addPermanentWidget(m_progressBar);
+    statusBar->addPermanentWidget(m_cancelButton);
+}
+
+ScriptWorker::~ScriptWorker() {
+    // The job only reads from its own snapshot, but it still needs to finish before it's deleted.
+    if (m_job) {
+        m_job->cancel();
+        m_job->cancel();
+    }
+    m_pool.waitForDone();
+    delete m_progressBar;
+    delete m_cancelButton;
+}
+
+LayoutSnapshot ScriptWorker::captureLayout(const Layout *layout) {
+    LayoutSnapshot snapshot;
+    snapshot.width = layout->getWidth();
+    snapshot.height = layout->getHeight();
+    snapshot.borderWidth = layout->getBorderWidth();
+    snapshot.borderHeight = layout->getBorderHeight();
+    snapshot.blockdata = layout->blockdata;
+    snapshot.border = layout->border;
+    if (layout->tileset_primary)
+        snapshot.primaryTileset = std::make_shared<const Tileset>(*layout->tileset_primary);
+    if (layout->tileset_secondary)
+        snapshot.secondaryTileset = std::make_shared<const Tileset>(*layout->tileset_secondary);
+    return snapshot;
+}
+
+bool ScriptWorker::start(const QString &functionName, const QStringList &filepaths) {
+    if (m_job) {
+        logWarn(QString("Can't run '%1' until the script action '%2' has finished.").arg(functionName).arg(m_job->functionName()));
+        return false;
+    }
+    Layout *layout = (m_mainWindow && m_mainWindow->editor) ? m_mainWindow->editor->layout : nullptr;
+    if (!layout) {
+        logError(QString("Can't run '%1' without an open map or layout.").arg(functionName));
+        return false;
+    }
+
+    ScriptWorkerJob::Input input;
+    input.functionName = functionName;
+    for (const auto &filepath : filepaths) {
+        const QString validPath = Project::getExistingFilepath(filepath);
+        if (!validPath.isEmpty())
+            input.filepaths.append(validPath);
+    }
+    input.constants = Scripting::getConstants(m_mainWindow);
+    input.layout = captureLayout(layout);
+
+    m_layout = layout;
+    m_job = new ScriptWorkerJob(input, this);
+    connect(m_job, &ScriptWorkerJob::progressChanged, this, &ScriptWorker::updateProgress);
+    connect(m_job, &ScriptWorkerJob::finished, this, &ScriptWorker::onFinished);
+
+    // Until the script reports its progress, show a busy indicator.
+    updateProgress(0, 0, QString("Running %1...").arg(functionName));
+    m_pool.start(m_job);
+    return true;
+}
+
+void ScriptWorker::updateProgress(int value, int maximum, const QString &label) {
+    if (!m_job || !m_progressBar || !m_cancelButton)
+        return;
+    m_progressBar->setRange(0, qMax(0, maximum));
+    m_progressBar->setValue(value);
+    m_progressBar->setFormat(maximum > 0 ? QString("%1 %p%").arg(label) : label);
+    m_progressBar->setVisible(true);
+    m_cancelButton->setVisible(true);
+}
+
+void ScriptWorker::onFinished() {
+    ScriptWorkerJob *job = m_job;
+    m_job = nullptr;
+    if (m_progressBar) m_progressBar->setVisible(false);
+    if (m_cancelButton) m_cancelButton->setVisible(false);
+    if (!job)
+        return;
+
+    if (job->wasCanceled()) {
+        logInfo(QString("Canceled script action '%1'. Its changes were discarded.").arg(job->functionName()));
+    } else if (job->succeeded()) {
+        applyChanges(job);
+    }
+    job->deleteLater();
+}
+
+// The action's edits are applied on top of the layout's current blocks, so any edits made while the action
+// was running are kept (unless the action changed the same blocks). All the edits are a single undoable commit.
+void ScriptWorker::applyChanges(const ScriptWorkerJob *job) {
+    if (job->blockChanges().isEmpty() && job->borderChanges().isEmpty())
+        return;
+
+    Layout *layout = m_layout;
+    const LayoutSnapshot &snapshot = job->layout();
+    if (!layout || !m_mainWindow->editor || layout != m_mainWindow->editor->layout
+     || layout->getWidth() != snapshot.width || layout->getHeight() != snapshot.height
+     || layout->getBorderWidth() != snapshot.borderWidth || layout->getBorderHeight() != snapshot.borderHeight) {
+        logError(QString("The layout was closed or resized while the script action '%1' was running. Its changes were discarded.").arg(job->functionName()));
+        return;
+    }
+
+    Blockdata newBlockdata = layout->blockdata;
+    for (auto it = job->blockChanges().constBegin(); it != job->blockChanges().constEnd(); it++) {
+        if (it.key() < newBlockdata.length())
+            newBlockdata[it.key()] = it.value();
+    }
+    Blockdata newBorder = layout->border;
+    for (auto it = job->borderChanges().constBegin(); it != job->borderChanges().constEnd(); it++) {
+        if (it.key() < newBorder.length())
+            newBorder[it.key()] = it.value();
+    }
+
+    const QSize size(layout->getWidth(), layout->getHeight());
+    const QSize borderSize(layout->getBorderWidth(), layout->getBorderHeight());
+    layout->editHistory.push(new ScriptEditLayout(layout,
+        size, size,
+        layout->blockdata, newBlockdata,
+        borderSize, borderSize,
+        layout->border, newBorder
+    ));
+}
+
+#endif // QT_QML_LIB
@@ -0,0 +1,96 @@
+#include "collisionatlas.h"
+#include "editor.h"
+#include "metatile.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPainter>
+#include <cstring>
+
+// Dragging the opacity slider would otherwise keep an atlas for every value it passes through.
+static const int maxCachedAtlases = 4;
+
+static QMutex s_cacheMutex;
+static QHash<int, std::shared_ptr<const CollisionAtlas>> s_cache;
+
+std::shared_ptr<const CollisionAtlas> CollisionAtlas::get(qreal opacity) {
+    const int key = qBound(0, qRound(opacity * 100), 100);
+
+    QMutexLocker locker(&s_cacheMutex);
+    auto it = s_cache.constFind(key);
+    if (it != s_cache.constEnd())
+        return it.value();
+
+    if (s_cache.size() >= maxCachedAtlases)
+        s_cache.clear();
+    // The constructor is private, so std::make_shared can't be used here.
+    auto atlas = std::shared_ptr<const CollisionAtlas>(new CollisionAtlas(key));
+    s_cache.insert(key, atlas);
+    return atlas;
+}
+
+void CollisionAtlas::clearCache() {
+    QMutexLocker locker(&s_cacheMutex);
+    s_cache.clear();
+}
+
+CollisionAtlas::CollisionAtlas(int opacity) : m_opacity(opacity) {
+    const int w = Metatile::pixelWidth(), h = Metatile::pixelHeight();
+    m_numCollisions = Editor::collisionIcons.length();
+    for (const auto &sublist : Editor::collisionIcons)
+        m_numElevations = qMax(m_numElevations, sublist.length());
+
+    // Collision values are the columns, and elevations are the rows.
+    m_image = QImage(qMax(1, m_numCollisions) * w, qMax(1, m_numElevations) * h, QImage::Format_RGBA8888);
+    m_image.fill(Qt::transparent);
+
+    // Drawing each icon at the given opacity onto a transparent image leaves the icon's colors with its alpha scaled by the opacity,
+    // so copying a cell of the atlas over a block gives the same result as painting the icon at that opacity.
+    QPainter painter(&m_image);
+    painter.setOpacity(opacity / 100.0);
+    for (int collision = 0; collision < m_numCollisions; collision++) {
+        const auto &sublist = Editor::collisionIcons.at(collision);
+        for (int elevation = 0; elevation < sublist.length(); elevation++) {
+            const QImage *icon = sublist.at(elevation);
+            if (icon)
+                painter.drawImage(QRect(collision * w, elevation * h, w, h), *icon);
+        }
+    }
+}
+
+void CollisionAtlas::drawBlock(QImage *image, int x, int y, const Block &block) const {
+    const int w = Metatile::pixelWidth(), h = Metatile::pixelHeight();
+    const QRect target = QRect(x, y, w, h) & image->rect();
+    if (target.isEmpty())
+        return;
+
+    const int collision = block.collision();
+    const int elevation = block.elevation();
+    const bool hasIcon = collision < m_numCollisions && elevation < m_numElevations;
+
+    if (image->format() != m_image.format()) {
+        // Not expected, but QPainter can convert between formats for us.
+        QPainter painter(image);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        if (hasIcon) {
+            painter.drawImage(QPoint(x, y), m_image, QRect(collision * w, elevation * h, w, h));
+        } else {
+            painter.fillRect(target, Qt::transparent);
+        }
+        return;
+    }
+
+    // Copy the rows of the icon directly, which is much faster than painting it.
+    const int bytesPerPixel = m_image.depth() / 8;
+    const int sourceX = collision * w + (target.x() - x);
+    const int sourceY = elevation * h + (target.y() - y);
+    const size_t rowLength = static_cast<size_t>(target.width()) * bytesPerPixel;
+    for (int row = 0; row < target.height(); row++) {
+        uchar *dest = image->scanLine(target.y() + row) + target.x() * bytesPerPixel;
+        if (hasIcon) {
+            std::memcpy(dest, m_image.constScanLine(sourceY + row) + sourceX * bytesPerPixel, rowLength);
+        } else {
+            std::memset(dest, 0, rowLength);
+        }
+    }
+}
@@ -5,11 +5,15 @@
 void CollisionPixmapItem::draw(bool ignoreCache) {
     if (this->layout) {
         this->layout->setCollisionItem(this);
-        setPixmap(this->layout->renderCollision(ignoreCache));
-        setOpacity(*this->opacity);
+        imageChanged(this->layout->renderCollisionImage(ignoreCache, *this->opacity));
     }
 }
 
+const QImage &CollisionPixmapItem::image() const {
+    static const QImage emptyImage;
+    return this->layout ? this->layout->collision_image : emptyImage;
+}
+
 void CollisionPixmapItem::paint(QGraphicsSceneMouseEvent *event) {
     if (event->type() == QEvent::GraphicsSceneMouseRelease) {
         actionId_++;
@@ -6,11 +6,9 @@
 #include <math.h>
 
 ConnectionPixmapItem::ConnectionPixmapItem(MapConnection* connection)
-    : QGraphicsPixmapItem(connection->render()),
-      connection(connection)
+    : connection(connection)
 {
     this->setEditable(true);
-    this->basePixmap = pixmap();
     updateOrigin();
     render(false);
 
@@ -22,13 +20,14 @@ ConnectionPixmapItem::ConnectionPixmapItem(MapConnection* connection)
 
 void ConnectionPixmapItem::refresh() {
     updateOrigin();
-    render(true);
+    render();
 }
 
 // Render additional visual effects on top of the base map image.
+// The connected map's render is cached, so only blocks that changed since it was last rendered are redrawn.
+// 'ignoreCache' forces a full re-render, which is only necessary if the tilesets have changed.
 void ConnectionPixmapItem::render(bool ignoreCache) {
-    if (ignoreCache)
-        this->basePixmap = this->connection->render();
+    this->basePixmap = this->connection->render(ignoreCache);
 
     QPixmap pixmap = this->basePixmap.copy(0, 0, this->basePixmap.width(), this->basePixmap.height());
     this->setZValue(Editor::ZValue::MapConnectionActive);
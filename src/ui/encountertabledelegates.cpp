@@ -21,7 +21,7 @@ void SpeciesComboDelegate::paint(QPainter *painter, const QStyleOptionViewItem &
 QWidget *SpeciesComboDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &, const QModelIndex &) const {
     NoScrollComboBox *editor = new NoScrollComboBox(parent);
     editor->setFrame(false);
-    editor->addItems(this->project->speciesNames);
+    editor->setConstantsModel(this->project->getConstantsModel(Project::Constants::Species));
     return editor;
 }
 
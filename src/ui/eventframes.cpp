@@ -192,31 +192,29 @@ void EventFrame::populateDropdown(NoScrollComboBox * combo, const QStringList &i
     combo->setTextItem(savedText);
 }
 
+// Like above, but the combo box displays a model that may be shared with other combo boxes,
+// which is much faster than copying a long list of items into each of them.
+void EventFrame::populateDropdown(NoScrollComboBox * combo, ConstantsModel *model) {
+    combo->setConstantsModel(model);
+}
+
 void EventFrame::populateScriptDropdown(NoScrollComboBox * combo, Project * project) {
     // The script dropdown and autocomplete are populated with scripts used by the map's events and from its scripts file.
     Map *map = this->event ? this->event->getMap() : nullptr;
     if (!map)
         return;
 
-    QStringList scripts = map->getScriptLabels(this->event->getEventGroup());
-    populateDropdown(combo, scripts);
+    // The map's script labels are few enough to keep a list per frame.
+    auto mapScripts = combo->findChild<ConstantsModel *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!mapScripts) mapScripts = new ConstantsModel(combo);
+    mapScripts->setStrings(map->getScriptLabels(this->event->getEventGroup()));
 
     // Depending on the settings, the autocomplete may also contain scripts from outside the map.
+    QList<ConstantsModel *> searchModels = {mapScripts};
     if (project && porymapConfig.scriptAutocompleteMode != ScriptAutocompleteMode::MapOnly) {
-        project->insertGlobalScriptLabels(scripts);
+        searchModels.append(project->getConstantsModel(Project::Constants::GlobalScriptLabels));
     }
-
-    // Note: Because 'combo' is the parent, the old QCompleter will be deleted when a new one is set.
-    auto completer = new QCompleter(scripts, combo);
-    completer->setCaseSensitivity(Qt::CaseInsensitive);
-    completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
-    completer->setFilterMode(Qt::MatchContains);
-
-    // Improve display speed for the autocomplete popup
-    auto popup = (QListView *)completer->popup();
-    if (popup) popup->setUniformItemSizes(true);
-
-    combo->setCompleter(completer);
+    combo->setConstantsModel(mapScripts, searchModels);
 
     // If the script labels change then we need to update the EventFrame.
     if (project) connect(project, &Project::eventScriptLabelsRead, this, &EventFrame::invalidateValues, Qt::UniqueConnection);
@@ -227,7 +225,7 @@ void EventFrame::populateMapNameDropdown(NoScrollComboBox * combo, Project * pro
     if (!project)
         return;
 
-    populateDropdown(combo, project->mapNames());
+    populateDropdown(combo, project->getConstantsModel(Project::Constants::MapNames));
 
     // This frame type displays map names, so when a new map is created we need to repopulate it.
     connect(project, &Project::mapCreated, this, &EventFrame::invalidateValues, Qt::UniqueConnection);
@@ -456,10 +454,10 @@ void ObjectFrame::populate(Project *project) {
     const QSignalBlocker blocker(this);
     EventFrame::populate(project);
 
-    populateDropdown(this->combo_sprite, project->gfxDefines.keys());
-    populateDropdown(this->combo_movement, project->movementTypes);
-    populateDropdown(this->combo_flag, project->flagNames);
-    populateDropdown(this->combo_trainer_type, project->trainerTypes);
+    populateDropdown(this->combo_sprite, project->getConstantsModel(Project::Constants::Sprites));
+    populateDropdown(this->combo_movement, project->getConstantsModel(Project::Constants::MovementTypes));
+    populateDropdown(this->combo_flag, project->getConstantsModel(Project::Constants::Flags));
+    populateDropdown(this->combo_trainer_type, project->getConstantsModel(Project::Constants::TrainerTypes));
     populateScriptDropdown(this->combo_script, project);
 }
 
@@ -777,7 +775,7 @@ void TriggerFrame::populate(Project *project) {
     const QSignalBlocker blocker(this);
     EventFrame::populate(project);
 
-    populateDropdown(this->combo_var, project->varNames);
+    populateDropdown(this->combo_var, project->getConstantsModel(Project::Constants::Vars));
     populateScriptDropdown(this->combo_script, project);
 }
 
@@ -827,7 +825,7 @@ void WeatherTriggerFrame::populate(Project *project) {
     const QSignalBlocker blocker(this);
     EventFrame::populate(project);
 
-    populateDropdown(this->combo_weather, project->coordEventWeatherNames);
+    populateDropdown(this->combo_weather, project->getConstantsModel(Project::Constants::CoordEventWeathers));
 }
 
 
@@ -894,7 +892,7 @@ void SignFrame::populate(Project *project) {
     const QSignalBlocker blocker(this);
     EventFrame::populate(project);
 
-    populateDropdown(this->combo_facing_dir, project->bgEventFacingDirections);
+    populateDropdown(this->combo_facing_dir, project->getConstantsModel(Project::Constants::BgEventFacingDirections));
     populateScriptDropdown(this->combo_script, project);
 }
 
@@ -1010,8 +1008,8 @@ void HiddenItemFrame::populate(Project *project) {
     const QSignalBlocker blocker(this);
     EventFrame::populate(project);
 
-    populateDropdown(this->combo_item, project->itemNames);
-    populateDropdown(this->combo_flag, project->flagNames);
+    populateDropdown(this->combo_item, project->getConstantsModel(Project::Constants::Items));
+    populateDropdown(this->combo_flag, project->getConstantsModel(Project::Constants::Flags));
 }
 
 
@@ -1062,7 +1060,7 @@ void SecretBaseFrame::populate(Project *project) {
     const QSignalBlocker blocker(this);
     EventFrame::populate(project);
 
-    populateDropdown(this->combo_base_id, project->secretBaseIds);
+    populateDropdown(this->combo_base_id, project->getConstantsModel(Project::Constants::SecretBaseIds));
 }
 
 
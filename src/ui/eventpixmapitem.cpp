@@ -17,20 +17,31 @@ void EventPixmapItem::render(Project *project) {
     if (!m_event)
         return;
 
+    m_project = project;
     m_basePixmap = m_event->loadPixmap(project);
 
     // If the base pixmap changes, the event's pixel position may change.
     updatePixelPosition();
 
-    QPixmap pixmap = m_basePixmap;
+    // The pixmap is still needed for the item's size and shape, but sprites are painted from the project's atlas.
+    setPixmap(m_basePixmap);
+    update();
+    emit rendered(m_basePixmap);
+}
+
+void EventPixmapItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    EventSpriteAtlas::Sprite sprite;
+    if (m_project && m_event && m_project->getEventSprite(m_event->getSpriteKey(), &sprite, false)) {
+        painter->drawPixmap(offset(), *sprite.page, sprite.rect);
+    } else {
+        QGraphicsPixmapItem::paint(painter, option, widget);
+    }
+
     if (m_selected) {
         // Draw the selection rectangle
-        QPainter painter(&pixmap);
-        painter.setPen(Qt::magenta);
-        painter.drawRect(0, 0, pixmap.width() - 1, pixmap.height() - 1);
+        painter->setPen(Qt::magenta);
+        painter->drawRect(QRectF(offset(), QSizeF(m_basePixmap.width() - 1, m_basePixmap.height() - 1)));
     }
-    setPixmap(pixmap);
-    emit rendered(m_basePixmap);
 }
 
 void EventPixmapItem::move(int dx, int dy) {
@@ -17,9 +17,9 @@ void MapView::keyPressEvent(QKeyEvent *event) {
     }
 }
 
-void MapView::drawForeground(QPainter *painter, const QRectF&) {
+void MapView::drawForeground(QPainter *painter, const QRectF &rect) {
     for (auto i = this->overlayMap.constBegin(); i != this->overlayMap.constEnd(); i++) {
-        i.value()->renderItems(painter);
+        i.value()->renderItems(painter, rect);
     }
 
     if (!editor) return;
@@ -29,16 +29,13 @@ void MapView::drawForeground(QPainter *painter, const QRectF&) {
     // Draw elements of the map view that should always render on top of anything added by the user with the scripting API.
 
     // Draw map grid
-    if (editor->mapGrid && editor->mapGrid->isVisible()) {
+    if (editor->mapGrid && editor->mapGrid->isVisible() && editor->layout) {
         painter->save();
-        if (editor->layout) {
-            // We're clipping here to hide parts of the grid that are outside the map.
-            const QRectF mapRect(-0.5, -0.5, editor->layout->pixelWidth() + 1.5, editor->layout->pixelHeight() + 1.5);
-            painter->setClipping(true);
-            painter->setClipRect(mapRect);
-        }
-        for (auto item : editor->mapGrid->childItems())
-            item->paint(painter, &option, this);
+        // We're clipping here to hide parts of the grid that are outside the map.
+        const QRectF mapRect(-0.5, -0.5, editor->layout->pixelWidth() + 1.5, editor->layout->pixelHeight() + 1.5);
+        painter->setClipping(true);
+        painter->setClipRect(mapRect);
+        editor->mapGrid->paint(painter, rect, QSize(editor->layout->pixelWidth(), editor->layout->pixelHeight()));
         painter->restore();
     }
 
@@ -1,6 +1,7 @@
 #include "config.h"
 #include "imageproviders.h"
 #include "editor.h"
+#include "perftrace.h"
 #include <QPainter>
 
 QImage getCollisionMetatileImage(Block block) {
@@ -49,8 +50,47 @@ QImage getMetatileImage(
 
 // The color to use when we want to show some portion of the image request was invalid.
 // Normally this is Qt::magenta, but we'll use Qt::transparent if we think the image allows it.
+static QColor getInvalidImageColor(const QColor &transparencyColor) {
+    return (transparencyColor == QColor(Qt::transparent)) ? QColor(Qt::transparent) : QColor(Qt::magenta);
+}
+
 QColor getInvalidImageColor() {
-    return (projectConfig.transparencyColor == QColor(Qt::transparent)) ? QColor(Qt::transparent) : QColor(Qt::magenta);
+    return getInvalidImageColor(projectConfig.transparencyColor);
+}
+
+MetatileImageSettings MetatileImageSettings::fromProjectConfig() {
+    MetatileImageSettings settings;
+    settings.transparencyColor = projectConfig.transparencyColor;
+    settings.tripleLayerMetatilesEnabled = projectConfig.tripleLayerMetatilesEnabled;
+    settings.unusedTileNormal = projectConfig.unusedTileNormal;
+    settings.unusedTileCovered = projectConfig.unusedTileCovered;
+    settings.unusedTileSplit = projectConfig.unusedTileSplit;
+    return settings;
+}
+
+// Returns the color indices of the tile's pixels, or nullptr if neither tileset has the tile.
+static const uchar *getTilePixels(uint16_t tileId, const Tileset *primaryTileset, const Tileset *secondaryTileset) {
+    const Tileset *tileset = Tileset::getTileTileset(tileId, primaryTileset, secondaryTileset);
+    return tileset ? tileset->tilePixels(tileId) : nullptr;
+}
+
+// Draws 'color' with the given alpha over the RGBA8888 pixel at 'dest' (equivalent to QPainter's default composition mode).
+static inline void blendPixel(uchar *dest, QRgb color, int alpha) {
+    if (alpha == 255) {
+        dest[0] = qRed(color);
+        dest[1] = qGreen(color);
+        dest[2] = qBlue(color);
+        dest[3] = 255;
+        return;
+    }
+    if (alpha == 0)
+        return;
+    const int destAlpha = dest[3] * (255 - alpha) / 255;
+    const int outAlpha = alpha + destAlpha;
+    dest[0] = (qRed(color) * alpha + dest[0] * destAlpha) / outAlpha;
+    dest[1] = (qGreen(color) * alpha + dest[1] * destAlpha) / outAlpha;
+    dest[2] = (qBlue(color) * alpha + dest[2] * destAlpha) / outAlpha;
+    dest[3] = outAlpha;
 }
 
 QImage getMetatileImage(
@@ -61,9 +101,22 @@ QImage getMetatileImage(
         const QList<float> &layerOpacity,
         bool useTruePalettes)
 {
+    return getMetatileImage(metatile, primaryTileset, secondaryTileset, layerOrder, layerOpacity, useTruePalettes, MetatileImageSettings::fromProjectConfig());
+}
+
+QImage getMetatileImage(
+        const Metatile *metatile,
+        const Tileset *primaryTileset,
+        const Tileset *secondaryTileset,
+        const QList<int> &layerOrder,
+        const QList<float> &layerOpacity,
+        bool useTruePalettes,
+        const MetatileImageSettings &settings)
+{
+    PERF_TRACE("getMetatileImage");
     QImage metatileImage(Metatile::pixelSize(), QImage::Format_RGBA8888);
     if (!metatile) {
-        metatileImage.fill(getInvalidImageColor());
+        metatileImage.fill(getInvalidImageColor(settings.transparencyColor));
         return metatileImage;
     }
 
@@ -74,9 +127,10 @@ QImage getMetatileImage(
     // The GBA renders transparent pixels using palette 0 color 0. We have this color,
     // but all 3 games actually overwrite it with black when loading the tileset palettes,
     // so we have a setting to specify an override transparency color.
-    metatileImage.fill(projectConfig.transparencyColor.isValid() ? projectConfig.transparencyColor : QColor(palettes.value(0).value(0)));
+    metatileImage.fill(settings.transparencyColor.isValid() ? settings.transparencyColor : QColor(palettes.value(0).value(0)));
 
-    QPainter painter(&metatileImage);
+    const QRgb invalidColor = getInvalidImageColor(settings.transparencyColor).rgba();
+    const QRgb invalidPaletteColor = getInvalidImageColor(settings.transparencyColor).rgb();
 
     uint32_t layerType = metatile->layerType();
     for (const auto &layer : layerOrder)
@@ -85,7 +139,7 @@ QImage getMetatileImage(
         // Get the tile to render next
         Tile tile;
         int tileOffset = (y * Metatile::tileWidth()) + x;
-        if (projectConfig.tripleLayerMetatilesEnabled) {
+        if (settings.tripleLayerMetatilesEnabled) {
             tile = metatile->tiles.value(tileOffset + (layer * Metatile::tilesPerLayer()));
         } else {
             // "Vanilla" metatiles only have 8 tiles, but render 12.
@@ -95,48 +149,59 @@ QImage getMetatileImage(
             default:
             case Metatile::LayerType::Normal:
                 if (layer == 0)
-                    tile = Tile(projectConfig.unusedTileNormal);
+                    tile = Tile(settings.unusedTileNormal);
                 else // Tiles are on layers 1 and 2
                     tile = metatile->tiles.value(tileOffset + ((layer - 1) * Metatile::tilesPerLayer()));
                 break;
             case Metatile::LayerType::Covered:
                 if (layer == 2)
-                    tile = Tile(projectConfig.unusedTileCovered);
+                    tile = Tile(settings.unusedTileCovered);
                 else // Tiles are on layers 0 and 1
                     tile = metatile->tiles.value(tileOffset + (layer * Metatile::tilesPerLayer()));
                 break;
             case Metatile::LayerType::Split:
                 if (layer == 1)
-                    tile = Tile(projectConfig.unusedTileSplit);
+                    tile = Tile(settings.unusedTileSplit);
                 else // Tiles are on layers 0 and 2
                     tile = metatile->tiles.value(tileOffset + ((layer == 0 ? 0 : 1) * Metatile::tilesPerLayer()));
                 break;
             }
         }
 
-        QImage tileImage = getColoredTileImage(tile.tileId, primaryTileset, secondaryTileset, palettes.value(tile.palette));
-
-        float opacity = layerOpacity.value(layer, 1.0);
-        if (opacity < 1.0) {
-            int alpha = 255 * opacity;
-            for (int c = 0; c < tileImage.colorCount(); c++) {
-                QColor color(tileImage.color(c));
-                color.setAlpha(alpha);
-                tileImage.setColor(c, color.rgba());
+        const int alpha = qBound(0, static_cast<int>(255 * layerOpacity.value(layer, 1.0)), 255);
+        const uchar *tilePixels = getTilePixels(tile.tileId, primaryTileset, secondaryTileset);
+        if (!tilePixels) {
+            // Some tiles specify tile IDs that are outside the valid range.
+            // The way the GBA will render these depends on what's in memory (which Porymap can't know)
+            // so we render them using the invalid color.
+            for (int j = 0; j < Tile::pixelHeight(); j++) {
+                uchar *dest = metatileImage.scanLine(y * Tile::pixelHeight() + j) + x * Tile::pixelWidth() * 4;
+                for (int i = 0; i < Tile::pixelWidth(); i++, dest += 4) {
+                    blendPixel(dest, invalidColor, qAlpha(invalidColor));
+                }
             }
+            continue;
         }
 
-        // Color 0 is displayed as transparent.
-        if (tileImage.colorCount()) {
-            QColor color(tileImage.color(0));
-            color.setAlpha(0);
-            tileImage.setColor(0, color.rgba());
+        // Look up each pixel's color straight from the tile's color indices, rather than creating an image of the tile to draw.
+        const QList<QRgb> palette = palettes.value(tile.palette);
+        QRgb colors[Tileset::numColorsPerPalette()];
+        for (int i = 0; i < Tileset::numColorsPerPalette(); i++) {
+            colors[i] = palette.value(i, invalidPaletteColor);
+        }
+        for (int j = 0; j < Tile::pixelHeight(); j++) {
+            const uchar *src = tilePixels + (tile.yflip ? Tile::pixelHeight() - 1 - j : j) * Tile::pixelWidth();
+            uchar *dest = metatileImage.scanLine(y * Tile::pixelHeight() + j) + x * Tile::pixelWidth() * 4;
+            for (int i = 0; i < Tile::pixelWidth(); i++, dest += 4) {
+                const uchar colorId = src[tile.xflip ? Tile::pixelWidth() - 1 - i : i];
+                // Color 0 is displayed as transparent.
+                if (colorId == 0 || colorId >= Tileset::numColorsPerPalette())
+                    continue;
+                const QRgb color = colors[colorId];
+                blendPixel(dest, color, alpha < 255 ? alpha : qAlpha(color));
+            }
         }
-
-        tile.flip(&tileImage);
-        painter.drawImage(x * Tile::pixelWidth(), y * Tile::pixelHeight(), tileImage);
     }
-    painter.end();
 
     return metatileImage;
 }
@@ -147,17 +212,24 @@ QImage getTileImage(uint16_t tileId, const Tileset *primaryTileset, const Tilese
 }
 
 QImage getColoredTileImage(uint16_t tileId, const Tileset *primaryTileset, const Tileset *secondaryTileset, const QList<QRgb> &palette) {
-    QImage tileImage = getTileImage(tileId, primaryTileset, secondaryTileset);
-    if (tileImage.isNull()) {
+    const uchar *tilePixels = getTilePixels(tileId, primaryTileset, secondaryTileset);
+    if (!tilePixels) {
         // Some tiles specify tile IDs or palette IDs that are outside the valid range.
         // The way the GBA will render these depends on what's in memory (which Porymap can't know)
         // so we render them using the invalid color
-        tileImage = QImage(Tile::pixelSize(), QImage::Format_RGBA8888);
+        QImage tileImage(Tile::pixelSize(), QImage::Format_RGBA8888);
         tileImage.fill(getInvalidImageColor());
-    } else {
-        for (int i = 0; i < Tileset::numColorsPerPalette(); i++) {
-            tileImage.setColor(i, palette.value(i, getInvalidImageColor().rgb()));
-        }
+        return tileImage;
+    }
+
+    QImage tileImage(Tile::pixelSize(), QImage::Format_Indexed8);
+    QVector<QRgb> colorTable(Tileset::numColorsPerPalette());
+    for (int i = 0; i < colorTable.length(); i++) {
+        colorTable[i] = palette.value(i, getInvalidImageColor().rgb());
+    }
+    tileImage.setColorTable(colorTable);
+    for (int y = 0; y < Tile::pixelHeight(); y++, tilePixels += Tile::pixelWidth()) {
+        memcpy(tileImage.scanLine(y), tilePixels, Tile::pixelWidth());
     }
     return tileImage;
 }
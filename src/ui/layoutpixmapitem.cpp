@@ -5,6 +5,9 @@
 
 #include "editcommands.h"
 
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
 #define SWAP(a, b) do { if (a != b) { a ^= b; b ^= a; a ^= b; } } while (0)
 
 void LayoutPixmapItem::paint(QGraphicsSceneMouseEvent *event) {
@@ -690,10 +693,52 @@ void LayoutPixmapItem::select(QGraphicsSceneMouseEvent *event) {
 void LayoutPixmapItem::draw(bool ignoreCache) {
     if (this->layout) {
         layout->setLayoutItem(this);
-        setPixmap(this->layout->render(ignoreCache));
+        // Blocks are only drawn once the area they're in is painted (see renderImageArea).
+        imageChanged(this->layout->invalidateImage(ignoreCache));
+    }
+}
+
+void LayoutPixmapItem::renderImageArea(const QRect &rect) {
+    if (this->layout)
+        this->layout->renderPendingImageBlocks(rect);
+}
+
+const QImage &LayoutPixmapItem::image() const {
+    static const QImage emptyImage;
+    return this->layout ? this->layout->image : emptyImage;
+}
+
+void LayoutPixmapItem::imageChanged(const QRect &changedRect) {
+    const QSize size = image().size();
+    if (size != this->imageSize) {
+        prepareGeometryChange();
+        this->imageSize = size;
+        this->chunkCache.clear();
+        update();
+    } else if (changedRect.isValid()) {
+        this->chunkCache.invalidate(changedRect);
+        update(changedRect);
     }
 }
 
+QRectF LayoutPixmapItem::boundingRect() const {
+    return QRectF(QPointF(0, 0), this->imageSize);
+}
+
+QPainterPath LayoutPixmapItem::shape() const {
+    QPainterPath path;
+    path.addRect(boundingRect());
+    return path;
+}
+
+bool LayoutPixmapItem::contains(const QPointF &point) const {
+    return boundingRect().contains(point);
+}
+
+void LayoutPixmapItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *) {
+    this->chunkCache.paint(painter, image(), option->exposedRect, [this](const QRect &rect) { renderImageArea(rect); });
+}
+
 void LayoutPixmapItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event) {
     QPoint pos = Metatile::coordFromPixmapCoord(event->pos());
     if (pos != this->metatilePos) {
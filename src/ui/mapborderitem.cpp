@@ -0,0 +1,55 @@
+#include "mapborderitem.h"
+#include "maplayout.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+MapBorderItem::MapBorderItem(Layout *layout) : m_layout(layout) {
+    // Needed so that only the exposed part of the border is painted.
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    draw(true);
+}
+
+void MapBorderItem::draw(bool ignoreCache) {
+    if (!m_layout)
+        return;
+
+    m_pixmap = m_layout->renderBorder(ignoreCache);
+
+    // The border is repeated starting from the top-left edge of the view distance,
+    // so the last row/column of repetitions may extend past the other edges.
+    const QMargins margins = m_layout->getBorderMargins();
+    const int borderWidth = qMax(m_layout->getBorderWidth(), 1);
+    const int borderHeight = qMax(m_layout->getBorderHeight(), 1);
+    const int numColumns = (margins.left() + m_layout->getWidth() + margins.right() + borderWidth - 1) / borderWidth;
+    const int numRows = (margins.top() + m_layout->getHeight() + margins.bottom() + borderHeight - 1) / borderHeight;
+    const QRect rect(-margins.left() * Metatile::pixelWidth(),
+                     -margins.top() * Metatile::pixelHeight(),
+                     numColumns * borderWidth * Metatile::pixelWidth(),
+                     numRows * borderHeight * Metatile::pixelHeight());
+    if (rect != m_rect) {
+        prepareGeometryChange();
+        m_rect = rect;
+    }
+    m_layoutRect = QRect(0, 0, m_layout->pixelWidth(), m_layout->pixelHeight());
+    update();
+}
+
+QRectF MapBorderItem::boundingRect() const {
+    return m_rect;
+}
+
+void MapBorderItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *) {
+    if (m_pixmap.isNull())
+        return;
+
+    // The layout is drawn on top of the border, so we don't need to paint the part of the border underneath it.
+    QRegion region(option->exposedRect.toAlignedRect() & m_rect);
+    region -= m_layoutRect;
+    for (const QRect &rect : region) {
+        // Offset the pattern so that it lines up with the top-left corner of the border.
+        const QPoint offset((rect.x() - m_rect.x()) % m_pixmap.width(),
+                            (rect.y() - m_rect.y()) % m_pixmap.height());
+        painter->drawTiledPixmap(rect, m_pixmap, offset);
+    }
+}
@@ -0,0 +1,62 @@
+#include "mapgrid.h"
+
+#include <QtMath>
+
+MapGrid::MapGrid(const GridSettings &settings) {
+    setSettings(settings);
+}
+
+void MapGrid::setSettings(const GridSettings &settings) {
+    m_settings = settings;
+
+    // The dash patterns only depend on the settings, so the pens are created once here rather than every time the grid is painted.
+    m_verticalPen = QPen(m_settings.color);
+    m_verticalPen.setDashPattern(m_settings.getVerticalDashPattern());
+    m_horizontalPen = QPen(m_settings.color);
+    m_horizontalPen.setDashPattern(m_settings.getHorizontalDashPattern());
+}
+
+// Paints the lines of the grid that are inside 'rect'.
+void MapGrid::paint(QPainter *painter, const QRectF &rect, const QSize &mapPixelSize) const {
+    const int cellWidth = static_cast<int>(m_settings.width);
+    const int cellHeight = static_cast<int>(m_settings.height);
+    if (!m_visible || cellWidth <= 0 || cellHeight <= 0)
+        return;
+
+    // The grid can be moved with a user-specified x/y offset. The grid's dash patterns will only wrap in full pattern increments,
+    // so the grid starts an additional row/column outside the map that can be revealed as the offset changes.
+    const int originX = (m_settings.offsetX % cellWidth) - cellWidth;
+    const int originY = (m_settings.offsetY % cellHeight) - cellHeight;
+
+    // Lines are 1 pixel wide, so lines just outside the area can still be partly inside it.
+    const QRectF area = rect.adjusted(-1, -1, 1, 1) & QRectF(QPointF(originX, originY), QPointF(mapPixelSize.width(), mapPixelSize.height()));
+    if (area.isEmpty())
+        return;
+
+    // Each line's dash pattern is one cell long and begins at the grid's origin, so lines begin at the
+    // nearest cell boundary before the area (rather than at the edge of the area) to keep their dashes in place.
+    const int firstColumn = qCeil((area.left() - originX) / cellWidth);
+    const int lastColumn = qFloor((area.right() - originX) / cellWidth);
+    const int firstRow = qCeil((area.top() - originY) / cellHeight);
+    const int lastRow = qFloor((area.bottom() - originY) / cellHeight);
+    const qreal startX = originX + qFloor((area.left() - originX) / cellWidth) * cellWidth;
+    const qreal startY = originY + qFloor((area.top() - originY) / cellHeight) * cellHeight;
+
+    QVector<QLineF> lines;
+    lines.reserve(qMax(0, lastColumn - firstColumn + 1));
+    for (int i = firstColumn; i <= lastColumn; i++) {
+        const qreal x = originX + i * cellWidth;
+        lines.append(QLineF(x, startY, x, area.bottom()));
+    }
+    painter->setPen(m_verticalPen);
+    painter->drawLines(lines);
+
+    lines.clear();
+    lines.reserve(qMax(0, lastRow - firstRow + 1));
+    for (int i = firstRow; i <= lastRow; i++) {
+        const qreal y = originY + i * cellHeight;
+        lines.append(QLineF(startX, y, area.right(), y));
+    }
+    painter->setPen(m_horizontalPen);
+    painter->drawLines(lines);
+}
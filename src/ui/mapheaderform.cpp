@@ -48,26 +48,11 @@ void MapHeaderForm::setProject(Project * project, bool allowChanges) {
         return;
 
     // Populate combo boxes
-
-    const QSignalBlocker b_Song(ui->comboBox_Song);
-    ui->comboBox_Song->clear();
-    ui->comboBox_Song->addItems(m_project->songNames);
-
-    const QSignalBlocker b_Weather(ui->comboBox_Weather);
-    ui->comboBox_Weather->clear();
-    ui->comboBox_Weather->addItems(m_project->weatherNames);
-
-    const QSignalBlocker b_Type(ui->comboBox_Type);
-    ui->comboBox_Type->clear();
-    ui->comboBox_Type->addItems(m_project->mapTypes);
-
-    const QSignalBlocker b_BattleScene(ui->comboBox_BattleScene);
-    ui->comboBox_BattleScene->clear();
-    ui->comboBox_BattleScene->addItems(m_project->mapBattleScenes);
-
-    const QSignalBlocker b_Locations(ui->comboBox_Location);
-    ui->comboBox_Location->clear();
-    ui->comboBox_Location->addItems(m_project->locationNames());
+    ui->comboBox_Song->setConstantsModel(m_project->getConstantsModel(Project::Constants::Songs));
+    ui->comboBox_Weather->setConstantsModel(m_project->getConstantsModel(Project::Constants::Weathers));
+    ui->comboBox_Type->setConstantsModel(m_project->getConstantsModel(Project::Constants::MapTypes));
+    ui->comboBox_BattleScene->setConstantsModel(m_project->getConstantsModel(Project::Constants::BattleScenes));
+    ui->comboBox_Location->setConstantsModel(m_project->getConstantsModel(Project::Constants::Locations));
 
     // Hide config-specific settings
 
@@ -84,18 +69,9 @@ void MapHeaderForm::setProject(Project * project, bool allowChanges) {
     ui->label_FloorNumber->setVisible(floorNumEnabled);
 
     // If the project changes any of the displayed data, update it accordingly.
-    connect(m_project, &Project::mapSectionIdNamesChanged, this, &MapHeaderForm::setLocations);
     connect(m_project, &Project::mapSectionDisplayNameChanged, this, &MapHeaderForm::updateLocationName);
 }
 
-void MapHeaderForm::setLocations(const QStringList &locations) {
-    const QSignalBlocker b(ui->comboBox_Location);
-    const QString before = ui->comboBox_Location->currentText();
-    ui->comboBox_Location->clear();
-    ui->comboBox_Location->addItems(locations);
-    ui->comboBox_Location->setTextItem(before);
-}
-
 // Assign a MapHeader that the form will keep in sync with the UI.
 void MapHeaderForm::setHeader(MapHeader *header) {
     if (m_header == header)
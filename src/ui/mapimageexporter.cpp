@@ -1,11 +1,9 @@
 #include "mapimageexporter.h"
 #include "ui_mapimageexporter.h"
-#include "qgifimage.h"
 #include "editcommands.h"
 #include "filedialog.h"
 
 #include <QImage>
-#include <QPainter>
 #include <QPoint>
 
 QString MapImageExporter::getTitle(ImageExporterMode mode) {
@@ -34,10 +32,11 @@ QString MapImageExporter::getDescription(ImageExporterMode mode) {
     return "";
 }
 
-MapImageExporter::MapImageExporter(QWidget *parent, Project *project, Map *map, Layout *layout, ImageExporterMode mode) :
+MapImageExporter::MapImageExporter(QWidget *parent, Project *project, MapImageExportQueue *exportQueue, Map *map, Layout *layout, ImageExporterMode mode) :
     QDialog(parent),
     ui(new Ui::MapImageExporter),
     m_project(project),
+    m_exportQueue(exportQueue),
     m_map(map),
     m_layout(layout),
     m_mode(mode),
@@ -49,9 +48,13 @@ MapImageExporter::MapImageExporter(QWidget *parent, Project *project, Map *map,
     m_scene = new CheckeredBgScene(QSize(8,8), this);
     m_preview = m_scene->addPixmap(QPixmap());
     ui->graphicsView_Preview->setScene(m_scene);
+    ui->progressBar_Preview->setVisible(false);
 
     setModeSpecificUi();
 
+    connect(m_exportQueue, &MapImageExportQueue::jobProgressChanged, this, &MapImageExporter::onPreviewJobProgressChanged);
+    connect(m_exportQueue, &MapImageExportQueue::jobFinished, this, &MapImageExporter::onPreviewJobFinished);
+
     connect(ui->pushButton_Save,   &QPushButton::pressed, this, &MapImageExporter::saveImage);
     connect(ui->pushButton_Cancel, &QPushButton::pressed, this, &MapImageExporter::close);
 
@@ -78,7 +81,12 @@ MapImageExporter::MapImageExporter(QWidget *parent, Project *project, Map *map,
 }
 
 MapImageExporter::~MapImageExporter() {
-    delete m_timelapseGifImage;
+    if (m_previewJob) {
+        // Nothing else needs this job's result.
+        auto job = m_previewJob;
+        m_previewJob = nullptr;
+        m_exportQueue->cancel(job);
+    }
     delete ui;
 }
 
@@ -183,18 +191,6 @@ void MapImageExporter::updateMapSelection() {
 }
 
 void MapImageExporter::saveImage() {
-    // If the preview is empty (because progress was canceled) or if updates were disabled
-    // then we should ensure the image in the preview is up-to-date before exporting.
-    if (m_previewImage.isNull() || m_settings.disablePreviewUpdates) {
-        updatePreview(true);
-        if (m_previewImage.isNull())
-            return; // Canceled
-    }
-    if (m_mode == ImageExporterMode::Timelapse && !m_timelapseGifImage) {
-        // Shouldn't happen. We have a preview for the timelapse, but no timelapse image.
-        return;
-    }
-
     const QString itemName = m_map ? m_map->name() : m_layout->name;
     QString defaultFilename;
     switch (m_mode)
@@ -216,19 +212,32 @@ void MapImageExporter::saveImage() {
             .arg(m_mode == ImageExporterMode::Timelapse ? "gif" : "png");
     QString filter = m_mode == ImageExporterMode::Timelapse ? "Image Files (*.gif)" : "Image Files (*.png *.jpg *.bmp)";
     QString filepath = FileDialog::getSaveFileName(this, windowTitle(), defaultFilepath, filter);
-    if (!filepath.isEmpty()) {
-        switch (m_mode) {
-            case ImageExporterMode::Normal:
-            case ImageExporterMode::Stitch:
-                // Normal and Stitch modes already have the image ready to go in the preview.
-                m_previewImage.save(filepath);
-                break;
-            case ImageExporterMode::Timelapse:
-                m_timelapseGifImage->save(filepath);
-                break;
+    if (filepath.isEmpty())
+        return;
+
+    if (m_previewIsCurrent) {
+        // The preview already has the finished image, we only need to write it.
+        bool success;
+        if (m_mode == ImageExporterMode::Timelapse) {
+            QFile file(filepath);
+            success = file.open(QIODevice::WriteOnly) && file.write(m_timelapseGif) == m_timelapseGif.size();
+        } else {
+            success = m_previewImage.save(filepath);
+        }
+        if (success) {
+            logInfo(QString("Exported image to '%1'").arg(filepath));
+        } else {
+            logError(QString("Failed to write '%1'").arg(filepath));
         }
-        close();
+    } else {
+        // The preview is out-of-date (or was never created). Render the image in the background,
+        // the user doesn't need to wait for it to finish.
+        QList<MapImageFrame> frames;
+        if (!captureFrames(&frames))
+            return; // Canceled
+        m_exportQueue->enqueue(new MapImageExportJob(m_mode, m_settings, frames, filepath));
     }
+    close();
 }
 
 bool MapImageExporter::currentHistoryAppliesToFrame(QUndoStack *historyStack) {
@@ -285,28 +294,15 @@ bool MapImageExporter::currentHistoryAppliesToFrame(QUndoStack *historyStack) {
     }
 }
 
-QImage MapImageExporter::getExpandedImage(const QImage &image, const QSize &targetSize, const QColor &fillColor) {
-    if (image.width() >= targetSize.width() && image.height() >= targetSize.height())
-        return image;
-
-    QImage resizedImage(targetSize, QImage::Format_RGBA8888);
-    QPainter painter(&resizedImage);
-    resizedImage.fill(fillColor);
-
-    // Center the old image in the new resized one.
-    int x = (targetSize.width() - image.width()) / 2;
-    int y = (targetSize.height() - image.height()) / 2;
-    painter.drawImage(x, y, image);
-    return resizedImage;
-}
-
 struct TimelapseStep {
     QUndoStack* historyStack;
     int initialStackIndex;
     QString name;
 };
 
-QGifImage* MapImageExporter::createTimelapseGifImage(QProgressDialog *progress) {
+// Record a frame for each relevant step in the edit history. The edit history can only be walked on the main thread,
+// so this is done up front; the frames are rendered later by an export job.
+bool MapImageExporter::captureTimelapseFrames(QList<MapImageFrame> *frames, QProgressDialog *progress) {
     // TODO: Timelapse will play in order of layout changes then map changes (events, connections). Potentially update in the future?
     QList<TimelapseStep> steps;
     steps.append({
@@ -322,39 +318,26 @@ QGifImage* MapImageExporter::createTimelapseGifImage(QProgressDialog *progress)
         });
     }
 
-    // Rewind the edit histories and get the maximum map size for the gif's canvas.
-    QSize canvasSize = QSize(0,0);
+    // Rewind the edit histories.
     for (const auto &step : steps) {
         progress->setLabelText(QString("Rewinding %1 edit history...").arg(step.name));
         progress->setMinimum(0);
         progress->setMaximum(step.initialStackIndex);
         progress->setValue(progress->minimum());
-        do {
-            if (currentHistoryAppliesToFrame(step.historyStack) || step.historyStack->index() == step.initialStackIndex) {
-                // Either this is relevant edit history, or it's the final frame (which is always rendered). Record the size of the map at this point.
-                QMargins margins = getMargins(m_map);
-                canvasSize = canvasSize.expandedTo(QSize(m_layout->pixelWidth() + margins.left() + margins.right(),
-                                                         m_layout->pixelHeight() + margins.top() + margins.bottom()));
-            }
-            if (step.historyStack->canUndo()){
-                step.historyStack->undo();
-            } else break;
+        while (step.historyStack->canUndo() && !progress->wasCanceled()) {
+            step.historyStack->undo();
             progress->setValue(step.initialStackIndex - step.historyStack->index());
-        } while (!progress->wasCanceled());
+        }
     }
 
-    auto timelapseImg = new QGifImage(canvasSize);
-    timelapseImg->setDefaultDelay(m_settings.timelapseDelayMs);
-    timelapseImg->setDefaultTransparentColor(m_settings.fillColor);
-
-    // Create the timelapse image frames
+    // Capture the timelapse frames
     for (const auto &step : steps) {
         if (step.historyStack->index() >= step.initialStackIndex)
             continue;
 
         // Progress is represented by the number of commands we need to redo to finish the timelapse,
         // which can be different than the number of image frames we need to create.
-        progress->setLabelText(QString("Building %1 timelapse...").arg(step.name));
+        progress->setLabelText(QString("Capturing %1 timelapse...").arg(step.name));
         progress->setMinimum(step.historyStack->index());
         progress->setMaximum(step.initialStackIndex - step.historyStack->index());
         progress->setValue(progress->minimum());
@@ -362,8 +345,7 @@ QGifImage* MapImageExporter::createTimelapseGifImage(QProgressDialog *progress)
         int framesToSkip = m_settings.timelapseSkipAmount - 1;
         while (step.historyStack->canRedo() && step.historyStack->index() < step.initialStackIndex && !progress->wasCanceled()) {
             if (currentHistoryAppliesToFrame(step.historyStack) && --framesToSkip <= 0) {
-                // Render frame, increasing its size if necessary to match the canvas.
-                timelapseImg->addFrame(getExpandedImage(getFormattedMapImage(), canvasSize, m_settings.fillColor));
+                frames->append(captureFrame(m_map, m_layout));
                 framesToSkip = m_settings.timelapseSkipAmount - 1;
             }
             step.historyStack->redo();
@@ -375,10 +357,7 @@ QGifImage* MapImageExporter::createTimelapseGifImage(QProgressDialog *progress)
     // We already make sure above that we don't overshoot the initial state,
     // so this should only need to happen if progress was canceled.
     // Restoring the edit history is required, so we will disable canceling from here on.
-    if (progress->wasCanceled()) {
-        delete timelapseImg;
-        timelapseImg = nullptr;
-    }
+    const bool canceled = progress->wasCanceled();
     progress->setCancelButton(nullptr);
     for (const auto &step : steps) {
         if (step.historyStack->index() >= step.initialStackIndex)
@@ -392,12 +371,12 @@ QGifImage* MapImageExporter::createTimelapseGifImage(QProgressDialog *progress)
             progress->setValue(step.historyStack->index());
         }
     }
+    if (canceled)
+        return false;
 
     // Final frame should always be the current state of the map.
-    if (timelapseImg) {
-        timelapseImg->addFrame(getExpandedImage(getFormattedMapImage(), canvasSize, m_settings.fillColor));
-    }
-    return timelapseImg;
+    frames->append(captureFrame(m_map, m_layout));
+    return true;
 }
 
 struct StitchedMap {
@@ -406,27 +385,20 @@ struct StitchedMap {
     Map* map;
 };
 
-QImage MapImageExporter::getStitchedImage(QProgressDialog *progress) {
+QList<MapImageFrame> MapImageExporter::captureStitchedFrames() {
     // Do a breadth-first search to gather a collection of
     // all reachable maps with their relative offsets.
     QSet<QString> visited;
-    QList<StitchedMap> stitchedMaps;
+    QList<MapImageFrame> frames;
     QList<StitchedMap> unvisited;
     unvisited.append(StitchedMap{0, 0, m_map});
 
-    progress->setLabelText("Gathering stitched maps...");
     while (!unvisited.isEmpty()) {
-        if (progress->wasCanceled()) {
-            return QImage();
-        }
-        progress->setMaximum(visited.size() + unvisited.size());
-        progress->setValue(visited.size());
-
         StitchedMap cur = unvisited.takeFirst();
         if (visited.contains(cur.map->name()))
             continue;
         visited.insert(cur.map->name());
-        stitchedMaps.append(cur);
+        frames.append(captureFrame(cur.map, cur.map->layout(), QPoint(cur.x, cur.y)));
 
         for (const auto &connection : cur.map->getConnections()) {
             if (!connection->isCardinal()) continue;
@@ -436,131 +408,184 @@ QImage MapImageExporter::getStitchedImage(QProgressDialog *progress) {
             unvisited.append(StitchedMap{cur.x + pos.x(), cur.y + pos.y(), connectedMap});
         }
     }
-    if (stitchedMaps.isEmpty())
-        return QImage();
-
-    progress->setMaximum(stitchedMaps.size());
-    int numDrawn = 0;
+    return frames;
+}
 
-    // Determine the overall dimensions of the stitched maps.
-    QRect dimensions = QRect(0, 0, m_map->getWidth(), m_map->getHeight()) + getMargins(m_map);
-    for (const StitchedMap &map : stitchedMaps) {
-        dimensions |= (QRect(map.x, map.y, map.map->pixelWidth(), map.map->pixelHeight()) + getMargins(map.map));
-    }
+bool MapImageExporter::captureFrames(QList<MapImageFrame> *frames) {
+    if (!m_layout)
+        return false;
 
-    QImage stitchedImage(dimensions.width(), dimensions.height(), QImage::Format_RGBA8888);
-    stitchedImage.fill(m_settings.fillColor);
+    m_tilesetSnapshots.clear();
+    bool success = true;
+    if (m_mode == ImageExporterMode::Normal) {
+        frames->append(captureFrame(m_map, m_layout));
+    } else if (m_mode == ImageExporterMode::Stitch) {
+        *frames = captureStitchedFrames();
+    } else if (m_mode == ImageExporterMode::Timelapse) {
+        QProgressDialog progress("", "Cancel", 0, 1, this);
+        progress.setAutoClose(true);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setModal(true);
+        progress.setMinimumDuration(1000);
+        success = captureTimelapseFrames(frames, &progress);
+        progress.close();
+    }
+    // Each frame holds a reference to the tileset snapshots it needs, we don't need to keep them here.
+    m_tilesetSnapshots.clear();
+    return success && !frames->isEmpty();
+}
+
+MapImageFrame MapImageExporter::captureFrame(Map *map, Layout *layout, const QPoint &offset) {
+    MapImageFrame frame;
+    frame.offset = offset;
+    frame.margins = getMargins(map);
+    frame.layout = captureLayout(layout);
+    if (map) {
+        // Stitched images draw the connected maps themselves, so renderStitchedFrames never paints connections.
+        // Rendering them would be wasted work for every map in the stitch.
+        if (m_mode != ImageExporterMode::Stitch)
+            frame.connections = captureConnections(map);
+        frame.events = captureEvents(map);
+    }
+    return frame;
+}
+
+LayoutSnapshot MapImageExporter::captureLayout(Layout *layout) {
+    LayoutSnapshot snapshot;
+    snapshot.width = layout->getWidth();
+    snapshot.height = layout->getHeight();
+    snapshot.borderWidth = layout->getBorderWidth();
+    snapshot.borderHeight = layout->getBorderHeight();
+    snapshot.borderMargins = layout->getBorderMargins();
+    snapshot.visibleRect = layout->getVisibleRect();
+    snapshot.blockdata = layout->blockdata;
+    snapshot.border = layout->border;
+    snapshot.primaryTileset = captureTileset(layout->tileset_primary);
+    snapshot.secondaryTileset = captureTileset(layout->tileset_secondary);
+    snapshot.layerOrder = layout->metatileLayerOrder();
+    snapshot.layerOpacity = layout->metatileLayerOpacity();
+    return snapshot;
+}
+
+std::shared_ptr<const Tileset> MapImageExporter::captureTileset(const Tileset *tileset) {
+    if (!tileset)
+        return nullptr;
+
+    auto it = m_tilesetSnapshots.constFind(tileset);
+    if (it != m_tilesetSnapshots.constEnd())
+        return it.value();
+
+    auto snapshot = std::make_shared<const Tileset>(*tileset);
+    m_tilesetSnapshots.insert(tileset, snapshot);
+    return snapshot;
+}
+
+QList<DecorationSnapshot> MapImageExporter::captureConnections(const Map *map) {
+    QList<DecorationSnapshot> decorations;
+    if (!connectionsEnabled())
+        return decorations;
 
-    QPainter painter(&stitchedImage);
-    painter.translate(-dimensions.left(), -dimensions.top());
+    for (const auto &connection : map->getConnections()) {
+        if (!m_settings.showConnections.contains(connection->direction()))
+            continue;
+        decorations.append({
+            .pos = connection->relativePixelPos(true),
+            .image = connection->renderImage(),
+        });
+    }
+    return decorations;
+}
 
-    // Borders can occlude neighboring maps, so we draw all the borders before drawing any maps.
-    // Note: Borders can also overlap the borders of neighboring maps. It's not technically wrong to do this,
-    //       but it might suggest to users that something is visible in-game that actually isn't.
-    //       (e.g. in FRLG, Route 18's water border can overlap Fuchsia's tree border. It suggests you could
-    //        see a jarring transition in-game from one of these maps, but because of the collision map the
-    //        player isn't actually able to get close enough to this transition to see it).
-    //       Perhaps some future export setting could limit the border rendering to the visibility range from walkable areas.
-    if (m_settings.showBorder) {
-        progress->setLabelText("Drawing borders...");
-        progress->setValue(0);
-        numDrawn = 0;
-        for (const StitchedMap &map : stitchedMaps) {
-            if (progress->wasCanceled()) {
-                return QImage();
-            }
-            painter.translate(map.x, map.y);
-            paintBorder(&painter, map.map->layout());
-            painter.translate(-map.x, -map.y);
+QList<DecorationSnapshot> MapImageExporter::captureEvents(const Map *map) {
+    QList<DecorationSnapshot> decorations;
+    if (!eventsEnabled())
+        return decorations;
 
-            progress->setValue(numDrawn++);
+    for (const auto &group : Event::groups()) {
+        if (!m_settings.showEvents.contains(group))
+            continue;
+        for (const auto &event : map->getEvents(group)) {
+            m_project->loadEventPixmap(event);
+            decorations.append({
+                .pos = QPoint(event->getPixelX(), event->getPixelY()),
+                .image = event->getPixmap().toImage(),
+                // GIF format doesn't support partial transparency, so we can't do this in Timelapse mode.
+                .opacity = (m_mode != ImageExporterMode::Timelapse && event->getUsesDefaultPixmap()) ? 0.7 : 1.0,
+            });
         }
     }
+    return decorations;
+}
 
-    // Draw the layout and collision images.
-    progress->setLabelText("Drawing maps...");
-    progress->setValue(0);
-    numDrawn = 0;
-    for (const StitchedMap &map : stitchedMaps) {
-        if (progress->wasCanceled()) {
-            return QImage();
-        }
-        map.map->layout()->render(true);
-        painter.translate(map.x, map.y);
-        painter.drawImage(0, 0, map.map->layout()->image);
-        paintCollision(&painter, map.map->layout());
-        painter.translate(-map.x, -map.y);
-
-        progress->setValue(numDrawn++);
-    }
-
-    // Events can be occluded by neighboring maps if they are positioned
-    // near or outside the map's edge, so we draw them after all the maps.
-    // Nothing should be on top of the grid, so it's drawn last.
-    if (m_settings.showGrid || eventsEnabled()) {
-        progress->setLabelText("Drawing map decorations...");
-        progress->setValue(0);
-        numDrawn = 0;
-        for (const StitchedMap &map : stitchedMaps) {
-            if (progress->wasCanceled()) {
-                return QImage();
-            }
-            painter.translate(map.x, map.y);
-            paintEvents(&painter, map.map);
-            paintGrid(&painter, map.map->layout());
-            painter.translate(-map.x, -map.y);
+void MapImageExporter::updatePreview(bool forceUpdate) {
+    // Anything that calls this has changed the image, so the current preview (if any) is out-of-date.
+    m_previewIsCurrent = false;
+    if (m_settings.disablePreviewUpdates && !forceUpdate)
+        return;
 
-            progress->setValue(numDrawn++);
-        }
+    if (m_previewJob) {
+        auto job = m_previewJob;
+        m_previewJob = nullptr;
+        m_exportQueue->cancel(job);
+    }
+    if (m_timelapseMovie)
+        m_timelapseMovie->stop();
+
+    QList<MapImageFrame> frames;
+    if (!captureFrames(&frames)) {
+        setPreviewImage(QImage());
+        return;
     }
 
-    return stitchedImage;
+    // Render the preview in the background. The old preview remains visible until it finishes.
+    m_previewJob = new MapImageExportJob(m_mode, m_settings, frames);
+    ui->progressBar_Preview->setRange(0, 0);
+    ui->progressBar_Preview->setVisible(true);
+    m_exportQueue->enqueue(m_previewJob);
 }
 
-void MapImageExporter::updatePreview(bool forceUpdate) {
-    if (m_settings.disablePreviewUpdates && !forceUpdate)
+void MapImageExporter::onPreviewJobProgressChanged(MapImageExportJob *job, int value, int maximum, const QString &label) {
+    if (!job || job != m_previewJob)
+        return;
+    ui->progressBar_Preview->setRange(0, maximum);
+    ui->progressBar_Preview->setValue(value);
+    ui->progressBar_Preview->setFormat(QString("%1 %p%").arg(label));
+}
+
+void MapImageExporter::onPreviewJobFinished(MapImageExportJob *job) {
+    if (!job || job != m_previewJob)
         return;
+    m_previewJob = nullptr;
+    ui->progressBar_Preview->setVisible(false);
 
-    QProgressDialog progress("", "Cancel", 0, 1, this);
-    progress.setAutoClose(true);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setModal(true);
-    progress.setMinimumDuration(1000);
+    if (!job->succeeded()) {
+        setPreviewImage(QImage());
+        return;
+    }
 
-    if (m_mode == ImageExporterMode::Normal) {
-        m_previewImage = getFormattedMapImage();
-    } else if (m_mode == ImageExporterMode::Stitch) {
-        m_previewImage = getStitchedImage(&progress);
-    } else if (m_mode == ImageExporterMode::Timelapse) {
-        if (m_timelapseMovie)
-            m_timelapseMovie->stop();
+    if (job->mode() == ImageExporterMode::Timelapse) {
+        // We want to convert the GIF data into a QMovie for the preview display.
+        m_timelapseGif = job->resultGif();
+        delete m_timelapseBuffer;
+        m_timelapseBuffer = new QBuffer(this);
+        m_timelapseBuffer->setData(m_timelapseGif);
 
-        m_timelapseGifImage = createTimelapseGifImage(&progress);
-        if (!m_timelapseGifImage) {
-            m_previewImage = QImage();
-        } else {
-            // We want to convert the QGifImage data into a QMovie for the preview display.
-            // Both support input/output with a QIODevice, so we use a QBuffer to translate the data.
-            delete m_timelapseBuffer;
-            m_timelapseBuffer = new QBuffer(this);
-            m_timelapseBuffer->open(QBuffer::ReadWrite);
-            m_timelapseGifImage->save(m_timelapseBuffer);
-            m_timelapseBuffer->close();
-
-            delete m_timelapseMovie;
-            m_timelapseMovie = new QMovie(m_timelapseBuffer, "gif", this);
-            m_timelapseMovie->setCacheMode(QMovie::CacheAll);
-            connect(m_timelapseMovie, &QMovie::frameChanged, [this](int) {
-                m_preview->setPixmap(m_timelapseMovie->currentPixmap());
-            });
-            m_timelapseMovie->start();
-            m_previewImage = m_timelapseMovie->currentImage();
-        }
+        delete m_timelapseMovie;
+        m_timelapseMovie = new QMovie(m_timelapseBuffer, "gif", this);
+        m_timelapseMovie->setCacheMode(QMovie::CacheAll);
+        connect(m_timelapseMovie, &QMovie::frameChanged, [this](int) {
+            m_preview->setPixmap(m_timelapseMovie->currentPixmap());
+        });
+        m_timelapseMovie->start();
+        setPreviewImage(m_timelapseMovie->currentImage());
     } else {
-        m_previewImage = QImage();
+        setPreviewImage(job->resultImage());
     }
-    progress.close();
+    m_previewIsCurrent = true;
+}
 
+void MapImageExporter::setPreviewImage(const QImage &image) {
+    m_previewImage = image;
     m_previewImage.setColorSpace(Util::toColorSpace(porymapConfig.imageExportColorSpaceId));
     m_preview->setPixmap(QPixmap::fromImage(m_previewImage));
     m_scene->setSceneRect(m_scene->itemsBoundingRect());
@@ -573,34 +598,6 @@ void MapImageExporter::scalePreview() {
     ui->graphicsView_Preview->fitInView(m_preview, Qt::KeepAspectRatioByExpanding);
 }
 
-QImage MapImageExporter::getFormattedMapImage() {
-    if (!m_layout)
-        return QImage();
-
-    m_layout->render(true);
-
-    // Create image large enough to contain the map and the marginal elements (the border, grid, etc.)
-    QMargins margins = getMargins(m_map);
-    QImage image(m_layout->image.width() + margins.left() + margins.right(),
-                 m_layout->image.height() + margins.top() + margins.bottom(),
-                 QImage::Format_RGBA8888);
-    image.fill(m_settings.fillColor);
-
-    QPainter painter(&image);
-    painter.translate(margins.left(), margins.top());
-
-    paintBorder(&painter, m_layout);
-    painter.drawImage(0, 0, m_layout->image);
-    paintCollision(&painter, m_layout);
-    if (m_map) {
-        paintConnections(&painter, m_map);
-        paintEvents(&painter, m_map);
-    }
-    paintGrid(&painter, m_layout);
-
-    return image;
-}
-
 QMargins MapImageExporter::getMargins(const Map *map) {
     QMargins margins;
     if (m_settings.showBorder) {
@@ -628,85 +625,6 @@ QMargins MapImageExporter::getMargins(const Map *map) {
     return margins;
 }
 
-void MapImageExporter::paintCollision(QPainter *painter, Layout *layout) {
-    if (!m_settings.showCollision)
-        return;
-
-    layout->renderCollision(true);
-
-    auto savedOpacity = painter->opacity();
-    painter->setOpacity(static_cast<qreal>(porymapConfig.collisionOpacity) / 100);
-    painter->drawImage(0, 0, layout->collision_image);
-    painter->setOpacity(savedOpacity);
-}
-
-void MapImageExporter::paintBorder(QPainter *painter, Layout *layout) {
-    if (!m_settings.showBorder)
-        return;
-
-    layout->renderBorder(true);
-
-    // Clip parts of the border that would be beyond player visibility.
-    painter->save();
-    painter->setClipRect(layout->getVisibleRect());
-
-    const QMargins borderMargins = layout->getBorderMargins();
-    for (int y = -borderMargins.top(); y < layout->getHeight() + borderMargins.bottom(); y += layout->getBorderHeight())
-    for (int x = -borderMargins.left(); x < layout->getWidth() + borderMargins.right(); x += layout->getBorderWidth()) {
-         // Skip border painting if it would be fully covered by the rest of the map
-        if (layout->isWithinBounds(QRect(x, y, layout->getBorderWidth(), layout->getBorderHeight())))
-            continue;
-        painter->drawImage(x * Metatile::pixelWidth(), y * Metatile::pixelHeight(), layout->border_image);
-    }
-
-    painter->restore();
-}
-
-void MapImageExporter::paintConnections(QPainter *painter, const Map *map) {
-    if (!connectionsEnabled())
-        return;
-
-    for (const auto &connection : map->getConnections()) {
-        if (!m_settings.showConnections.contains(connection->direction()))
-            continue;
-        painter->drawImage(connection->relativePixelPos(true), connection->renderImage());
-    }
-}
-
-void MapImageExporter::paintEvents(QPainter *painter, const Map *map) {
-    if (!eventsEnabled())
-        return;
-
-    auto savedOpacity = painter->opacity();
-    for (const auto &group : Event::groups()) {
-        if (!m_settings.showEvents.contains(group))
-            continue;
-        for (const auto &event : map->getEvents(group)) {
-            m_project->loadEventPixmap(event);
-            if (m_mode != ImageExporterMode::Timelapse) {
-                // GIF format doesn't support partial transparency, so we can't do this in Timelapse mode.
-                painter->setOpacity(event->getUsesDefaultPixmap() ? 0.7 : 1.0);
-            }
-            painter->drawImage(QPoint(event->getPixelX(), event->getPixelY()), event->getPixmap().toImage());
-        }
-    }
-    painter->setOpacity(savedOpacity);
-}
-
-void MapImageExporter::paintGrid(QPainter *painter, const Layout *layout) {
-    if (!m_settings.showGrid)
-        return;
-
-    int w = layout->pixelWidth();
-    int h = layout->pixelHeight();
-    for (int x = 0; x <= w; x += Metatile::pixelWidth()) {
-        painter->drawLine(x, 0, x, h);
-    }
-    for (int y = 0; y <= h; y += Metatile::pixelHeight()) {
-        painter->drawLine(0, y, w, y);
-    }
-}
-
 bool MapImageExporter::eventsEnabled() {
     return !m_settings.showEvents.isEmpty();
 }
@@ -0,0 +1,370 @@
+#include "mapimageexportjob.h"
+#include "imageproviders.h"
+#include "collisionatlas.h"
+#include "qgifimage.h"
+#include "editor.h"
+#include "config.h"
+#include "utility.h"
+#include "log.h"
+#include "perftrace.h"
+
+#include <QPainter>
+#include <QBuffer>
+
+MapImageExportJob::MapImageExportJob(ImageExporterMode mode,
+                                     const ImageExporterSettings &settings,
+                                     const QList<MapImageFrame> &frames,
+                                     const QString &outputPath,
+                                     QObject *parent)
+    : QObject(parent),
+      m_mode(mode),
+      m_settings(settings),
+      m_frames(frames),
+      m_outputPath(outputPath),
+      m_collisionAtlas(CollisionAtlas::get(static_cast<qreal>(porymapConfig.collisionOpacity) / 100)),
+      m_colorSpace(Util::toColorSpace(porymapConfig.imageExportColorSpaceId)),
+      m_metatileImageSettings(MetatileImageSettings::fromProjectConfig())
+{
+    // The job is owned by the export queue, not the thread pool.
+    setAutoDelete(false);
+}
+
+void MapImageExportJob::run() {
+    m_succeeded = !m_canceled && render();
+    emit finished();
+}
+
+bool MapImageExportJob::reportProgress(int value, int maximum, const QString &label) {
+    emit progressChanged(value, maximum, label);
+    return !m_canceled;
+}
+
+bool MapImageExportJob::render() {
+    PERF_TRACE("MapImageExportJob::render", m_outputPath);
+    if (m_frames.isEmpty()) {
+        m_errorString = QStringLiteral("Nothing to export.");
+        return false;
+    }
+
+    if (m_mode == ImageExporterMode::Timelapse) {
+        QSize canvasSize(0, 0);
+        for (const auto &frame : m_frames) {
+            canvasSize = canvasSize.expandedTo(frame.layout.pixelSize().grownBy(frame.margins));
+        }
+
+        QGifImage timelapseImg(canvasSize);
+        timelapseImg.setDefaultDelay(m_settings.timelapseDelayMs);
+        timelapseImg.setDefaultTransparentColor(m_settings.fillColor);
+        for (int i = 0; i < m_frames.length(); i++) {
+            if (!reportProgress(i, m_frames.length(), QStringLiteral("Building timelapse...")))
+                return false;
+            m_resultImage = renderTimelapseFrame(m_frames.at(i), canvasSize);
+            timelapseImg.addFrame(m_resultImage);
+        }
+
+        if (!reportProgress(m_frames.length(), m_frames.length(), QStringLiteral("Encoding timelapse...")))
+            return false;
+        if (!m_outputPath.isEmpty()) {
+            if (!timelapseImg.save(m_outputPath)) {
+                m_errorString = QString("Failed to write '%1'").arg(m_outputPath);
+                return false;
+            }
+        } else {
+            QBuffer buffer(&m_resultGif);
+            buffer.open(QBuffer::WriteOnly);
+            timelapseImg.save(&buffer);
+            buffer.close();
+        }
+        return true;
+    }
+
+    m_resultImage = (m_mode == ImageExporterMode::Stitch) ? renderStitchedFrames() : renderFrame(m_frames.first());
+    if (m_resultImage.isNull())
+        return false;
+    m_resultImage.setColorSpace(m_colorSpace);
+
+    if (!m_outputPath.isEmpty() && !m_resultImage.save(m_outputPath)) {
+        m_errorString = QString("Failed to write '%1'").arg(m_outputPath);
+        return false;
+    }
+    return true;
+}
+
+QImage MapImageExportJob::renderFrame(const MapImageFrame &frame) {
+    PERF_TRACE("MapImageExportJob::renderFrame");
+    // Create image large enough to contain the map and the marginal elements (the border, grid, etc.)
+    QImage image(frame.layout.pixelSize().grownBy(frame.margins), QImage::Format_RGBA8888);
+    image.fill(m_settings.fillColor);
+
+    QPainter painter(&image);
+    painter.translate(frame.margins.left(), frame.margins.top());
+
+    paintBorder(&painter, frame.layout);
+    paintLayout(&painter, frame.layout);
+    paintCollision(&painter, frame.layout);
+    paintDecorations(&painter, frame.connections);
+    paintDecorations(&painter, frame.events);
+    paintGrid(&painter, frame.layout);
+
+    return image;
+}
+
+QImage MapImageExportJob::renderTimelapseFrame(const MapImageFrame &frame, const QSize &canvasSize) {
+    QImage image = renderFrame(frame);
+    if (image.width() >= canvasSize.width() && image.height() >= canvasSize.height())
+        return image;
+
+    // Increase the frame's size to match the canvas, centering the old image in the new one.
+    QImage resizedImage(canvasSize, QImage::Format_RGBA8888);
+    resizedImage.fill(m_settings.fillColor);
+    QPainter painter(&resizedImage);
+    int x = (canvasSize.width() - image.width()) / 2;
+    int y = (canvasSize.height() - image.height()) / 2;
+    painter.drawImage(x, y, image);
+    return resizedImage;
+}
+
+QImage MapImageExportJob::renderStitchedFrames() {
+    // Determine the overall dimensions of the stitched maps.
+    QRect dimensions;
+    for (const auto &frame : m_frames) {
+        dimensions |= (QRect(frame.offset, frame.layout.pixelSize()) + frame.margins);
+    }
+
+    QImage stitchedImage(dimensions.width(), dimensions.height(), QImage::Format_RGBA8888);
+    stitchedImage.fill(m_settings.fillColor);
+
+    QPainter painter(&stitchedImage);
+    painter.translate(-dimensions.left(), -dimensions.top());
+
+    auto paintAll = [&](const QString &label, std::function<void(const MapImageFrame &)> paintFrame) {
+        for (int i = 0; i < m_frames.length(); i++) {
+            if (!reportProgress(i, m_frames.length(), label))
+                return false;
+            const MapImageFrame &frame = m_frames.at(i);
+            painter.translate(frame.offset);
+            paintFrame(frame);
+            painter.translate(-frame.offset);
+        }
+        return true;
+    };
+
+    // Borders can occlude neighboring maps, so we draw all the borders before drawing any maps.
+    // Note: Borders can also overlap the borders of neighboring maps. It's not technically wrong to do this,
+    //       but it might suggest to users that something is visible in-game that actually isn't.
+    //       (e.g. in FRLG, Route 18's water border can overlap Fuchsia's tree border. It suggests you could
+    //        see a jarring transition in-game from one of these maps, but because of the collision map the
+    //        player isn't actually able to get close enough to this transition to see it).
+    //       Perhaps some future export setting could limit the border rendering to the visibility range from walkable areas.
+    if (m_settings.showBorder) {
+        if (!paintAll(QStringLiteral("Drawing borders..."), [&](const MapImageFrame &frame) { paintBorder(&painter, frame.layout); }))
+            return QImage();
+    }
+
+    // Draw the layout and collision images.
+    if (!paintAll(QStringLiteral("Drawing maps..."), [&](const MapImageFrame &frame) {
+        paintLayout(&painter, frame.layout);
+        paintCollision(&painter, frame.layout);
+    })) return QImage();
+
+    // Events can be occluded by neighboring maps if they are positioned
+    // near or outside the map's edge, so we draw them after all the maps.
+    // Nothing should be on top of the grid, so it's drawn last.
+    if (!paintAll(QStringLiteral("Drawing map decorations..."), [&](const MapImageFrame &frame) {
+        paintDecorations(&painter, frame.events);
+        paintGrid(&painter, frame.layout);
+    })) return QImage();
+
+    return stitchedImage;
+}
+
+QImage MapImageExportJob::getMetatileImage(uint16_t metatileId, const LayoutSnapshot &layout) {
+    // Frames often share tilesets, so metatile images are cached for the lifetime of the job.
+    auto &imageCache = m_metatileImageCache[qMakePair(layout.primaryTileset.get(), layout.secondaryTileset.get())];
+    auto it = imageCache.constFind(metatileId);
+    if (it != imageCache.constEnd())
+        return it.value();
+
+    const Tileset *primaryTileset = layout.primaryTileset.get();
+    const Tileset *secondaryTileset = layout.secondaryTileset.get();
+    QImage metatileImage = ::getMetatileImage(Tileset::getMetatile(metatileId, primaryTileset, secondaryTileset),
+                                              primaryTileset,
+                                              secondaryTileset,
+                                              layout.layerOrder,
+                                              layout.layerOpacity,
+                                              false,
+                                              m_metatileImageSettings);
+    imageCache.insert(metatileId, metatileImage);
+    return metatileImage;
+}
+
+QImage MapImageExportJob::renderLayout(const LayoutSnapshot &layout) {
+    bool canReuse = m_lastLayout.image.size() == layout.pixelSize()
+                 && m_lastLayout.blockdata.length() == layout.blockdata.length()
+                 && m_lastLayout.primaryTileset == layout.primaryTileset.get()
+                 && m_lastLayout.secondaryTileset == layout.secondaryTileset.get();
+    if (!canReuse) {
+        m_lastLayout.image = QImage(layout.pixelSize(), QImage::Format_RGBA8888);
+        m_lastLayout.image.fill(Qt::transparent);
+    }
+    if (layout.width <= 0 || layout.height <= 0)
+        return m_lastLayout.image;
+
+    QPainter painter(&m_lastLayout.image);
+    for (int i = 0; i < layout.blockdata.length(); i++) {
+        uint16_t metatileId = layout.blockdata.at(i).metatileId();
+        if (canReuse && m_lastLayout.blockdata.at(i).metatileId() == metatileId)
+            continue;
+        int x = (i % layout.width) * Metatile::pixelWidth();
+        int y = (i / layout.width) * Metatile::pixelHeight();
+        painter.drawImage(x, y, getMetatileImage(metatileId, layout));
+    }
+    painter.end();
+
+    m_lastLayout.blockdata = layout.blockdata;
+    m_lastLayout.primaryTileset = layout.primaryTileset.get();
+    m_lastLayout.secondaryTileset = layout.secondaryTileset.get();
+    return m_lastLayout.image;
+}
+
+QImage MapImageExportJob::renderBorder(const LayoutSnapshot &layout) {
+    QImage image(layout.borderWidth * Metatile::pixelWidth(), layout.borderHeight * Metatile::pixelHeight(), QImage::Format_RGBA8888);
+    image.fill(Qt::transparent);
+    if (layout.borderWidth <= 0)
+        return image;
+
+    QPainter painter(&image);
+    for (int i = 0; i < layout.border.length(); i++) {
+        int x = (i % layout.borderWidth) * Metatile::pixelWidth();
+        int y = (i / layout.borderWidth) * Metatile::pixelHeight();
+        painter.drawImage(x, y, getMetatileImage(layout.border.at(i).metatileId(), layout));
+    }
+    return image;
+}
+
+QImage MapImageExportJob::renderCollision(const LayoutSnapshot &layout) {
+    QImage image(layout.pixelSize(), QImage::Format_RGBA8888);
+    image.fill(Qt::transparent);
+    if (layout.width <= 0)
+        return image;
+
+    for (int i = 0; i < layout.blockdata.length(); i++) {
+        int x = (i % layout.width) * Metatile::pixelWidth();
+        int y = (i / layout.width) * Metatile::pixelHeight();
+        m_collisionAtlas->drawBlock(&image, x, y, layout.blockdata.at(i));
+    }
+    return image;
+}
+
+void MapImageExportJob::paintLayout(QPainter *painter, const LayoutSnapshot &layout) {
+    painter->drawImage(0, 0, renderLayout(layout));
+}
+
+void MapImageExportJob::paintCollision(QPainter *painter, const LayoutSnapshot &layout) {
+    if (!m_settings.showCollision)
+        return;
+
+    // The collision opacity is already applied by the atlas.
+    painter->drawImage(0, 0, renderCollision(layout));
+}
+
+void MapImageExportJob::paintBorder(QPainter *painter, const LayoutSnapshot &layout) {
+    if (!m_settings.showBorder || layout.borderWidth <= 0 || layout.borderHeight <= 0)
+        return;
+
+    const QImage borderImage = renderBorder(layout);
+    const QRect layoutRect(0, 0, layout.width, layout.height);
+
+    // Clip parts of the border that would be beyond player visibility.
+    painter->save();
+    painter->setClipRect(layout.visibleRect);
+
+    for (int y = -layout.borderMargins.top(); y < layout.height + layout.borderMargins.bottom(); y += layout.borderHeight)
+    for (int x = -layout.borderMargins.left(); x < layout.width + layout.borderMargins.right(); x += layout.borderWidth) {
+         // Skip border painting if it would be fully covered by the rest of the map
+        if (layoutRect.contains(QRect(x, y, layout.borderWidth, layout.borderHeight)))
+            continue;
+        painter->drawImage(x * Metatile::pixelWidth(), y * Metatile::pixelHeight(), borderImage);
+    }
+
+    painter->restore();
+}
+
+void MapImageExportJob::paintDecorations(QPainter *painter, const QList<DecorationSnapshot> &decorations) {
+    auto savedOpacity = painter->opacity();
+    for (const auto &decoration : decorations) {
+        painter->setOpacity(decoration.opacity);
+        painter->drawImage(decoration.pos, decoration.image);
+    }
+    painter->setOpacity(savedOpacity);
+}
+
+void MapImageExportJob::paintGrid(QPainter *painter, const LayoutSnapshot &layout) {
+    if (!m_settings.showGrid)
+        return;
+
+    int w = layout.pixelWidth();
+    int h = layout.pixelHeight();
+    for (int x = 0; x <= w; x += Metatile::pixelWidth()) {
+        painter->drawLine(x, 0, x, h);
+    }
+    for (int y = 0; y <= h; y += Metatile::pixelHeight()) {
+        painter->drawLine(0, y, w, y);
+    }
+}
+
+
+MapImageExportQueue::MapImageExportQueue(QObject *parent) : QObject(parent) {}
+
+MapImageExportQueue::~MapImageExportQueue() {
+    // Jobs only read from their own snapshots, but they still need to finish before they're deleted.
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+void MapImageExportQueue::enqueue(MapImageExportJob *job) {
+    if (!job) return;
+    job->setParent(this);
+    m_jobs.append(job);
+    connect(job, &MapImageExportJob::progressChanged, this, [this, job](int value, int maximum, const QString &label) {
+        emit jobProgressChanged(job, value, maximum, label);
+    });
+    connect(job, &MapImageExportJob::finished, this, [this, job] { onJobFinished(job); });
+    m_pool.start(job);
+}
+
+void MapImageExportQueue::cancel(MapImageExportJob *job) {
+    if (!job || !m_jobs.contains(job)) return;
+    job->cancel();
+
+    // If the job hasn't started yet we can remove it from the queue now,
+    // otherwise it will stop at its next progress update.
+    if (m_pool.tryTake(job)) {
+        emit job->finished();
+    }
+}
+
+void MapImageExportQueue::cancelAll() {
+    // Canceling a job may remove it from m_jobs, so we iterate over a copy.
+    for (const auto &job : jobs()) {
+        cancel(job);
+    }
+}
+
+QList<MapImageExportJob*> MapImageExportQueue::jobs() const {
+    QList<MapImageExportJob*> jobs;
+    for (const auto &job : m_jobs) {
+        if (job) jobs.append(job);
+    }
+    return jobs;
+}
+
+void MapImageExportQueue::onJobFinished(MapImageExportJob *job) {
+    if (!m_jobs.removeOne(job))
+        return;
+    if (!job->wasCanceled() && !job->succeeded()) {
+        logError(QString("Image export failed: %1").arg(job->errorString()));
+    }
+    emit jobFinished(job);
+    job->deleteLater();
+}
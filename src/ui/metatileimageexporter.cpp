@@ -5,6 +5,7 @@
 #include "utility.h"
 #include "project.h"
 #include "metatile.h"
+#include "perftrace.h"
 
 #include <QTimer>
 
@@ -250,6 +251,7 @@ void MetatileImageExporter::tryUpdatePreview() {
 }
 
 void MetatileImageExporter::updatePreview() {
+    PERF_TRACE("MetatileImageExporter::updatePreview");
     copyRenderSettings();
 
     m_layerOrder.clear();
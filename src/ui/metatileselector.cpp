@@ -1,6 +1,7 @@
 #include "imageproviders.h"
 #include "metatileselector.h"
 #include "project.h"
+#include "pixmapchunkcache.h"
 #include <QPainter>
 
 QSize MetatileSelector::getSelectionDimensions() const {
@@ -24,6 +25,47 @@ void MetatileSelector::draw() {
         updateBasePixmap();
     setPixmap(this->basePixmap);
     drawSelection();
+
+    // Redrawing only changes the area under the old and new selection rectangles (unless the base pixmap changed).
+    // Remember that area so the downsampled copy painted when zoomed out can be updated rather than recreated.
+    const QSize dimensions = getSelectionDimensions();
+    const QRect selectionRect = QRect(getSelectionStart().x() * this->cellWidth, getSelectionStart().y() * this->cellHeight,
+                                      dimensions.width() * this->cellWidth, dimensions.height() * this->cellHeight) + QMargins(1,1,1,1);
+    this->mipDirtyRect |= this->drawnSelectionRect | selectionRect;
+    this->drawnSelectionRect = selectionRect;
+}
+
+// When the metatile selector is zoomed out, paint a downsampled copy of the pixmap rather than scaling it on every paint.
+void MetatileSelector::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    const int level = PixmapChunkCache::mipLevel(painter);
+    if (level == 0 || pixmap().isNull()) {
+        SelectablePixmapItem::paint(painter, option, widget);
+        return;
+    }
+    if (this->mipPixmap.isNull() || this->mipBasePixmapKey != this->basePixmap.cacheKey() || this->mipPixmapLevel != level) {
+        this->mipPixmap = QPixmap::fromImage(PixmapChunkCache::downsample(pixmap().toImage(), level));
+        this->mipPixmapKey = pixmap().cacheKey();
+        this->mipBasePixmapKey = this->basePixmap.cacheKey();
+        this->mipPixmapLevel = level;
+        this->mipDirtyRect = QRect();
+    } else if (this->mipPixmapKey != pixmap().cacheKey()) {
+        // Only the selection changed, so only downsample the area it covers. The area is aligned to the
+        // downsampling factor so that each pixel of the downsampled copy is made from the same pixels as before.
+        const int factor = 1 << level;
+        const QRect dirtyRect = this->mipDirtyRect & pixmap().rect();
+        if (!dirtyRect.isEmpty()) {
+            const QRect alignedRect = QRect(QPoint(dirtyRect.left() / factor * factor, dirtyRect.top() / factor * factor),
+                                            QPoint((dirtyRect.right() / factor + 1) * factor - 1, (dirtyRect.bottom() / factor + 1) * factor - 1))
+                                      & pixmap().rect();
+            QPainter mipPainter(&this->mipPixmap);
+            mipPainter.setCompositionMode(QPainter::CompositionMode_Source);
+            mipPainter.drawImage(alignedRect.topLeft() / factor, PixmapChunkCache::downsample(pixmap().copy(alignedRect).toImage(), level));
+        }
+        this->mipPixmapKey = pixmap().cacheKey();
+        this->mipDirtyRect = QRect();
+    }
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, transformationMode() == Qt::SmoothTransformation);
+    painter->drawPixmap(QRectF(offset(), pixmap().size()), this->mipPixmap, QRectF(this->mipPixmap.rect()));
 }
 
 void MetatileSelector::drawSelection() {
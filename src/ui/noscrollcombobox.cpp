@@ -1,9 +1,11 @@
 #include "noscrollcombobox.h"
 #include "utility.h"
+#include "constantsmodel.h"
 
 #include <QCompleter>
 #include <QLineEdit>
 #include <QWheelEvent>
+#include <QListView>
 
 NoScrollComboBox::NoScrollComboBox(QWidget *parent)
     : QComboBox(parent)
@@ -58,6 +60,69 @@ void NoScrollComboBox::setFocusedScrollingEnabled(bool enabled)
     this->focusedScrollingEnabled = enabled;
 }
 
+// Display a list of project constants, which may be shared with other combo boxes.
+// Autocomplete searches 'searchModels' (or just 'model' if none are given) for prefix, substring, and fuzzy matches.
+void NoScrollComboBox::setConstantsModel(ConstantsModel *model, const QList<ConstantsModel*> &searchModels) {
+    const QSignalBlocker b(this);
+    const QString savedText = this->currentText();
+    if (this->model() != model) {
+        this->setModel(model);
+        // Don't let text typed into the combo box be added to the model.
+        this->setInsertPolicy(QComboBox::NoInsert);
+
+        // The model is shared, and may change while the combo box is displayed (e.g. when a MAPSEC is removed).
+        // QComboBox would then select a neighbouring item (or nothing) and report it as a change of the current text.
+        // These connections are made after setModel, so they run after QComboBox has handled the change.
+        for (const auto &connection : this->modelConnections) {
+            disconnect(connection);
+        }
+        this->modelConnections = {
+            connect(model, &QAbstractItemModel::rowsAboutToBeInserted, this, [this] { beginModelChange(); }),
+            connect(model, &QAbstractItemModel::rowsInserted,          this, [this] { endModelChange(); }),
+            connect(model, &QAbstractItemModel::rowsAboutToBeRemoved,  this, [this] { beginModelChange(); }),
+            connect(model, &QAbstractItemModel::rowsRemoved,           this, [this] { endModelChange(); }),
+            connect(model, &QAbstractItemModel::modelAboutToBeReset,   this, [this] { beginModelChange(); }),
+            connect(model, &QAbstractItemModel::modelReset,            this, [this] { endModelChange(); }),
+        };
+    }
+
+    if (this->lineEdit()) {
+        if (!this->searchModel) {
+            this->searchModel = new ConstantsSearchModel(this);
+        }
+        // Note: Depending on the Qt version, setModel may have replaced the completer's model.
+        if (!this->completer() || this->completer()->model() != this->searchModel) {
+            auto completer = new QCompleter(this->searchModel, this);
+            completer->setCaseSensitivity(Qt::CaseInsensitive);
+            completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+
+            // Improve display speed for the autocomplete popup
+            auto popup = qobject_cast<QListView *>(completer->popup());
+            if (popup) popup->setUniformItemSizes(true);
+
+            this->setCompleter(completer);
+        }
+        connect(this->lineEdit(), &QLineEdit::textEdited, this->searchModel, &ConstantsSearchModel::setQuery, Qt::UniqueConnection);
+        this->searchModel->setSources(searchModels.isEmpty() ? QList<ConstantsModel*>{model} : searchModels);
+    }
+    this->setTextItem(savedText);
+}
+
+// Keeps the current text while the model changes, without emitting signals for any changes QComboBox makes in the meantime.
+void NoScrollComboBox::beginModelChange() {
+    if (this->modelChangeDepth++ > 0)
+        return;
+    this->textBeforeModelChange = this->currentText();
+    this->signalsBlockedBeforeModelChange = this->blockSignals(true);
+}
+
+void NoScrollComboBox::endModelChange() {
+    if (this->modelChangeDepth == 0 || --this->modelChangeDepth > 0)
+        return;
+    this->setTextItem(this->textBeforeModelChange);
+    this->blockSignals(this->signalsBlockedBeforeModelChange);
+}
+
 void NoScrollComboBox::setItem(int index, const QString &text)
 {
     if (index >= 0) {
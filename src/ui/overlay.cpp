@@ -1,29 +1,96 @@
 #ifdef QT_QML_LIB
 #include "overlay.h"
 #include "scripting.h"
+#include "perftrace.h"
 #include "log.h"
 
+#include <QtMath>
+#include <algorithm>
+
+// Items are indexed in a grid of cells this many pixels wide and tall.
+static const int indexCellSize = 128;
+
+// Items that overlap more cells than this aren't indexed. Indexing them would cost more than it saves.
+static const int maxIndexedCells = 256;
+
+// The cached chunks of a layer are this many pixels wide and tall (relative to the layer, before it's scaled).
+static const int chunkSize = 256;
+
+// Layers with fewer items than this are cheap enough to paint directly.
+static const int minItemsToCache = 32;
+
+// The most memory (in KB) the cached chunks of each layer may use.
+static const int maxChunkCacheKB = 64 * 1024;
+
+static quint64 cellKey(int x, int y) {
+    return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+}
+
+// Returns the range of cells (inclusive) that 'rect' overlaps in a grid of the given cell size.
+static QRect getCellRange(const QRectF &rect, int cellSize) {
+    return QRect(QPoint(qFloor(rect.left() / cellSize), qFloor(rect.top() / cellSize)),
+                 QPoint(qFloor(rect.right() / cellSize), qFloor(rect.bottom() / cellSize)));
+}
+
+static qint64 getCellCount(const QRect &cellRange) {
+    return static_cast<qint64>(cellRange.width()) * cellRange.height();
+}
+
 void OverlayText::render(QPainter *painter) {
-    QFont font = painter->font();
-    font.setPixelSize(this->fontSize);
-    painter->setFont(font);
+    painter->setFont(this->font);
     painter->setPen(this->color);
     painter->drawStaticText(this->x, this->y, this->text);
 }
 
+QRectF OverlayText::boundingRect() const {
+    QStaticText text(this->text);
+    text.prepare(QTransform(), this->font);
+    // Leave a little room for glyphs that extend beyond the text's layout (e.g. italics or antialiasing).
+    return QRectF(QPointF(this->x, this->y), text.size()).adjusted(-2, -2, 2, 2);
+}
+
 void OverlayPath::render(QPainter *painter) {
     painter->fillPath(this->path, this->fillColor);
     painter->setPen(this->borderColor);
     painter->drawPath(this->path);
 }
 
+QRectF OverlayPath::boundingRect() const {
+    // Include the border, which is centered on the path.
+    return this->path.boundingRect().adjusted(-1, -1, 1, 1);
+}
+
 void OverlayPixmap::render(QPainter *painter) {
     painter->drawPixmap(this->x, this->y, this->pixmap);
 }
 
-void Overlay::renderItems(QPainter *painter) {
-    if (this->hidden) return;
+QRectF OverlayPixmap::boundingRect() const {
+    return QRectF(this->x, this->y, this->pixmap.width(), this->pixmap.height());
+}
+
+QTransform Overlay::getTransform() const {
+    QTransform transform;
+    transform.translate(this->x, this->y);
+    transform.rotate(this->angle);
+    transform.scale(this->hScale, this->vScale);
+    return transform;
+}
+
+// 'exposedRect' is the area of the scene that needs to be painted. Items outside of it are skipped.
+void Overlay::renderItems(QPainter *painter, const QRectF &exposedRect) {
+    if (this->hidden || this->items.isEmpty()) return;
+
+    QRectF visibleRect = exposedRect;
+    if (this->clippingRect)
+        visibleRect &= *this->clippingRect;
+    if (visibleRect.isEmpty()) return;
+
+    bool invertible;
+    const QTransform transform = getTransform();
+    const QTransform inverse = transform.inverted(&invertible);
+    if (!invertible) return; // Layer is scaled to nothing
 
+    PERF_TRACE("Overlay::renderItems");
     painter->save();
 
     if (this->clippingRect) {
@@ -31,24 +98,155 @@ void Overlay::renderItems(QPainter *painter) {
         painter->setClipRect(*this->clippingRect);
     }
 
-    QTransform transform = painter->transform();
-    transform.translate(this->x, this->y);
-    transform.rotate(this->angle);
-    transform.scale(this->hScale, this->vScale);
-    painter->setTransform(transform);
-
-    painter->setOpacity(this->opacity);
-    for (auto item : this->items)
-        item->render(painter);
+    painter->setTransform(transform, true);
+
+    // The area of the layer that's visible.
+    const QRectF rect = inverse.mapRect(visibleRect);
+
+    // Layers that are only moved or scaled can be painted from cached chunks, so long as their items have stopped changing.
+    // Scripts that redraw a layer often (e.g. every time the cursor moves) would otherwise re-render the chunks constantly.
+    const QTransform deviceTransform = painter->deviceTransform();
+    if (this->items.length() >= minItemsToCache && !this->itemsChanged && deviceTransform.type() <= QTransform::TxScale) {
+        renderCachedChunks(painter, rect, qAbs(deviceTransform.m11()), qAbs(deviceTransform.m22()));
+    } else {
+        painter->setOpacity(this->opacity);
+        for (int index : getItemsInRect(rect)) {
+            if (this->itemBounds.at(index).intersects(rect))
+                this->items.at(index)->render(painter);
+        }
+    }
+    this->itemsChanged = false;
 
     painter->restore();
 }
 
+void Overlay::renderCachedChunks(QPainter *painter, const QRectF &rect, qreal scaleX, qreal scaleY) {
+    if (scaleX != this->chunkScaleX || scaleY != this->chunkScaleY || this->opacity != this->chunkOpacity) {
+        // Chunks are rendered at the size they're displayed, so they're rendered again when the zoom level changes.
+        // The layer's opacity is applied to each item as it's rendered (rather than to the whole chunk), so that the result
+        // is the same as painting the items directly.
+        this->chunkCache.clear();
+        this->chunkScaleX = scaleX;
+        this->chunkScaleY = scaleY;
+        this->chunkOpacity = this->opacity;
+    }
+
+    const QRect chunkRange = getCellRange(rect, chunkSize);
+    const int chunkCost = qMax(1, qCeil(chunkSize * scaleX) * qCeil(chunkSize * scaleY) * 4 / 1024);
+    if (getCellCount(chunkRange) * chunkCost > maxChunkCacheKB) {
+        // The visible chunks wouldn't fit in the cache, so they'd have to be rendered every time anyway.
+        painter->setOpacity(this->opacity);
+        for (int index : getItemsInRect(rect)) {
+            if (this->itemBounds.at(index).intersects(rect))
+                this->items.at(index)->render(painter);
+        }
+        return;
+    }
+    this->chunkCache.setMaxCost(maxChunkCacheKB);
+
+    for (int y = chunkRange.top(); y <= chunkRange.bottom(); y++)
+    for (int x = chunkRange.left(); x <= chunkRange.right(); x++) {
+        const QRectF chunkRect(x * chunkSize, y * chunkSize, chunkSize, chunkSize);
+        const quint64 key = cellKey(x, y);
+        QPixmap pixmap;
+        if (const QPixmap *cachedPixmap = this->chunkCache.object(key)) {
+            pixmap = *cachedPixmap;
+        } else {
+            pixmap = renderChunk(chunkRect, scaleX, scaleY, painter->renderHints());
+            // Empty chunks are cached too, so that they don't need to be checked again.
+            this->chunkCache.insert(key, new QPixmap(pixmap), pixmap.isNull() ? 1 : chunkCost);
+        }
+        if (!pixmap.isNull())
+            painter->drawPixmap(chunkRect, pixmap, QRectF(pixmap.rect()));
+    }
+}
+
+QPixmap Overlay::renderChunk(const QRectF &chunkRect, qreal scaleX, qreal scaleY, QPainter::RenderHints hints) {
+    QVector<int> indexes = getItemsInRect(chunkRect);
+    indexes.erase(std::remove_if(indexes.begin(), indexes.end(), [this, &chunkRect](int index) {
+        return !this->itemBounds.at(index).intersects(chunkRect);
+    }), indexes.end());
+    if (indexes.isEmpty())
+        return QPixmap();
+
+    PERF_TRACE("Overlay::renderChunk");
+    QPixmap pixmap(qCeil(chunkRect.width() * scaleX), qCeil(chunkRect.height() * scaleY));
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHints(hints);
+    painter.setOpacity(this->opacity);
+    painter.scale(scaleX, scaleY);
+    painter.translate(-chunkRect.topLeft());
+    painter.setClipRect(chunkRect);
+    for (int index : indexes)
+        this->items.at(index)->render(&painter);
+    return pixmap;
+}
+
+// Returns the indexes of the items that may overlap 'rect', in the order they were added.
+QVector<int> Overlay::getItemsInRect(const QRectF &rect) const {
+    QVector<int> indexes = this->unindexedItems;
+    const QRect cellRange = getCellRange(rect, indexCellSize);
+    if (getCellCount(cellRange) > this->cells.size()) {
+        // Fewer cells are occupied than are in the rect (e.g. when zoomed out), so only check the occupied cells.
+        for (auto it = this->cells.constBegin(); it != this->cells.constEnd(); it++) {
+            const QPoint cell(static_cast<qint32>(it.key() >> 32), static_cast<qint32>(it.key() & 0xFFFFFFFF));
+            if (cellRange.contains(cell))
+                indexes.append(it.value());
+        }
+    } else {
+        for (int y = cellRange.top(); y <= cellRange.bottom(); y++)
+        for (int x = cellRange.left(); x <= cellRange.right(); x++) {
+            auto it = this->cells.constFind(cellKey(x, y));
+            if (it != this->cells.constEnd())
+                indexes.append(it.value());
+        }
+    }
+
+    // Items that overlap several cells were found more than once.
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+    return indexes;
+}
+
+void Overlay::addItem(OverlayItem *item) {
+    const int index = this->items.length();
+    const QRectF bounds = item->boundingRect();
+    this->items.append(item);
+    this->itemBounds.append(bounds);
+    this->itemsChanged = true;
+
+    const QRect cellRange = getCellRange(bounds, indexCellSize);
+    if (getCellCount(cellRange) > maxIndexedCells) {
+        this->unindexedItems.append(index);
+    } else {
+        for (int y = cellRange.top(); y <= cellRange.bottom(); y++)
+        for (int x = cellRange.left(); x <= cellRange.right(); x++)
+            this->cells[cellKey(x, y)].append(index);
+    }
+
+    // Only the chunks that the new item overlaps need to be rendered again.
+    const QRect chunkRange = getCellRange(bounds, chunkSize);
+    if (getCellCount(chunkRange) > this->chunkCache.size()) {
+        this->chunkCache.clear();
+    } else {
+        for (int y = chunkRange.top(); y <= chunkRange.bottom(); y++)
+        for (int x = chunkRange.left(); x <= chunkRange.right(); x++)
+            this->chunkCache.remove(cellKey(x, y));
+    }
+}
+
 void Overlay::clearItems() {
     for (auto item : this->items) {
         delete item;
     }
     this->items.clear();
+    this->itemBounds.clear();
+    this->cells.clear();
+    this->unindexedItems.clear();
+    this->chunkCache.clear();
+    this->itemsChanged = true;
 }
 
 QList<OverlayItem*> Overlay::getItems() {
@@ -169,8 +367,9 @@ QColor Overlay::getColor(QString colorStr) {
     return color;
 }
 
-void Overlay::addText(const QString text, int x, int y, QString colorStr, int fontSize) {
-    this->items.append(new OverlayText(text, x, y, getColor(colorStr), fontSize));
+// The text is painted with 'font' (at the given size), which should be the font of the view it's painted in.
+void Overlay::addText(const QString text, int x, int y, QString colorStr, int fontSize, const QFont &font) {
+    this->addItem(new OverlayText(text, x, y, getColor(colorStr), fontSize, font));
 }
 
 bool Overlay::addRect(int x, int y, int width, int height, QString borderColorStr, QString fillColorStr, int rounding) {
@@ -181,7 +380,7 @@ bool Overlay::addRect(int x, int y, int width, int height, QString borderColorSt
 
     QPainterPath path;
     path.addRoundedRect(QRectF(x, y, width, height), rounding, rounding, Qt::RelativeSize);
-    this->items.append(new OverlayPath(path, getColor(borderColorStr), getColor(fillColorStr)));
+    this->addItem(new OverlayPath(path, getColor(borderColorStr), getColor(fillColorStr)));
     return true;
 }
 
@@ -198,7 +397,7 @@ bool Overlay::addPath(QList<int> xCoords, QList<int> yCoords, QString borderColo
     for (int i = 1; i < numPoints; i++)
         path.lineTo(xCoords.at(i), yCoords.at(i));
 
-    this->items.append(new OverlayPath(path, getColor(borderColorStr), getColor(fillColorStr)));
+    this->addItem(new OverlayPath(path, getColor(borderColorStr), getColor(fillColorStr)));
     return true;
 }
 
@@ -245,7 +444,7 @@ bool Overlay::addImage(int x, int y, QString filepath, bool useCache, int width,
     if (setTransparency)
         image.setColor(0, qRgba(0, 0, 0, 0));
 
-    this->items.append(new OverlayPixmap(x, y, QPixmap::fromImage(image)));
+    this->addItem(new OverlayPixmap(x, y, QPixmap::fromImage(image)));
     return true;
 }
 
@@ -254,7 +453,7 @@ bool Overlay::addImage(int x, int y, QImage image) {
         logError(QString("Failed to load custom image"));
         return false;
     }
-    this->items.append(new OverlayPixmap(x, y, QPixmap::fromImage(image)));
+    this->addItem(new OverlayPixmap(x, y, QPixmap::fromImage(image)));
     return true;
 }
 
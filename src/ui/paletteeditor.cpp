@@ -235,11 +235,10 @@ QSet<int> PaletteEditor::getUnusedColorIds() {
     this->unusedColorCache[paletteId] = {};
 
     // Check our current tilesets for color usage.
-    QSet<int> unusedColorIds = this->primaryTileset->getUnusedColorIds(paletteId, this->secondaryTileset);
-    if (unusedColorIds.isEmpty())
-        return {};
-    unusedColorIds = this->secondaryTileset->getUnusedColorIds(paletteId, this->primaryTileset, unusedColorIds);
-    if (unusedColorIds.isEmpty())
+    const uint16_t allColors = (1 << Tileset::numColorsPerPalette()) - 1;
+    uint16_t usedColors = this->primaryTileset->getUsedColorsMask(paletteId, this->secondaryTileset)
+                        | this->secondaryTileset->getUsedColorsMask(paletteId, this->primaryTileset);
+    if (usedColors == allColors)
         return {};
 
     // The current palette comes from either the primary or secondary tileset.
@@ -255,11 +254,16 @@ QSet<int> PaletteEditor::getUnusedColorIds() {
     for (const auto &label : tilesetsToSearch) {
         Tileset *searchTileset = this->project->getTileset(label);
         if (!searchTileset) continue;
-        unusedColorIds = searchTileset->getUnusedColorIds(paletteId, paletteTileset, unusedColorIds);
-        if (unusedColorIds.isEmpty())
+        usedColors |= searchTileset->getUsedColorsMask(paletteId, paletteTileset);
+        if (usedColors == allColors)
             return {};
     }
 
+    QSet<int> unusedColorIds;
+    for (int i = 0; i < Tileset::numColorsPerPalette(); i++) {
+        if (!(usedColors & (1 << i)))
+            unusedColorIds.insert(i);
+    }
     this->unusedColorCache[paletteId] = unusedColorIds;
     return unusedColorIds;
 }
@@ -0,0 +1,152 @@
+#include "perftracepanel.h"
+#include "perftrace.h"
+#include "filedialog.h"
+#include "message.h"
+#include "log.h"
+
+#include <QCheckBox>
+#include <QDateTime>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+// How often the summary is refreshed while the panel is visible and recording.
+static const int refreshIntervalMs = 1000;
+
+// Times are shown in milliseconds, rounded to 2 decimal places. They're set as numbers (rather than text) so that the columns sort numerically.
+static QTableWidgetItem *createTimeItem(qint64 nsecs) {
+    auto item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, qRound64(nsecs / 10000.0) / 100.0);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+static QTableWidgetItem *createCountItem(qint64 count) {
+    auto item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, count);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+PerfTracePanel::PerfTracePanel(QWidget *parent) :
+    QDockWidget(QStringLiteral("Performance Trace"), parent)
+{
+    setObjectName(QStringLiteral("dockWidget_PerfTrace"));
+
+    auto contents = new QWidget(this);
+    auto layout = new QVBoxLayout(contents);
+
+    auto toolbar = new QHBoxLayout();
+    m_recordCheckBox = new QCheckBox(QStringLiteral("Record"), contents);
+    m_recordCheckBox->setToolTip(QStringLiteral("Record how long porymap spends loading, rendering, exporting, and running scripts. "
+                                                "Recording has a small cost, so leave this off when you aren't measuring anything."));
+    m_recordCheckBox->setChecked(PerfTrace::isEnabled());
+    connect(m_recordCheckBox, &QCheckBox::toggled, this, &PerfTracePanel::setRecording);
+    toolbar->addWidget(m_recordCheckBox);
+
+    auto clearButton = new QPushButton(QStringLiteral("Clear"), contents);
+    connect(clearButton, &QPushButton::clicked, this, &PerfTracePanel::clear);
+    toolbar->addWidget(clearButton);
+
+    auto exportButton = new QPushButton(QStringLiteral("Export Trace..."), contents);
+    exportButton->setToolTip(QStringLiteral("Save the recorded trace as JSON, which can be opened in chrome://tracing or https://ui.perfetto.dev"));
+    connect(exportButton, &QPushButton::clicked, this, &PerfTracePanel::exportTrace);
+    toolbar->addWidget(exportButton);
+
+    m_statusLabel = new QLabel(contents);
+    toolbar->addWidget(m_statusLabel, 1);
+    layout->addLayout(toolbar);
+
+    m_table = new QTableWidget(0, 5, contents);
+    m_table->setHorizontalHeaderLabels({"Name", "Count", "Total (ms)", "Average (ms)", "Max (ms)"});
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->horizontalHeader()->setSectionResizeMode(SummaryColumn::Name, QHeaderView::Stretch);
+    m_table->setSortingEnabled(true);
+    m_table->sortByColumn(SummaryColumn::Total, Qt::DescendingOrder);
+    layout->addWidget(m_table);
+
+    setWidget(contents);
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(refreshIntervalMs);
+    connect(m_refreshTimer, &QTimer::timeout, this, &PerfTracePanel::refresh);
+}
+
+void PerfTracePanel::showEvent(QShowEvent *event) {
+    QDockWidget::showEvent(event);
+    refresh();
+    if (PerfTrace::isEnabled())
+        m_refreshTimer->start();
+}
+
+void PerfTracePanel::hideEvent(QHideEvent *event) {
+    QDockWidget::hideEvent(event);
+    m_refreshTimer->stop();
+}
+
+void PerfTracePanel::setRecording(bool recording) {
+    PerfTrace::setEnabled(recording);
+    if (recording && isVisible()) {
+        m_refreshTimer->start();
+    } else {
+        m_refreshTimer->stop();
+    }
+    logInfo(QString("%1 performance trace.").arg(recording ? "Started" : "Stopped"));
+    refresh();
+}
+
+void PerfTracePanel::clear() {
+    PerfTrace::clear();
+    refresh();
+}
+
+void PerfTracePanel::refresh() {
+    const QList<PerfTrace::Summary> summaries = PerfTrace::summary();
+
+    // Sorting while inserting would move rows out from under us.
+    m_table->setSortingEnabled(false);
+    m_table->setRowCount(0);
+    for (const auto &summary : summaries) {
+        const int row = m_table->rowCount();
+        m_table->insertRow(row);
+        m_table->setItem(row, SummaryColumn::Name, new QTableWidgetItem(summary.name));
+        m_table->setItem(row, SummaryColumn::Count, createCountItem(summary.count));
+        if (summary.isCounter) {
+            // Counters have a total, but no time.
+            m_table->setItem(row, SummaryColumn::Total, createCountItem(summary.value));
+        } else {
+            m_table->setItem(row, SummaryColumn::Total, createTimeItem(summary.totalNsecs));
+            m_table->setItem(row, SummaryColumn::Average, createTimeItem(summary.count ? summary.totalNsecs / summary.count : 0));
+            m_table->setItem(row, SummaryColumn::Max, createTimeItem(summary.maxNsecs));
+        }
+    }
+    m_table->setSortingEnabled(true);
+
+    QString status = PerfTrace::isEnabled() ? QStringLiteral("Recording") : QStringLiteral("Not recording");
+    const int numDropped = PerfTrace::numDroppedEvents();
+    if (numDropped > 0)
+        status.append(QString(" (trace is full, %1 events only included in the summary)").arg(numDropped));
+    m_statusLabel->setText(status);
+}
+
+void PerfTracePanel::exportTrace() {
+    const QString defaultFilepath = QString("%1/porymap_trace_%2.json")
+                                        .arg(FileDialog::getDirectory())
+                                        .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+    const QString filepath = FileDialog::getSaveFileName(this, QStringLiteral("Export Performance Trace"), defaultFilepath, QStringLiteral("Trace Files (*.json)"));
+    if (filepath.isEmpty())
+        return;
+
+    QString error;
+    if (!PerfTrace::exportChromeTrace(filepath, &error)) {
+        ErrorMessage::show(QStringLiteral("Failed to export performance trace."), QString("Could not write to '%1': %2").arg(filepath).arg(error), this);
+        return;
+    }
+    logInfo(QString("Exported performance trace to '%1'").arg(filepath));
+}
@@ -0,0 +1,115 @@
+#include "pixmapchunkcache.h"
+
+#include <QPainter>
+#include <QPaintDevice>
+#include <algorithm>
+
+PixmapChunkCache::PixmapChunkCache(int chunkSize, qint64 maxBytes)
+    : m_chunkSize(qMax(chunkSize, 1)),
+      m_maxBytes(maxBytes)
+{}
+
+// Returns the mipmap level appropriate for the painter's current scale. Each level is half the size of the previous level.
+int PixmapChunkCache::mipLevel(const QPainter *painter) {
+    const QTransform transform = painter->worldTransform();
+    qreal scale = qMin(qAbs(transform.m11()), qAbs(transform.m22()));
+    if (painter->device())
+        scale *= painter->device()->devicePixelRatioF();
+
+    int level = 0;
+    while (level < MaxMipLevel && scale * (2 << level) <= 1.0) {
+        level++;
+    }
+    return level;
+}
+
+QImage PixmapChunkCache::downsample(const QImage &image, int level) {
+    if (level <= 0 || image.isNull())
+        return image;
+    const int factor = 1 << level;
+    const QSize size((image.width() + factor - 1) / factor, (image.height() + factor - 1) / factor);
+    return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+void PixmapChunkCache::paint(QPainter *painter, const QImage &source, const QRectF &exposedRect,
+                             const std::function<void(const QRect &)> &prepareSource) {
+    if (source.size() != m_sourceSize) {
+        clear();
+        m_sourceSize = source.size();
+    }
+
+    const QRect area = exposedRect.toAlignedRect() & source.rect();
+    if (area.isEmpty())
+        return;
+
+    // Regardless of mipmap level each chunk has the same size, so chunks at higher levels cover more of the source image.
+    const int level = mipLevel(painter);
+    const int span = m_chunkSize << level;
+
+    m_paintCount++;
+    for (int row = area.top() / span; row <= area.bottom() / span; row++)
+    for (int column = area.left() / span; column <= area.right() / span; column++) {
+        const QRect sourceRect = QRect(column * span, row * span, span, span) & source.rect();
+        Chunk &chunk = m_chunks[chunkKey(level, column, row)];
+        if (chunk.pixmap.isNull()) {
+            if (prepareSource)
+                prepareSource(sourceRect);
+            chunk.pixmap = QPixmap::fromImage(downsample(source.copy(sourceRect), level));
+            m_cachedBytes += pixmapBytes(chunk.pixmap);
+        }
+        chunk.lastPainted = m_paintCount;
+        if (level == 0) {
+            painter->drawPixmap(sourceRect.topLeft(), chunk.pixmap);
+        } else {
+            painter->drawPixmap(QRectF(sourceRect), chunk.pixmap, QRectF(chunk.pixmap.rect()));
+        }
+    }
+
+    if (m_cachedBytes > m_maxBytes)
+        evict();
+}
+
+// Discard any chunks that overlap the given area of the source image. They'll be recreated the next time they're painted.
+void PixmapChunkCache::invalidate(const QRect &rect) {
+    const QRect area = rect & QRect(QPoint(0, 0), m_sourceSize);
+    if (area.isEmpty() || m_chunks.isEmpty())
+        return;
+
+    for (int level = 0; level <= MaxMipLevel; level++) {
+        const int span = m_chunkSize << level;
+        for (int row = area.top() / span; row <= area.bottom() / span; row++)
+        for (int column = area.left() / span; column <= area.right() / span; column++) {
+            removeChunk(chunkKey(level, column, row));
+        }
+    }
+}
+
+void PixmapChunkCache::clear() {
+    m_chunks.clear();
+    m_cachedBytes = 0;
+}
+
+void PixmapChunkCache::removeChunk(quint64 key) {
+    auto it = m_chunks.find(key);
+    if (it == m_chunks.end())
+        return;
+    m_cachedBytes -= pixmapBytes(it.value().pixmap);
+    m_chunks.erase(it);
+}
+
+// Remove the least recently painted chunks until the cache is back under budget.
+// Chunks painted most recently are still on screen, so they're never evicted (even if that means staying over budget).
+void PixmapChunkCache::evict() {
+    QList<QPair<quint64, quint64>> candidates;
+    for (auto it = m_chunks.constBegin(); it != m_chunks.constEnd(); it++) {
+        if (it.value().lastPainted < m_paintCount)
+            candidates.append(qMakePair(it.value().lastPainted, it.key()));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto &candidate : candidates) {
+        if (m_cachedBytes <= m_maxBytes)
+            break;
+        removeChunk(candidate.second);
+    }
+}
@@ -108,7 +108,7 @@ void ProjectSettingsEditor::initUi() {
     if (project) {
         ui->comboBox_DefaultPrimaryTileset->addItems(project->primaryTilesetLabels);
         ui->comboBox_DefaultSecondaryTileset->addItems(project->secondaryTilesetLabels);
-        ui->comboBox_IconSpecies->addItems(project->speciesNames);
+        ui->comboBox_IconSpecies->setConstantsModel(project->getConstantsModel(Project::Constants::Species));
         ui->comboBox_WarpBehaviors->addItems(project->metatileBehaviorMap.keys());
     }
     ui->comboBox_BaseGameVersion->addItems(ProjectConfig::versionStrings);
@@ -92,7 +92,9 @@ void ResizeLayoutPopup::setupLayoutView() {
     this->ui->spinBox_borderHeight->setValue(this->layout->getBorderHeight());
 
     // Layout stuff
-    this->layoutPixmap = new BoundedPixmapItem(this->layout->pixmap, Metatile::pixelSize());
+    // The map view only draws the parts of the layout image that have been in view, so make sure all of it is drawn.
+    this->layout->renderImage();
+    this->layoutPixmap = new BoundedPixmapItem(QPixmap::fromImage(this->layout->image), Metatile::pixelSize());
     this->scene->addItem(layoutPixmap);
     int maxWidth = this->project->getMaxMapWidth();
     int maxHeight = this->project->getMaxMapHeight();
@@ -12,9 +12,15 @@
 #include "eventfilters.h"
 #include "utility.h"
 #include "message.h"
+#include "tilecompactor.h"
+#include "metatilededuplicator.h"
+#include "tilequantizer.h"
 #include <QDialogButtonBox>
 #include <QCloseEvent>
 #include <QImageReader>
+#include <QInputDialog>
+#include <QThread>
+#include <future>
 
 TilesetEditor::TilesetEditor(Project *project, Layout *layout, QWidget *parent) :
     QMainWindow(parent),
@@ -142,9 +148,7 @@ void TilesetEditor::initAttributesUi() {
 
     // Behavior
     if (projectConfig.metatileBehaviorMask) {
-        for (auto i = project->metatileBehaviorMapInverse.constBegin(); i != project->metatileBehaviorMapInverse.constEnd(); i++) {
-            this->ui->comboBox_MetatileBehaviors->addItem(i.value(), i.key());
-        }
+        this->ui->comboBox_MetatileBehaviors->setConstantsModel(project->getConstantsModel(Project::Constants::MetatileBehaviors));
         this->ui->comboBox_MetatileBehaviors->setMinimumContentsLength(0);
     } else {
         this->ui->frame_MetatileBehavior->setVisible(false);
@@ -741,7 +745,7 @@ bool TilesetEditor::save() {
     this->lockSelection = true;
 
     bool success = this->project->saveTilesets(this->primaryTileset, this->secondaryTileset);
-    applyMetatileSwapsToLayouts();
+    applyMetatileIdRemapsToLayouts();
     emit this->tilesetsSaved(this->primaryTileset->name, this->secondaryTileset->name);
     if (this->paletteEditor) {
         this->paletteEditor->setTilesets(this->primaryTileset, this->secondaryTileset);
@@ -803,13 +807,21 @@ void TilesetEditor::importTilesetTiles(Tileset *tileset) {
         return;
     }
 
-    // Ask user to provide a palette for the un-indexed image.
+    // Ask user how to convert the un-indexed image.
     if (image.colorCount() == 0) {
-        auto msgBox = new QuestionMessage(QStringLiteral("Select a palette file for this image?"), this);
-        msgBox->setAttribute(Qt::WA_DeleteOnClose);
-        msgBox->setInformativeText(QStringLiteral("The provided image is not indexed. "
-                                                  "An indexed image will be generated using the provided image and palette."));
-        if (msgBox->exec() != QMessageBox::Yes)
+        QuestionMessage msgBox(QStringLiteral("The provided image is not indexed."), this);
+        msgBox.setInformativeText(QStringLiteral("Palettes for this tileset can be generated from the image's colors, "
+                                                 "or an indexed image can be generated using the provided image and an existing palette."));
+        msgBox.setStandardButtons(QMessageBox::Cancel);
+        QPushButton *generateButton = msgBox.addButton(QStringLiteral("Generate Palettes..."), QMessageBox::AcceptRole);
+        QPushButton *selectButton = msgBox.addButton(QStringLiteral("Select Palette..."), QMessageBox::AcceptRole);
+        msgBox.setDefaultButton(generateButton);
+        msgBox.exec();
+        if (msgBox.clickedButton() == generateButton) {
+            importQuantizedTilesetTiles(tileset, image);
+            return;
+        }
+        if (msgBox.clickedButton() != selectButton)
             return;
 
         QString filepath = FileDialog::getOpenFileName(this, "Select Palette for Tiles Image", "", "Palette Files (*.pal *.act *tpl *gpl)");
@@ -836,6 +848,71 @@ void TilesetEditor::importTilesetTiles(Tileset *tileset) {
     this->hasUnsavedChanges = true;
 }
 
+// Generates palettes for an un-indexed tiles image, then imports the image using those palettes.
+// The tileset's metatiles are updated to use the palette that was chosen for each tile.
+void TilesetEditor::importQuantizedTilesetTiles(Tileset *tileset, const QImage &image) {
+    const int firstPaletteId = tileset->is_secondary ? Project::getNumPalettesPrimary() : 0;
+    const int maxPalettes = tileset->is_secondary ? Project::getNumPalettesSecondary() : Project::getNumPalettesPrimary();
+    bool ok = false;
+    const int numPalettes = QInputDialog::getInt(this, QStringLiteral("Generate Palettes"),
+                                                 QString("Number of palettes to generate. Palettes %1 to %2 may be replaced.")
+                                                        .arg(firstPaletteId)
+                                                        .arg(firstPaletteId + maxPalettes - 1),
+                                                 maxPalettes, 1, maxPalettes, 1, &ok);
+    if (!ok)
+        return;
+
+    // Keep the tileset's current transparent color.
+    const QRgb transparentColor = tileset->palettes.value(firstPaletteId).value(0);
+
+    // Images without an alpha channel often mark their background with the color of the top-left pixel, but that pixel
+    // may also just be part of a tile. Every pixel of that color would become transparent, so ask rather than assume.
+    bool topLeftIsTransparent = false;
+    if (!image.isNull()) {
+        const QRgb topLeft = image.pixel(0, 0);
+        if (qAlpha(topLeft) >= 128 && (topLeft & 0xF8F8F8) != (transparentColor & 0xF8F8F8)) {
+            topLeftIsTransparent = QuestionMessage::show(QString("Treat the color of the image's top-left pixel (%1) as transparent?")
+                                                                .arg(QColor(topLeft).name()), this) == QMessageBox::Yes;
+        }
+    }
+    const TileQuantizer::Result result = TileQuantizer::quantize(image, numPalettes, transparentColor, topLeftIsTransparent);
+
+    QImage tilesImage = result.image;
+    if (!tileset->loadTilesImage(&tilesImage)) {
+        RecentErrorMessage::show(QStringLiteral("Failed to import tiles."), this);
+        return;
+    }
+    for (int i = 0; i < result.palettes.length(); i++) {
+        const int paletteId = firstPaletteId + i;
+        if (paletteId < tileset->palettes.length())
+            tileset->palettes[paletteId] = result.palettes.at(i);
+        if (paletteId < tileset->palettePreviews.length())
+            tileset->palettePreviews[paletteId] = result.palettes.at(i);
+    }
+    for (Tileset *metatileTileset : {this->primaryTileset, this->secondaryTileset}) {
+        for (int i = 0; i < metatileTileset->numMetatiles(); i++) {
+            Metatile *metatile = Tileset::getMetatile(metatileTileset->firstMetatileId() + i, this->primaryTileset, this->secondaryTileset);
+            if (!metatile) continue;
+            for (auto &tile : metatile->tiles) {
+                const int tileIndex = tile.tileId - tileset->firstTileId();
+                if (tileset->containsTileId(tile.tileId) && tileIndex < result.tilePalettes.length())
+                    tile.palette = firstPaletteId + result.tilePalettes.at(tileIndex);
+            }
+        }
+    }
+    if (!result.isLossless)
+        logWarn(QString("The colors of some tiles in '%1' were changed to fit them into %2 palettes.").arg(tileset->name).arg(numPalettes));
+
+    // The edit history doesn't include tile or palette changes, so undoing an older metatile change would restore the old palettes.
+    this->metatileHistory.clear();
+    updateEditHistoryActions();
+
+    if (this->paletteEditor)
+        this->paletteEditor->setTilesets(this->primaryTileset, this->secondaryTileset);
+    this->refresh();
+    this->hasUnsavedChanges = true;
+}
+
 void TilesetEditor::closeEvent(QCloseEvent *event)
 {
     // If focus is still on any input widgets, a user may have made changes
@@ -905,6 +982,7 @@ void TilesetEditor::on_actionChange_Metatiles_Count_triggered()
         if (tileset && !tileset->containsMetatileId(metatileId)) {
             this->metatileSelector->select(qBound(tileset->firstMetatileId(), metatileId, tileset->lastMetatileId()));
         }
+        this->metatile = Tileset::getMetatile(this->getSelectedMetatileId(), this->primaryTileset, this->secondaryTileset);
 
         refresh();
         this->hasUnsavedChanges = true;
@@ -984,6 +1062,8 @@ void TilesetEditor::on_actionUndo_triggered() {
 
     if (commit->isSwap) {
         swapMetatiles(commit->swapMetatileId, commit->metatileId);
+    } else if (commit->isMerge) {
+        setMetatilesMerged(commit, false);
     } else if (commit->prevMetatile) {
         replaceMetatile(commit->metatileId, *commit->prevMetatile, commit->prevLabel);
     };
@@ -996,6 +1076,8 @@ void TilesetEditor::on_actionRedo_triggered() {
 
     if (commit->isSwap) {
         swapMetatiles(commit->metatileId, commit->swapMetatileId);
+    } else if (commit->isMerge) {
+        setMetatilesMerged(commit, true);
     } else if (commit->newMetatile) {
         replaceMetatile(commit->metatileId, *commit->newMetatile, commit->newLabel);
     }
@@ -1123,10 +1205,9 @@ void TilesetEditor::importAdvanceMapMetatiles(Tileset *tileset) {
     }
 
     bool error = false;
-    QList<Metatile*> metatiles = AdvanceMapParser::parseMetatiles(filepath, &error, primary);
+    QList<Metatile> metatiles = AdvanceMapParser::parseMetatiles(filepath, &error, primary);
     if (error) {
         RecentErrorMessage::show(QStringLiteral("Failed to import metatiles from Advance Map 1.92 .bvd file."), this);
-        qDeleteAll(metatiles);
         return;
     }
 
@@ -1142,11 +1223,12 @@ void TilesetEditor::importAdvanceMapMetatiles(Tileset *tileset) {
         QString prevLabel = Tileset::getOwnedMetatileLabel(metatileId, this->primaryTileset, this->secondaryTileset);
         Metatile *prevMetatile = new Metatile(*tileset->metatileAt(i));
         commit(new MetatileHistoryItem(metatileId,
-                                       prevMetatile, new Metatile(*metatiles.at(i)),
+                                       prevMetatile, new Metatile(metatiles.at(i)),
                                        prevLabel, prevLabel));
     }
 
     tileset->setMetatiles(metatiles);
+    this->metatile = Tileset::getMetatile(this->getSelectedMetatileId(), this->primaryTileset, this->secondaryTileset);
     this->refresh();
 }
 
@@ -1253,7 +1335,7 @@ void TilesetEditor::countTileUsage() {
         }
         for (const auto &tileset : tilesets) {
             for (const auto &metatile : tileset->metatiles()) {
-                for (const auto &tile : metatile->tiles) {
+                for (const auto &tile : metatile.tiles) {
                     if (searchTileset->containsTileId(tile.tileId)) {
                         this->tileSelector->usedTiles[tile.tileId]++;
                     }
@@ -1266,6 +1348,93 @@ void TilesetEditor::countTileUsage() {
     countTilesetTileUsage(this->secondaryTileset);
 }
 
+// Returns true if moving 'tileset's tiles would change metatiles that the Tileset Editor can't update, i.e. the metatiles
+// of other tilesets it's paired with, or the metatiles of the tileset it's being edited with if that tileset has other pairings.
+bool TilesetEditor::tilesUsedOutsideEditor(const Tileset *tileset) {
+    const Tileset *editedPair = tileset->is_secondary ? this->primaryTileset : this->secondaryTileset;
+    auto usesTiles = [tileset](const Tileset *other) {
+        for (const auto &metatile : other->metatiles()) {
+            for (const auto &tile : metatile.tiles) {
+                if (tileset->containsTileId(tile.tileId))
+                    return true;
+            }
+        }
+        return false;
+    };
+
+    QSet<QString> tilesetNames = this->project->getPairedTilesetLabels(tileset);
+    tilesetNames.remove(editedPair->name);
+    for (const auto &tilesetName : tilesetNames) {
+        const Tileset *other = this->project->getTileset(tilesetName);
+        if (other && usesTiles(other))
+            return true;
+    }
+
+    QSet<QString> pairedTilesetNames = this->project->getPairedTilesetLabels(editedPair);
+    pairedTilesetNames.remove(tileset->name);
+    return !pairedTilesetNames.isEmpty() && usesTiles(editedPair);
+}
+
+void TilesetEditor::on_actionCompact_Tiles_triggered() {
+    TileCompactor::Options options;
+    options.compactPrimary = !tilesUsedOutsideEditor(this->primaryTileset);
+    options.compactSecondary = !tilesUsedOutsideEditor(this->secondaryTileset);
+
+    // Secondary tiles can only be replaced with primary tiles if the secondary tileset is always loaded with this primary tileset.
+    QSet<QString> pairedTilesetNames = this->project->getPairedTilesetLabels(this->secondaryTileset);
+    pairedTilesetNames.remove(this->primaryTileset->name);
+    options.mergeSecondaryIntoPrimary = pairedTilesetNames.isEmpty();
+
+    // The tiles used to fill the third layer of dual-layer metatiles are specified by their ID in the project settings.
+    if (!projectConfig.tripleLayerMetatilesEnabled) {
+        for (const auto &tileValue : {projectConfig.unusedTileNormal, projectConfig.unusedTileCovered, projectConfig.unusedTileSplit}) {
+            options.pinnedTileIds.insert(Tile(tileValue).tileId);
+        }
+    }
+
+    const TileCompactor compactor(this->primaryTileset, this->secondaryTileset, options);
+
+    QStringList notes;
+    if (!options.compactPrimary)
+        notes.append(QString("Duplicate tiles in '%1' can't be removed, because its tiles are used by metatiles in other tilesets.").arg(this->primaryTileset->name));
+    if (!options.compactSecondary)
+        notes.append(QString("Duplicate tiles in '%1' can't be removed, because its tiles are used by metatiles in other tilesets.").arg(this->secondaryTileset->name));
+
+    if (compactor.numReclaimedTiles() == 0) {
+        InfoMessage::show(QStringLiteral("No duplicate tiles were found."), notes.join("\n"), this);
+        return;
+    }
+
+    QString message = QString("Found %1 duplicate tile(s), including flipped copies (%2 in '%3', %4 in '%5').\n\n"
+                              "Remove them, and update the metatiles to use the remaining tiles? "
+                              "This can't be undone, and clears the Tileset Editor's edit history.")
+                              .arg(compactor.numReclaimedTiles())
+                              .arg(compactor.numReclaimedTiles(this->primaryTileset))
+                              .arg(this->primaryTileset->name)
+                              .arg(compactor.numReclaimedTiles(this->secondaryTileset))
+                              .arg(this->secondaryTileset->name);
+    if (!notes.isEmpty())
+        message.append("\n\n" + notes.join("\n"));
+    if (QuestionMessage::show(message, this) != QMessageBox::Yes)
+        return;
+
+    compactor.apply(this->primaryTileset, this->secondaryTileset);
+    compactor.remap(this->copiedMetatile);
+    logInfo(QString("Removed %1 duplicate tiles from '%2' and %3 duplicate tiles from '%4'.")
+                    .arg(compactor.numReclaimedTiles(this->primaryTileset))
+                    .arg(this->primaryTileset->name)
+                    .arg(compactor.numReclaimedTiles(this->secondaryTileset))
+                    .arg(this->secondaryTileset->name));
+
+    // The edit history refers to tiles by their old IDs.
+    this->metatileHistory.clear();
+    updateEditHistoryActions();
+
+    this->metatile = Tileset::getMetatile(this->getSelectedMetatileId(), this->primaryTileset, this->secondaryTileset);
+    this->refresh();
+    this->hasUnsavedChanges = true;
+}
+
 void TilesetEditor::on_copyButton_MetatileLabel_clicked() {
     uint16_t metatileId = this->getSelectedMetatileId();
     QString label = Tileset::getMetatileLabel(metatileId, this->primaryTileset, this->secondaryTileset);
@@ -1359,89 +1528,176 @@ bool TilesetEditor::swapMetatiles(uint16_t metatileIdA, uint16_t metatileIdB) {
 
     // Record this swap so that we can update the layouts later.
     // If this is the inverse of the most recent swap (e.g. from Undo), we instead remove that swap to save time.
-    if (!this->metatileIdSwaps.isEmpty()) {
-        auto recentSwapPair = this->metatileIdSwaps.constLast();
-        if (recentSwapPair.first == metatileIdB && recentSwapPair.second == metatileIdA) {
-            this->metatileIdSwaps.removeLast();
-            return true;
-        }
+    QMap<uint16_t, uint16_t> remap;
+    remap.insert(metatileIdA, metatileIdB);
+    remap.insert(metatileIdB, metatileIdA);
+    if (!this->metatileIdRemaps.isEmpty() && this->metatileIdRemaps.constLast() == remap) {
+        this->metatileIdRemaps.removeLast();
+    } else {
+        this->metatileIdRemaps.append(remap);
     }
-    this->metatileIdSwaps.append(QPair<uint16_t,uint16_t>(metatileIdA, metatileIdB));
     return true;
 }
 
-// If any metatiles swapped positions, apply the swap to all relevant layouts.
+void TilesetEditor::setMetatilesMerged(const MetatileHistoryItem *item, bool merged) {
+    const Metatile emptyMetatile(projectConfig.getNumTilesInMetatile());
+    for (auto it = item->mergedMetatiles.constBegin(); it != item->mergedMetatiles.constEnd(); it++) {
+        const uint16_t metatileId = it.key();
+        replaceMetatile(metatileId, merged ? emptyMetatile : it.value(),
+                        Tileset::getOwnedMetatileLabel(metatileId, this->primaryTileset, this->secondaryTileset));
+    }
+
+    // Layouts are only updated once the tilesets are saved. If the merge is undone before then we can just forget it.
+    // Otherwise the layouts already use the remaining metatiles, which look the same, so they're left as-is.
+    if (merged) {
+        this->metatileIdRemaps.append(item->mergedMetatileIds);
+    } else if (!this->metatileIdRemaps.isEmpty() && this->metatileIdRemaps.constLast() == item->mergedMetatileIds) {
+        this->metatileIdRemaps.removeLast();
+    }
+}
+
+void TilesetEditor::on_actionMerge_Duplicate_Metatiles_triggered() {
+    MetatileDeduplicator::Options options;
+
+    // Secondary metatiles can only be replaced with primary metatiles if the secondary tileset is always loaded with this primary tileset.
+    QSet<QString> pairedTilesetNames = this->project->getPairedTilesetLabels(this->secondaryTileset);
+    pairedTilesetNames.remove(this->primaryTileset->name);
+    options.mergeSecondaryIntoPrimary = pairedTilesetNames.isEmpty();
+
+    // Labeled metatiles may be used by ID in the project's source code.
+    for (const Tileset *tileset : {this->primaryTileset, this->secondaryTileset}) {
+        for (auto it = tileset->metatileLabels.constBegin(); it != tileset->metatileLabels.constEnd(); it++) {
+            if (!it.value().isEmpty())
+                options.pinnedMetatileIds.insert(it.key());
+        }
+    }
+
+    const QMap<uint16_t, uint16_t> duplicates = MetatileDeduplicator::findDuplicates(this->primaryTileset, this->secondaryTileset, options);
+    if (duplicates.isEmpty()) {
+        InfoMessage::show(QStringLiteral("No duplicate metatiles were found."), this);
+        return;
+    }
+
+    const QSet<QString> layoutIds = this->project->getTilesetLayoutIds(this->primaryTileset, nullptr)
+                                  + this->project->getTilesetLayoutIds(nullptr, this->secondaryTileset);
+    QString message = QString("Found %1 metatile(s) with the same tiles and attributes as another metatile.\n\n"
+                              "Replace them with the other metatile in all %2 layout(s) that use these tilesets, and clear the duplicates? "
+                              "The layouts will be updated when the tilesets are saved.")
+                              .arg(duplicates.size())
+                              .arg(layoutIds.size());
+    if (QuestionMessage::show(message, this) != QMessageBox::Yes)
+        return;
+
+    QMap<uint16_t, Metatile> mergedMetatiles;
+    for (auto it = duplicates.constBegin(); it != duplicates.constEnd(); it++) {
+        const Metatile *metatile = Tileset::getMetatile(it.key(), this->primaryTileset, this->secondaryTileset);
+        if (metatile) mergedMetatiles.insert(it.key(), *metatile);
+    }
+    auto item = new MetatileHistoryItem(duplicates, mergedMetatiles);
+    setMetatilesMerged(item, true);
+    commit(item);
+    logInfo(QString("Merged %1 duplicate metatiles: %2").arg(duplicates.size()).arg(Metatile::getMetatileIdStrings(duplicates.keys())));
+}
+
+// Returns the metatile IDs that each metatile ID should be changed to in a layout, after applying the given changes in order.
+// A metatile ID is only changed in layouts that use the tilesets of both the old and new metatile, so this depends
+// on whether the layout uses the primary tileset, the secondary tileset, or both.
+static std::vector<uint16_t> buildMetatileIdTable(const QList<QMap<uint16_t, uint16_t>> &remaps,
+                                                  const Tileset *primaryTileset, const Tileset *secondaryTileset,
+                                                  bool usesPrimary, bool usesSecondary) {
+    auto isUsed = [=](uint16_t metatileId) {
+        if (primaryTileset->containsMetatileId(metatileId)) return usesPrimary;
+        if (secondaryTileset->containsMetatileId(metatileId)) return usesSecondary;
+        return false;
+    };
+
+    std::vector<uint16_t> table(Project::getNumMetatilesTotal());
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i] = static_cast<uint16_t>(i);
+    }
+    for (const auto &remap : remaps) {
+        for (auto &metatileId : table) {
+            auto it = remap.constFind(metatileId);
+            if (it != remap.constEnd() && isUsed(it.key()) && isUsed(it.value()))
+                metatileId = it.value();
+        }
+    }
+    return table;
+}
+
+// Changes the metatile IDs in the layout's map and border data. Returns true if anything changed.
+static bool remapLayoutMetatileIds(Layout *layout, const std::vector<uint16_t> &table) {
+    bool changed = false;
+    for (Blockdata *blockdata : {&layout->blockdata, &layout->border}) {
+        for (auto &block : *blockdata) {
+            const uint16_t metatileId = block.metatileId();
+            if (metatileId < table.size() && table[metatileId] != metatileId) {
+                block.setMetatileId(table[metatileId]);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// Updating a layout is quick, so small batches of layouts aren't worth starting a thread for.
+static const size_t minLayoutsPerTask = 16;
+
+// If any metatiles were swapped or merged, apply the changes to all relevant layouts.
 // We only do this once changes in the Tileset Editor are saved.
-void TilesetEditor::applyMetatileSwapsToLayouts() {
-    if (this->metatileIdSwaps.isEmpty())
+void TilesetEditor::applyMetatileIdRemapsToLayouts() {
+    if (this->metatileIdRemaps.isEmpty())
         return;
 
-    QProgressDialog progress("", "", 0, this->metatileIdSwaps.length(), this);
+    const QSet<QString> layoutIds = this->project->getTilesetLayoutIds(this->primaryTileset, nullptr)
+                                  + this->project->getTilesetLayoutIds(nullptr, this->secondaryTileset);
+
+    QProgressDialog progress("Updating metatiles in map layouts...", "", 0, layoutIds.size(), this);
     progress.setAutoClose(true);
     progress.setWindowModality(Qt::WindowModal);
     progress.setModal(true);
     progress.setMinimumDuration(1000);
     progress.setValue(progress.minimum());
 
-    for (const auto &swapPair : this->metatileIdSwaps) {
-        progress.setLabelText(QString("Swapping metatiles %1 and %2 in map layouts...")
-                                        .arg(Metatile::getMetatileIdString(swapPair.first))
-                                        .arg(Metatile::getMetatileIdString(swapPair.second)));
-        applyMetatileSwapToLayouts(swapPair.first, swapPair.second);
+    // Layouts need to be loaded on the main thread, but once they're loaded each one can be updated independently.
+    struct Job {
+        Layout *layout;
+        const std::vector<uint16_t> *table;
+    };
+    std::vector<uint16_t> tables[3];
+    tables[0] = buildMetatileIdTable(this->metatileIdRemaps, this->primaryTileset, this->secondaryTileset, true, false);
+    tables[1] = buildMetatileIdTable(this->metatileIdRemaps, this->primaryTileset, this->secondaryTileset, false, true);
+    tables[2] = buildMetatileIdTable(this->metatileIdRemaps, this->primaryTileset, this->secondaryTileset, true, true);
+    std::vector<Job> jobs;
+    for (const auto &layoutId : layoutIds) {
+        Layout *layout = this->project->loadLayout(layoutId);
         progress.setValue(progress.value() + 1);
+        if (!layout) continue;
+        const bool usesPrimary = (layout->tileset_primary_label == this->primaryTileset->name);
+        const bool usesSecondary = (layout->tileset_secondary_label == this->secondaryTileset->name);
+        jobs.push_back(Job{layout, &tables[usesPrimary && usesSecondary ? 2 : (usesSecondary ? 1 : 0)]});
     }
-    this->metatileIdSwaps.clear();
-}
+    this->metatileIdRemaps.clear();
 
-void TilesetEditor::applyMetatileSwapToLayouts(uint16_t metatileIdA, uint16_t metatileIdB) {
-    struct TilesetPair {
-        Tileset* primary = nullptr;
-        Tileset* secondary = nullptr;
-    };
-    TilesetPair tilesets;
-
-    // Get which tilesets our swapped metatiles belong to.
-    auto addSourceTileset = [this](uint16_t metatileId, TilesetPair *tilesets) {
-        if (this->primaryTileset->containsMetatileId(metatileId)) {
-            tilesets->primary = this->primaryTileset;
-        } else if (this->secondaryTileset->containsMetatileId(metatileId)) {
-            tilesets->secondary = this->secondaryTileset;
-        } else {
-            // Invalid metatile, shouldn't happen
-            this->metatileSelector->removeFromSwapSelection(metatileId);
+    std::vector<char> changed(jobs.size(), false);
+    auto runJobs = [&jobs, &changed](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+            changed[i] = remapLayoutMetatileIds(jobs[i].layout, *jobs[i].table);
         }
     };
-    addSourceTileset(metatileIdA, &tilesets);
-    addSourceTileset(metatileIdB, &tilesets);
-    if (!tilesets.primary && !tilesets.secondary) {
-        return;
+    const size_t numTasks = qBound<size_t>(1, jobs.size() / minLayoutsPerTask, qMax(1, QThread::idealThreadCount()));
+    const size_t jobsPerTask = (jobs.size() + numTasks - 1) / numTasks;
+    std::vector<std::future<void>> tasks;
+    for (size_t start = jobsPerTask; start < jobs.size(); start += jobsPerTask) {
+        tasks.push_back(std::async(std::launch::async, runJobs, start, qMin(start + jobsPerTask, jobs.size())));
+    }
+    runJobs(0, qMin(jobsPerTask, jobs.size()));
+    for (auto &task : tasks) {
+        task.wait();
     }
 
-    // In each layout that uses the appropriate tileset(s), swap the two metatiles.
-    QSet<QString> layoutIds = this->project->getTilesetLayoutIds(tilesets.primary, tilesets.secondary);
-    for (const auto &layoutId : layoutIds) {
-        Layout *layout = this->project->loadLayout(layoutId);
-        if (!layout) continue;
-        // Perform swap(s) in layout's main data.
-        for (int y = 0; y < layout->height; y++)
-        for (int x = 0; x < layout->width; x++) {
-            uint16_t metatileId = layout->getMetatileId(x, y);
-            if (metatileId == metatileIdA) {
-                layout->setMetatileId(x, y, metatileIdB);
-            } else if (metatileId == metatileIdB) {
-                layout->setMetatileId(x, y, metatileIdA);
-            } else continue;
-            layout->hasUnsavedDataChanges = true;
-        }
-        // Perform swap(s) in layout's border data.
-        for (auto &borderBlock : layout->border) {
-            if (borderBlock.metatileId() == metatileIdA) {
-                borderBlock.setMetatileId(metatileIdB);
-            } else if (borderBlock.metatileId() == metatileIdB) {
-                borderBlock.setMetatileId(metatileIdA);
-            } else continue;
-            layout->hasUnsavedDataChanges = true;
-        }
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (changed[i]) jobs[i].layout->hasUnsavedDataChanges = true;
     }
 }
 
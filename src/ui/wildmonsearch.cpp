@@ -5,6 +5,7 @@
 enum ResultsColumn {
     Group,
     Field,
+    Species,
     Level,
     Chance,
 };
@@ -13,6 +14,12 @@ enum ResultsDataRole {
     MapName = Qt::UserRole,
 };
 
+// Partial species names list at most this many species, so that short searches (e.g. "SPECIES_") don't list every species.
+static const int maxSearchSpecies = 10;
+
+// How long to wait after the search text is edited before updating the results, so that typing doesn't search for each character.
+static const int searchDelayMs = 150;
+
 WildMonSearch::WildMonSearch(Project *project, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::WildMonSearch),
@@ -22,16 +29,20 @@ WildMonSearch::WildMonSearch(Project *project, QWidget *parent) :
     ui->setupUi(this);
 
     // Set up species combo box
-    ui->comboBox_Search->addItems(project->speciesNames);
+    ui->comboBox_Search->setConstantsModel(project->getConstantsModel(Project::Constants::Species));
     ui->comboBox_Search->setCurrentText(QString());
     ui->comboBox_Search->lineEdit()->setPlaceholderText(Project::getEmptySpeciesName());
-    connect(ui->comboBox_Search, &QComboBox::currentTextChanged, this, &WildMonSearch::updateResults);
+    this->searchTimer.setSingleShot(true);
+    this->searchTimer.setInterval(searchDelayMs);
+    connect(&this->searchTimer, &QTimer::timeout, this, [this] { updateResults(ui->comboBox_Search->currentText()); });
+    connect(ui->comboBox_Search, &QComboBox::currentTextChanged, this, [this] { this->searchTimer.start(); });
 
     // Set up table header
-    static const QStringList labels = {"Group", "Field", "Level", "Chance"};
+    static const QStringList labels = {"Group", "Field", "Species", "Level", "Chance"};
     ui->table_Results->setHorizontalHeaderLabels(labels);
     ui->table_Results->horizontalHeader()->setSectionResizeMode(ResultsColumn::Group,  QHeaderView::Stretch);
     ui->table_Results->horizontalHeader()->setSectionResizeMode(ResultsColumn::Field,  QHeaderView::ResizeToContents);
+    ui->table_Results->horizontalHeader()->setSectionResizeMode(ResultsColumn::Species, QHeaderView::ResizeToContents);
     ui->table_Results->horizontalHeader()->setSectionResizeMode(ResultsColumn::Level,  QHeaderView::ResizeToContents);
     ui->table_Results->horizontalHeader()->setSectionResizeMode(ResultsColumn::Chance, QHeaderView::ResizeToContents);
 
@@ -49,7 +60,6 @@ WildMonSearch::~WildMonSearch() {
 }
 
 void WildMonSearch::refresh() {
-    this->resultsCache.clear();
     updatePercentageStrings();
     updateResults(ui->comboBox_Search->currentText());
 }
@@ -63,37 +73,25 @@ void WildMonSearch::addTableEntry(const RowData &rowData) {
 
     ui->table_Results->setItem(row, ResultsColumn::Group, groupItem);
     ui->table_Results->setItem(row, ResultsColumn::Field, new NumericSortTableItem(rowData.fieldName));
+    ui->table_Results->setItem(row, ResultsColumn::Species, new NumericSortTableItem(rowData.species));
     ui->table_Results->setItem(row, ResultsColumn::Level, new NumericSortTableItem(rowData.levelRange));
     ui->table_Results->setItem(row, ResultsColumn::Chance, new NumericSortTableItem(rowData.chance));
 }
 
 QList<WildMonSearch::RowData> WildMonSearch::search(const QString &species) const {
     QList<RowData> results;
-    for (const auto &keyPair : this->project->wildMonData) {
-        QString mapConstant = keyPair.first;
-        for (const auto &grouplLabelPair : this->project->wildMonData[mapConstant]) {
-            QString groupName = grouplLabelPair.first;
-            WildPokemonHeader encounterHeader = this->project->wildMonData[mapConstant][groupName];
-            for (const auto &fieldNamePair : encounterHeader.wildMons) {
-                QString fieldName = fieldNamePair.first;
-                WildMonInfo monInfo = encounterHeader.wildMons[fieldName];
-                for (int slot = 0; slot < monInfo.wildPokemon.length(); slot++) {
-                    const WildPokemon wildMon = monInfo.wildPokemon.at(slot);
-                    if (wildMon.species == species) {
-                        RowData rowData;
-                        rowData.groupName = groupName;
-                        rowData.fieldName = fieldName;
-                        rowData.mapName = this->project->mapConstantsToMapNames.value(mapConstant, mapConstant);
-
-                        // If min and max level are the same display a single number, otherwise display a level range.
-                        rowData.levelRange = (wildMon.minLevel == wildMon.maxLevel) ? QString::number(wildMon.minLevel)
-                                                                                    : QString("%1-%2").arg(wildMon.minLevel).arg(wildMon.maxLevel);
-                        rowData.chance = this->percentageStrings[fieldName][slot];
-                        results.append(rowData);
-                    }
-                }
-            }
-        }
+    for (const auto &entry : this->project->wildMonIndex.find(species)) {
+        RowData rowData;
+        rowData.groupName = entry.groupName;
+        rowData.fieldName = entry.fieldName;
+        rowData.species = species;
+        rowData.mapName = this->project->mapConstantsToMapNames.value(entry.mapConstant, entry.mapConstant);
+
+        // If min and max level are the same display a single number, otherwise display a level range.
+        rowData.levelRange = (entry.minLevel == entry.maxLevel) ? QString::number(entry.minLevel)
+                                                                : QString("%1-%2").arg(entry.minLevel).arg(entry.maxLevel);
+        rowData.chance = this->percentageStrings.value(entry.fieldName).value(entry.slot);
+        results.append(rowData);
     }
     return results;
 }
@@ -110,30 +108,48 @@ void WildMonSearch::updatePercentageStrings() {
     }
 }
 
-void WildMonSearch::updateResults(const QString &species) {
-    ui->speciesIcon->setPixmap(this->project->getSpeciesIcon(species));
+void WildMonSearch::updateResults(const QString &text) {
+    this->searchTimer.stop();
+    ui->speciesIcon->setPixmap(this->project->getSpeciesIcon(text));
 
     ui->table_Results->clearContents();
     ui->table_Results->setRowCount(0);
 
+    if (text.isEmpty())
+        return;
+
     // Note: Per Qt docs, sorting should be disabled while populating the table to avoid it interfering with insertion order.
     ui->table_Results->setSortingEnabled(false);
 
-    if (ui->comboBox_Search->findText(species) < 0)
-        return; // Not a species name, no need to search wild encounter data.
+    // A complete species name only lists that species. Otherwise we list the species that start with the text,
+    // so that the results update as the user types.
+    QStringList speciesNames;
+    const bool isSpeciesName = ui->comboBox_Search->findText(text) >= 0;
+    if (isSpeciesName) {
+        speciesNames.append(text);
+    } else {
+        speciesNames = this->project->wildMonIndex.findSpecies(text, maxSearchSpecies + 1);
+    }
+    ui->table_Results->setColumnHidden(ResultsColumn::Species, isSpeciesName);
 
-    auto it = this->resultsCache.constFind(species);
-    bool inCache = (it != this->resultsCache.constEnd());
-    const QList<RowData> results = inCache ? it.value() : search(species);
+    QList<RowData> results;
+    if (speciesNames.length() <= maxSearchSpecies) {
+        for (const auto &species : speciesNames) {
+            results.append(search(species));
+        }
+    }
 
     if (results.isEmpty()) {
-        static const RowData noResults = {
+        RowData noResults = {
             .mapName = "",
             .groupName = QStringLiteral("Species not found."),
             .fieldName = QStringLiteral("--"),
+            .species = QStringLiteral("--"),
             .levelRange = QStringLiteral("--"),
             .chance = QStringLiteral("--"),
         };
+        if (speciesNames.length() > maxSearchSpecies)
+            noResults.groupName = QString("More than %1 species match, keep typing to narrow the search.").arg(maxSearchSpecies);
         addTableEntry(noResults);
     } else {
         for (const auto &entry : results) {
@@ -142,8 +158,6 @@ void WildMonSearch::updateResults(const QString &species) {
     }
 
     ui->table_Results->setSortingEnabled(true);
-
-    if (!inCache) this->resultsCache.insert(species, results);
 }
 
 // Double-clicking row data opens the corresponding map/table on the Wild Pokémon tab.